@@ -0,0 +1,9 @@
+#ifndef SIM_AGGREGATE_H
+#define SIM_AGGREGATE_H
+
+// lora_aggregate between two nodes: 40 small records with a 500 ms budget
+// packed into frames, split again on the receiver, and a truncated frame.
+// Returns the number of failed checks.
+int sim_aggregate_run(void);
+
+#endif // SIM_AGGREGATE_H
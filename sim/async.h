@@ -0,0 +1,18 @@
+#ifndef SIM_ASYNC_H
+#define SIM_ASYNC_H
+
+// lora_async.hpp against a fake radio: two interleaved flows, then a lost
+// TX done and a lost CAD done that must resume within their deadlines.
+// Returns the number of failed checks.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int sim_async_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_ASYNC_H
@@ -0,0 +1,406 @@
+// pico-lora-bridge: decode the binary gateway stream from lora_bridge and
+// benchmark its sustained frame rate, either over a local loopback or
+// against a device echoing commands.
+
+#include "lora_bridge.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define READ_CHUNK 4096
+
+// Decoded message handler; message includes the type but not the CRC
+typedef void (*message_fn)(void *user, const uint8_t *message, size_t length);
+
+// Stream decoder: collects bytes up to each delimiter
+typedef struct {
+    uint8_t frame[LORA_BRIDGE_MAX_ENCODED];
+    size_t length;
+    bool discard;
+    uint64_t messages;
+    uint64_t bad_frames;
+    uint64_t bytes;
+} decoder_t;
+
+// Gateway output written straight to a socket
+typedef struct {
+    print_ctx_t print;          // First, so the context casts back to the sink
+    int fd;
+} socket_sink_t;
+
+typedef struct {
+    uint64_t rx;
+    uint64_t tx_done;
+    uint64_t echo;
+    uint64_t echo_bytes;
+    bool print;
+} tally_t;
+
+// Forward declarations of static functions
+static void usage(const char *program);
+static int run_decode(int argc, char **argv);
+static int run_bench(int argc, char **argv);
+static int bench_loopback(uint32_t frames, uint8_t payload);
+static int bench_device(const char *device, uint32_t frames, uint8_t payload, uint32_t window);
+static int open_port(const char *path);
+static void decoder_feed(decoder_t *d, const uint8_t *data, size_t length, message_fn fn, void *user);
+static void tally_message(void *user, const uint8_t *message, size_t length);
+static size_t encode_message(uint8_t *message, size_t length, uint8_t *out);
+static size_t socket_write_byte(print_ctx_t *ctx, uint8_t b);
+static size_t socket_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size);
+static bool write_all(int fd, const uint8_t *data, size_t length);
+static double now_s(void);
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "decode") == 0) {
+        return run_decode(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        return run_bench(argc, argv);
+    }
+    usage(argv[0]);
+    return 2;
+}
+
+// Private functions
+static void usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s decode [DEVICE|-]\n"
+            "       %s bench [--device DEVICE] [--frames N] [--payload BYTES] [--window N]\n"
+            "  decode             print each message from a serial port, file or stdin\n"
+            "  bench              loopback rate of the framing, or echo rate of a device\n"
+            "  --device DEVICE    serial port of a gateway running lora_bridge\n"
+            "  --frames N         messages to pass\n"
+            "  --payload BYTES    payload per message (1-255)\n"
+            "  --window N         echo commands in flight\n",
+            program, program);
+}
+
+static int run_decode(int argc, char **argv) {
+    const char *path = argc > 2 ? argv[2] : "-";
+    int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open_port(path);
+    decoder_t decoder = {0};
+    tally_t tally = { .print = true };
+    uint8_t buffer[READ_CHUNK];
+
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    double start = now_s();
+    for (;;) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        decoder_feed(&decoder, buffer, (size_t)n, tally_message, &tally);
+    }
+    double elapsed = now_s() - start;
+
+    fprintf(stderr, "%llu messages (%llu rx, %llu tx done), %llu bad frames, %llu bytes, %.0f messages/s\n",
+            (unsigned long long)decoder.messages, (unsigned long long)tally.rx,
+            (unsigned long long)tally.tx_done, (unsigned long long)decoder.bad_frames,
+            (unsigned long long)decoder.bytes, elapsed > 0 ? decoder.messages / elapsed : 0.0);
+    return 0;
+}
+
+static int run_bench(int argc, char **argv) {
+    const char *device = NULL;
+    uint32_t frames = 200000;
+    int payload = 32;
+    uint32_t window = 16;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--device") == 0) {
+            device = argv[i + 1];
+        } else if (strcmp(argv[i], "--frames") == 0) {
+            frames = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        } else if (strcmp(argv[i], "--payload") == 0) {
+            payload = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--window") == 0) {
+            window = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc % 2 != 0 || payload < 1 || payload > MAX_PKT_LENGTH || frames == 0 || window == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (device) {
+        return bench_device(device, frames, (uint8_t)payload, window);
+    }
+    return bench_loopback(frames, (uint8_t)payload);
+}
+
+// A child process produces RX messages through lora_bridge_send and
+// lora_bridge_flush, batched exactly as on the gateway; the parent decodes
+// and checks every one
+static int bench_loopback(uint32_t frames, uint8_t payload) {
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        perror("socketpair");
+        return 1;
+    }
+
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (child == 0) {
+        static lora_bridge_t bridge;
+        socket_sink_t sink = {
+            .print = { .write_byte = socket_write_byte, .write_buffer = socket_write_buffer },
+            .fd = fds[1],
+        };
+        uint8_t body[LORA_BRIDGE_RX_HEADER + MAX_PKT_LENGTH];
+
+        // Only the output path runs, so no radio is attached
+        close(fds[0]);
+        lora_bridge_init(&bridge, NULL, &sink.print);
+        for (uint32_t i = 0; i < frames; i++) {
+            memcpy(&body[0], &i, sizeof(i));
+            memset(&body[4], 0, LORA_BRIDGE_RX_HEADER - 4);
+            for (uint8_t j = 0; j < payload; j++) {
+                body[LORA_BRIDGE_RX_HEADER + j] = (uint8_t)(i + j);
+            }
+            lora_bridge_send(&bridge, LORA_BRIDGE_MSG_RX, body, LORA_BRIDGE_RX_HEADER + payload);
+        }
+        lora_bridge_flush(&bridge);
+        close(fds[1]);
+        _exit(bridge.stats.bytes_dropped == 0 ? 0 : 1);
+    }
+
+    close(fds[1]);
+    decoder_t decoder = {0};
+    tally_t tally = {0};
+    uint8_t buffer[READ_CHUNK];
+
+    double start = now_s();
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) {
+        decoder_feed(&decoder, buffer, (size_t)n, tally_message, &tally);
+    }
+    double elapsed = now_s() - start;
+    close(fds[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    bool sent_all = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    // Equivalent text line: hex payload plus the metadata as decimal fields
+    size_t text = strlen("rx t=4294967295 rssi=-120 snr=-20.00 ferr=-12345 len=255 \r\n") + 2 * payload;
+
+    printf("loopback %llu/%lu frames, %u byte payload, %llu bad\n", (unsigned long long)tally.rx,
+           (unsigned long)frames, payload, (unsigned long long)decoder.bad_frames);
+    printf("%.0f frames/s, %.1f MB/s, %.1f wire bytes per frame (text would be ~%zu)\n",
+           elapsed > 0 ? tally.rx / elapsed : 0.0, elapsed > 0 ? decoder.bytes / elapsed / 1e6 : 0.0,
+           tally.rx ? (double)decoder.bytes / tally.rx : 0.0, text);
+    return sent_all && tally.rx == frames && decoder.bad_frames == 0 ? 0 : 1;
+}
+
+// Keep window echo commands in flight and count the replies
+static int bench_device(const char *device, uint32_t frames, uint8_t payload, uint32_t window) {
+    int fd = open_port(device);
+    decoder_t decoder = {0};
+    tally_t tally = {0};
+    uint8_t message[LORA_BRIDGE_MAX_MESSAGE];
+    uint8_t encoded[LORA_BRIDGE_MAX_ENCODED];
+    uint8_t buffer[READ_CHUNK];
+    uint32_t sent = 0;
+
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", device, strerror(errno));
+        return 1;
+    }
+
+    double start = now_s();
+    while (tally.echo < frames) {
+        while (sent < frames && sent - tally.echo < window) {
+            message[0] = LORA_BRIDGE_CMD_ECHO;
+            for (uint8_t j = 0; j < payload; j++) {
+                message[1 + j] = (uint8_t)(sent + j);
+            }
+            size_t n = encode_message(message, 1 + payload, encoded);
+            if (!write_all(fd, encoded, n)) {
+                perror("write");
+                return 1;
+            }
+            sent++;
+        }
+
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+        if (poll(&p, 1, 1000) <= 0) {
+            fprintf(stderr, "no reply after %llu echoes\n", (unsigned long long)tally.echo);
+            break;
+        }
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        decoder_feed(&decoder, buffer, (size_t)n, tally_message, &tally);
+    }
+    double elapsed = now_s() - start;
+    close(fd);
+
+    printf("device %s: %llu/%lu echoes, %u byte payload, window %lu, %llu bad\n", device,
+           (unsigned long long)tally.echo, (unsigned long)frames, payload, (unsigned long)window,
+           (unsigned long long)decoder.bad_frames);
+    printf("%.0f frames/s, %.1f kB/s payload each way\n", elapsed > 0 ? tally.echo / elapsed : 0.0,
+           elapsed > 0 ? tally.echo_bytes / elapsed / 1e3 : 0.0);
+    return tally.echo == frames && decoder.bad_frames == 0 ? 0 : 1;
+}
+
+// Serial ports are put in raw mode; anything else is read as is
+static int open_port(const char *path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0 || !isatty(fd)) {
+        return fd;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B921600);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIOFLUSH);
+    }
+    return fd;
+}
+
+static void decoder_feed(decoder_t *d, const uint8_t *data, size_t length, message_fn fn, void *user) {
+    d->bytes += length;
+
+    for (size_t i = 0; i < length; i++) {
+        uint8_t b = data[i];
+
+        if (b != LORA_WIRE_DELIMITER) {
+            if (d->length == sizeof(d->frame)) {
+                d->discard = true;
+            } else if (!d->discard) {
+                d->frame[d->length++] = b;
+            }
+            continue;
+        }
+
+        if (d->discard) {
+            d->bad_frames++;
+        } else if (d->length > 0) {
+            int n = lora_wire_decode(d->frame, d->length, d->frame);
+            if (n < LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_CRC_SIZE) {
+                d->bad_frames++;
+            } else {
+                size_t m = (size_t)n - LORA_BRIDGE_CRC_SIZE;
+                uint16_t crc = (uint16_t)(d->frame[m] | (d->frame[m + 1] << 8));
+                if (crc != lora_wire_crc16(d->frame, m)) {
+                    d->bad_frames++;
+                } else {
+                    d->messages++;
+                    fn(user, d->frame, m);
+                }
+            }
+        }
+        d->length = 0;
+        d->discard = false;
+    }
+}
+
+static void tally_message(void *user, const uint8_t *m, size_t length) {
+    tally_t *t = user;
+
+    switch (m[0]) {
+        case LORA_BRIDGE_MSG_RX:
+            if (length < LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_RX_HEADER) {
+                return;
+            }
+            t->rx++;
+            if (t->print) {
+                uint32_t timestamp = m[1] | m[2] << 8 | m[3] << 16 | (uint32_t)m[4] << 24;
+                int16_t rssi = (int16_t)(m[5] | m[6] << 8);
+                int32_t ferr = (int32_t)(m[8] | m[9] << 8 | m[10] << 16 | (uint32_t)m[11] << 24);
+                size_t n = length - LORA_BRIDGE_TYPE_SIZE - LORA_BRIDGE_RX_HEADER;
+                printf("rx t=%lu rssi=%d snr=%.2f ferr=%ld len=%zu ", (unsigned long)timestamp, rssi,
+                       (int8_t)m[7] / 4.0, (long)ferr, n);
+                for (size_t i = 0; i < n; i++) {
+                    printf("%02x", m[LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_RX_HEADER + i]);
+                }
+                printf("\n");
+            }
+            break;
+        case LORA_BRIDGE_MSG_TX_DONE:
+            t->tx_done++;
+            if (t->print && length >= 3) {
+                printf("tx tag=%u status=%u\n", m[1], m[2]);
+            }
+            break;
+        case LORA_BRIDGE_MSG_ECHO:
+            t->echo++;
+            t->echo_bytes += length - LORA_BRIDGE_TYPE_SIZE;
+            if (t->print) {
+                printf("echo len=%zu\n", length - LORA_BRIDGE_TYPE_SIZE);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Append the CRC, COBS encode and delimit; message needs room for the CRC
+static size_t encode_message(uint8_t *message, size_t length, uint8_t *out) {
+    uint16_t crc = lora_wire_crc16(message, length);
+    message[length] = (uint8_t)crc;
+    message[length + 1] = (uint8_t)(crc >> 8);
+
+    size_t n = lora_wire_encode(message, length + LORA_BRIDGE_CRC_SIZE, out);
+    out[n++] = LORA_WIRE_DELIMITER;
+    return n;
+}
+
+static size_t socket_write_byte(print_ctx_t *ctx, uint8_t b) {
+    return socket_write_buffer(ctx, &b, 1);
+}
+
+static size_t socket_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size) {
+    socket_sink_t *sink = (socket_sink_t *)ctx;
+
+    if (!write_all(sink->fd, buffer, size)) {
+        ctx->write_error = 1;
+        return 0;
+    }
+    return size;
+}
+
+static bool write_all(int fd, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,195 @@
+// Shared radio channel: on-air frame table, log-distance path loss with
+// static per-link shadowing, thermal noise and LoRa demodulation limits.
+
+#include "sim.h"
+#include <math.h>
+#include <string.h>
+
+sim_channel_stats_t sim_channel_stats;
+
+static sim_tx_t transmissions[SIM_MAX_TRANSMISSIONS];
+static int next_slot;
+static sim_channel_config_t channel_config;
+
+// Demodulator SNR floor per spreading factor (SX1276 datasheet Table 13)
+static const double snr_limit_db[13] = { 0, 0, 0, 0, 0, 0, -5.0, -7.5, -10.0, -12.5, -15.0, -17.5, -20.0 };
+
+// Forward declarations of static functions
+static double link_shadowing_db(int a, int b);
+static uint32_t symbol_us(uint8_t sf, uint8_t bw);
+
+void sim_channel_init(const sim_channel_config_t *config) {
+    channel_config = *config;
+    memset(transmissions, 0, sizeof(transmissions));
+    memset(&sim_channel_stats, 0, sizeof(sim_channel_stats));
+    next_slot = 0;
+}
+
+// Put the node's pending frame on air; reuses the oldest slot not on air
+int sim_channel_start_tx(sim_node_t *node, uint32_t airtime_us) {
+    sim_radio_t *radio = &node->radio;
+    int tx = -1;
+
+    for (int i = 0; i < SIM_MAX_TRANSMISSIONS; i++) {
+        int slot = (next_slot + i) % SIM_MAX_TRANSMISSIONS;
+        if (!transmissions[slot].on_air) {
+            tx = slot;
+            break;
+        }
+    }
+    if (tx < 0) {
+        return -1;
+    }
+    next_slot = (tx + 1) % SIM_MAX_TRANSMISSIONS;
+
+    bool implicit_header;
+    lora_config_t config = sim_radio_config(radio, &implicit_header);
+    sim_tx_t *frame = &transmissions[tx];
+
+    memset(frame, 0, sizeof(*frame));
+    frame->used = true;
+    frame->on_air = true;
+    frame->node = node->id;
+    frame->start_us = sim_now_us();
+    frame->end_us = frame->start_us + airtime_us;
+    frame->frf = sim_radio_frf(radio);
+    frame->sf = config.spreading_factor;
+    frame->bw = config.signal_bandwidth;
+    frame->sync_word = config.sync_word;
+    frame->power_dbm = sim_radio_power_dbm(radio);
+    frame->crc = config.crc_enabled;
+    frame->length = radio->regs[REG_PAYLOAD_LENGTH];
+    frame->preamble_end_us = frame->start_us + (symbol_us(frame->sf, frame->bw) * (4 * config.preamble_length + 17)) / 4;
+    for (int i = 0; i < frame->length; i++) {
+        frame->payload[i] = radio->fifo[(uint8_t)(radio->regs[REG_FIFO_TX_BASE_ADDR] + i)];
+    }
+
+    for (int i = 0; i < SIM_MAX_TRANSMISSIONS; i++) {
+        sim_tx_t *other = &transmissions[i];
+        if (i != tx && other->on_air && other->frf == frame->frf && other->sf == frame->sf && other->bw == frame->bw) {
+            other->collided = true;
+            frame->collided = true;
+        }
+    }
+
+    sim_channel_stats.transmissions++;
+    sim_channel_stats.airtime_us += airtime_us;
+
+    for (int i = 0; i < sim_node_count; i++) {
+        if (i != node->id) {
+            sim_radio_on_air_start(&sim_nodes[i], tx);
+        }
+    }
+
+    return tx;
+}
+
+// Take a frame off air, either complete or cut short by its sender
+void sim_channel_end_tx(int tx) {
+    if (tx < 0 || tx >= SIM_MAX_TRANSMISSIONS || !transmissions[tx].on_air) {
+        return;
+    }
+
+    sim_tx_t *frame = &transmissions[tx];
+    frame->on_air = false;
+    if (sim_now_us() < frame->end_us) {
+        // Cut short: receivers locked on it will fail
+        frame->truncated = true;
+        frame->end_us = sim_now_us();
+    }
+    if (frame->collided) {
+        sim_channel_stats.collided++;
+    }
+
+    for (int i = 0; i < sim_node_count; i++) {
+        if (i != frame->node) {
+            sim_radio_on_air_end(&sim_nodes[i], tx);
+        }
+    }
+}
+
+sim_tx_t *sim_channel_tx(int tx) {
+    return &transmissions[tx];
+}
+
+double sim_channel_rx_power_dbm(int tx, const sim_node_t *receiver) {
+    const sim_tx_t *frame = &transmissions[tx];
+    const sim_node_t *sender = &sim_nodes[frame->node];
+    double distance = hypot(sender->x - receiver->x, sender->y - receiver->y);
+
+    if (distance < 1.0) {
+        distance = 1.0;
+    }
+
+    double loss = SIM_PATH_LOSS_D0_DB + 10.0 * channel_config.path_loss_exponent * log10(distance) +
+                  link_shadowing_db(sender->id, receiver->id);
+    return frame->power_dbm - loss;
+}
+
+// Thermal noise over the channel bandwidth plus the receiver noise figure
+double sim_channel_noise_dbm(uint8_t bw) {
+    long bandwidth = lora_bandwidth_hz(bw);
+
+    return -174.0 + 10.0 * log10(bandwidth ? bandwidth : 125000) + SIM_NOISE_FIGURE_DB;
+}
+
+double sim_channel_snr_limit_db(uint8_t sf) {
+    return sf < 13 ? snr_limit_db[sf] : 0;
+}
+
+// Frequencies within 1 kHz, same spreading factor and bandwidth
+bool sim_channel_same_channel(const sim_tx_t *tx, const sim_radio_t *radio) {
+    int32_t delta = (int32_t)tx->frf - (int32_t)sim_radio_frf(radio);
+
+    return delta > -16 && delta < 16 &&
+           tx->sf == (radio->regs[REG_MODEM_CONFIG_2] >> 4) &&
+           tx->bw == (radio->regs[REG_MODEM_CONFIG_1] >> 4);
+}
+
+double sim_channel_interference_mw(const sim_node_t *receiver, int exclude_tx) {
+    double total = 0;
+
+    for (int i = 0; i < SIM_MAX_TRANSMISSIONS; i++) {
+        sim_tx_t *frame = &transmissions[i];
+        if (i == exclude_tx || !frame->on_air || frame->node == receiver->id ||
+            !sim_channel_same_channel(frame, &receiver->radio)) {
+            continue;
+        }
+        total += sim_dbm_to_mw(sim_channel_rx_power_dbm(i, receiver));
+    }
+
+    return total;
+}
+
+double sim_dbm_to_mw(double dbm) {
+    return pow(10.0, dbm / 10.0);
+}
+
+double sim_mw_to_dbm(double mw) {
+    return mw > 0 ? 10.0 * log10(mw) : -200.0;
+}
+
+// Private functions
+
+// Deterministic gaussian per unordered node pair, so links are symmetric and repeatable
+static double link_shadowing_db(int a, int b) {
+    if (channel_config.shadowing_db <= 0) {
+        return 0;
+    }
+
+    uint64_t key = ((uint64_t)(a < b ? a : b) << 32) | (uint32_t)(a < b ? b : a);
+    key ^= (uint64_t)channel_config.seed * 0x9e3779b97f4a7c15ULL;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+
+    double u1 = ((key >> 32) + 0.5) / 4294967296.0;
+    double u2 = ((key & 0xffffffff) + 0.5) / 4294967296.0;
+    return channel_config.shadowing_db * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static uint32_t symbol_us(uint8_t sf, uint8_t bw) {
+    long bandwidth = lora_bandwidth_hz(bw);
+
+    return bandwidth ? (uint32_t)(((uint64_t)1000000 << sf) / bandwidth) : 1000;
+}
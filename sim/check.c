@@ -0,0 +1,37 @@
+#include "check.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+int sim_check(const char *name, bool pass, const char *format, ...) {
+    printf("%-20s %s ", name, pass ? "PASS" : "FAIL");
+    if (format) {
+        va_list args;
+
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+    }
+    printf("\n");
+    return pass ? 0 : 1;
+}
+
+sim_node_t *sim_check_setup(uint32_t seed, int count, bool crc) {
+    sim_channel_config_t channel = { .path_loss_exponent = 2.7, .seed = seed };
+
+    sim_init(&channel);
+    for (int i = 0; i < count; i++) {
+        sim_node_t *node = sim_add_node(i * SIM_CHECK_SPACING_M, 0, 0);
+
+        if (!node) {
+            return NULL;
+        }
+        sim_select(node);
+        if (!lora_begin(&node->lora, SIM_FREQUENCY)) {
+            return NULL;
+        }
+        if (crc) {
+            lora_enable_crc(&node->lora);
+        }
+    }
+    return &sim_nodes[0];
+}
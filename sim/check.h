@@ -0,0 +1,30 @@
+#ifndef SIM_CHECK_H
+#define SIM_CHECK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+// Shared by the check harnesses (crypto, recovery, sweep, ...)
+
+// Spacing of the nodes sim_check_setup places on a line
+#define SIM_CHECK_SPACING_M     100
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Print one "name PASS/FAIL detail" line; detail is a printf format, or
+// NULL for none. Returns 1 on failure so results can be summed.
+int sim_check(const char *name, bool pass, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+// Fresh channel (path loss exponent 2.7) with count nodes on a line, each
+// radio started on SIM_FREQUENCY, CRC on if crc. Returns the first node,
+// or NULL if a radio does not start.
+sim_node_t *sim_check_setup(uint32_t seed, int count, bool crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_CHECK_H
@@ -0,0 +1,244 @@
+// Crypto harness: the RFC 3610 vector pins the CCM construction, the rest
+// checks that every tampered or replayed frame is rejected and wiped, and
+// that a filtered receive authenticates the header the filter consumed.
+
+#include "crypto.h"
+#include "check.h"
+#include "lora_crypto.h"
+#include "lora_filter.h"
+#include <string.h>
+
+#define AIR_TIMEOUT_US          2000000
+#define REBOOT_FRAMES           4
+
+// Forward declarations of static functions
+static bool wiped(const uint8_t *data, size_t length);
+static void vector_session(lora_crypto_t *crypto);
+static size_t vector_seal(lora_crypto_t *crypto, uint8_t *frame);
+static int reboot(void);
+static int over_the_air(void);
+static int receive_filtered(sim_node_t *node, lora_filter_t *filter, lora_crypto_t *crypto, uint8_t *frame);
+
+// RFC 3610 packet vector #1: nonce 00000003020100a0a1a2a3a4a5, 8 bytes of
+// associated data, 23 bytes of payload, 8-byte tag. Our nonce is salt,
+// sender address and counter, so salt 00000003020100a0, address a1 and
+// counter a2a3a4a5 reproduce it.
+static const uint8_t vector_key[16] = {
+    0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf
+};
+static const uint8_t vector_salt[8] = { 0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xa0 };
+static const uint8_t vector_aad[8] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+static const uint8_t vector_plain[23] = {
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13,
+    0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e
+};
+static const uint8_t vector_sealed[31] = {
+    0x58, 0x8c, 0x97, 0x9a, 0x61, 0xc6, 0x63, 0xd2, 0xf0, 0x66, 0xd0, 0xc2,
+    0xc0, 0xf9, 0x89, 0x80, 0x6d, 0x5f, 0x6b, 0x61, 0xda, 0xc3, 0x84,
+    0x17, 0xe8, 0xd1, 0x2c, 0xfd, 0xf9, 0x26, 0xe0
+};
+
+int sim_crypto_run(void) {
+    lora_crypto_t tx;
+    lora_crypto_t rx;
+    uint8_t frame[MAX_PKT_LENGTH];
+    uint8_t copy[MAX_PKT_LENGTH];
+    int failures = 0;
+
+    vector_session(&tx);
+    size_t length = vector_seal(&tx, frame);
+    const uint8_t *sealed = frame + sizeof(vector_aad) + LORA_CRYPTO_HEADER_SIZE;
+    bool match = length == sizeof(vector_aad) + LORA_CRYPTO_HEADER_SIZE + sizeof(vector_sealed) &&
+                 memcmp(sealed, vector_sealed, sizeof(vector_sealed)) == 0;
+    failures += sim_check("rfc3610 vector 1", match, NULL);
+
+    vector_session(&rx);
+    memcpy(copy, frame, length);
+    int n = lora_crypto_open(&rx, copy, sizeof(vector_aad), length);
+    failures += sim_check("open", n == sizeof(vector_plain) &&
+                          memcmp(copy + sizeof(vector_aad) + LORA_CRYPTO_HEADER_SIZE, vector_plain, n) == 0, NULL);
+
+    // Flip one bit in each region in turn: associated data, sender
+    // address, counter, payload, tag
+    static const size_t flips[] = { 0, 8, 12, 20, 40 };
+    int rejected = 0;
+    for (size_t i = 0; i < sizeof(flips) / sizeof(flips[0]); i++) {
+        vector_session(&rx);
+        memcpy(copy, frame, length);
+        copy[flips[i]] ^= 0x01;
+        n = lora_crypto_open(&rx, copy, sizeof(vector_aad), length);
+        if (n == LORA_CRYPTO_AUTH_FAILED && wiped(copy + sizeof(vector_aad) + LORA_CRYPTO_HEADER_SIZE,
+                                                   sizeof(vector_plain))) {
+            rejected++;
+        }
+    }
+    failures += sim_check("tamper", rejected == 5, "%d/5 rejected and wiped", rejected);
+
+    memcpy(copy, frame, length);
+    n = lora_crypto_open(&rx, copy, sizeof(vector_aad), length - 1);
+    failures += sim_check("truncated", n == LORA_CRYPTO_AUTH_FAILED, NULL);
+
+    // The same frame twice, then an older counter, then a newer one
+    vector_session(&rx);
+    memcpy(copy, frame, length);
+    bool first = lora_crypto_open(&rx, copy, sizeof(vector_aad), length) == sizeof(vector_plain);
+    memcpy(copy, frame, length);
+    n = lora_crypto_open(&rx, copy, sizeof(vector_aad), length);
+    failures += sim_check("replay", first && n == LORA_CRYPTO_REPLAYED && rx.replays == 1 &&
+                          wiped(copy + sizeof(vector_aad) + LORA_CRYPTO_HEADER_SIZE, sizeof(vector_plain)), NULL);
+
+    tx.tx_counter = 0xa2a3a4a4;
+    length = vector_seal(&tx, copy);
+    n = lora_crypto_open(&rx, copy, sizeof(vector_aad), length);
+    failures += sim_check("older counter", n == LORA_CRYPTO_REPLAYED, NULL);
+    tx.tx_counter = 0xa2a3a4a6;
+    length = vector_seal(&tx, copy);
+    n = lora_crypto_open(&rx, copy, sizeof(vector_aad), length);
+    failures += sim_check("newer counter", n == sizeof(vector_plain), NULL);
+
+    failures += reboot();
+    failures += over_the_air();
+    return failures;
+}
+
+// Private functions
+static bool wiped(const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void vector_session(lora_crypto_t *crypto) {
+    lora_crypto_init(crypto, vector_key, vector_salt, 0xa1, 0xa2a3a4a5);
+}
+
+static size_t vector_seal(lora_crypto_t *crypto, uint8_t *frame) {
+    memcpy(frame, vector_aad, sizeof(vector_aad));
+    memcpy(frame + sizeof(vector_aad) + LORA_CRYPTO_HEADER_SIZE, vector_plain, sizeof(vector_plain));
+    return lora_crypto_seal(crypto, frame, sizeof(vector_aad), sizeof(vector_plain), MAX_PKT_LENGTH);
+}
+
+// The sender restarts halfway with the counter it persisted: no nonce may
+// repeat and the receiver keeps accepting it. Restarting from 0 instead is
+// what the persisted counter prevents.
+static int reboot(void) {
+    lora_crypto_t tx;
+    lora_crypto_t rx;
+    uint8_t frame[MAX_PKT_LENGTH];
+    uint8_t nonces[2 * REBOOT_FRAMES][LORA_CRYPTO_HEADER_SIZE];
+    int accepted = 0;
+    int repeated = 0;
+    int failures = 0;
+
+    lora_crypto_init(&tx, vector_key, vector_salt, 0xa1, 0);
+    lora_crypto_init(&rx, vector_key, vector_salt, 0x02, 0);
+    for (int i = 0; i < 2 * REBOOT_FRAMES; i++) {
+        if (i == REBOOT_FRAMES) {
+            uint32_t stored = tx.tx_counter;
+            lora_crypto_end(&tx);
+            lora_crypto_init(&tx, vector_key, vector_salt, 0xa1, stored);
+        }
+        size_t length = vector_seal(&tx, frame);
+        memcpy(nonces[i], frame + sizeof(vector_aad), LORA_CRYPTO_HEADER_SIZE);
+        accepted += lora_crypto_open(&rx, frame, sizeof(vector_aad), length) == sizeof(vector_plain);
+        for (int j = 0; j < i; j++) {
+            repeated += memcmp(nonces[i], nonces[j], LORA_CRYPTO_HEADER_SIZE) == 0;
+        }
+    }
+    failures += sim_check("reboot", accepted == 2 * REBOOT_FRAMES && repeated == 0,
+                          "%d/%d accepted, %d nonces repeated", accepted, 2 * REBOOT_FRAMES, repeated);
+
+    lora_crypto_init(&tx, vector_key, vector_salt, 0xa1, 0);
+    size_t length = vector_seal(&tx, frame);
+    int n = lora_crypto_open(&rx, frame, sizeof(vector_aad), length);
+    failures += sim_check("restart from 0", n == LORA_CRYPTO_REPLAYED, NULL);
+    return failures;
+}
+
+// Filter header as associated data: the filter reads it off the FIFO, the
+// filtered receive must still authenticate it. The replay is the same raw
+// frame sent again, with duplicate suppression off so it reaches crypto.
+static int over_the_air(void) {
+    static const uint8_t message[] = "sealed over the air";
+    lora_crypto_t tx;
+    lora_crypto_t rx;
+    lora_filter_t filter;
+    uint8_t frame[MAX_PKT_LENGTH];
+    uint8_t sent[MAX_PKT_LENGTH];
+    uint8_t retry[MAX_PKT_LENGTH];
+    int failures = 0;
+
+    sim_node_t *sender = sim_check_setup(1, 2, true);
+    if (!sender) {
+        return 1;
+    }
+    sim_node_t *receiver = &sim_nodes[1];
+
+    lora_crypto_init(&tx, vector_key, vector_salt, 0x01, 0);
+    lora_crypto_init(&rx, vector_key, vector_salt, 0x02, 0);
+    lora_filter_init(&filter, 0x02);
+    filter.dedup = false;
+
+    frame[0] = 0x02;
+    frame[1] = 0x01;
+    frame[2] = 0x07;
+    memcpy(frame + LORA_FILTER_HEADER_LENGTH + LORA_CRYPTO_HEADER_SIZE, message, sizeof(message));
+    size_t length = lora_crypto_seal(&tx, frame, LORA_FILTER_HEADER_LENGTH, sizeof(message), sizeof(frame));
+    memcpy(sent, frame, length);
+
+    bool delivered[2];
+    int results[2];
+    for (int i = 0; i < 2; i++) {
+        sim_select(sender);
+        lora_begin_packet(&sender->lora, false);
+        lora_write(&sender->lora, sent, length);
+        lora_end_packet(&sender->lora, true);
+        results[i] = receive_filtered(receiver, &filter, &rx, frame);
+        delivered[i] = memcmp(frame + LORA_FILTER_HEADER_LENGTH + LORA_CRYPTO_HEADER_SIZE, message,
+                              sizeof(message)) == 0;
+    }
+
+    failures += sim_check("filtered receive", results[0] == (int)sizeof(message) && delivered[0], NULL);
+    failures += sim_check("replay over the air", results[1] == LORA_CRYPTO_REPLAYED && !delivered[1], NULL);
+
+    // A send while the radio is still transmitting must leave the plaintext
+    // and the counter alone, so the retry goes out sealed once
+    uint8_t *plain = retry + LORA_FILTER_HEADER_LENGTH + LORA_CRYPTO_HEADER_SIZE;
+    uint32_t counter = tx.tx_counter;
+    memcpy(retry, sent, LORA_FILTER_HEADER_LENGTH);
+    memcpy(plain, message, sizeof(message));
+    sim_select(sender);
+    lora_begin_packet(&sender->lora, false);
+    lora_write(&sender->lora, sent, length);
+    lora_end_packet(&sender->lora, true);
+    bool busy = !lora_crypto_send(&tx, &sender->lora, retry, LORA_FILTER_HEADER_LENGTH, sizeof(message),
+                                  sizeof(retry), true);
+    bool kept = tx.tx_counter == counter && memcmp(plain, message, sizeof(message)) == 0;
+    receive_filtered(receiver, &filter, &rx, frame);
+
+    sim_select(sender);
+    bool resent = lora_crypto_send(&tx, &sender->lora, retry, LORA_FILTER_HEADER_LENGTH, sizeof(message),
+                                   sizeof(retry), true);
+    int result = receive_filtered(receiver, &filter, &rx, frame);
+    bool delivered_retry = memcmp(frame + LORA_FILTER_HEADER_LENGTH + LORA_CRYPTO_HEADER_SIZE, message,
+                                  sizeof(message)) == 0;
+    failures += sim_check("send while busy", busy && kept && resent && result == (int)sizeof(message) &&
+                          delivered_retry, NULL);
+    return failures;
+}
+
+static int receive_filtered(sim_node_t *node, lora_filter_t *filter, lora_crypto_t *crypto, uint8_t *frame) {
+    uint64_t deadline_us = sim_now_us() + AIR_TIMEOUT_US;
+
+    sim_select(node);
+    while (sim_now_us() < deadline_us) {
+        if (lora_parse_packet_filtered(&node->lora, 0, filter) > 0) {
+            return lora_crypto_receive_filtered(crypto, &node->lora, filter, frame, MAX_PKT_LENGTH);
+        }
+        sleep_us(1000);
+    }
+    return 0;
+}
@@ -0,0 +1,9 @@
+#ifndef SIM_CRYPTO_H
+#define SIM_CRYPTO_H
+
+// lora_crypto checks: RFC 3610 packet vector #1, tampering, replay, a
+// sender reboot that must not reuse nonces, and a sealed frame sent over
+// the air through lora_filter. Returns the number of failed checks.
+int sim_crypto_run(void);
+
+#endif // SIM_CRYPTO_H
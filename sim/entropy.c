@@ -0,0 +1,117 @@
+// Entropy pool harness: a SHA-256 known answer, then frequency, byte
+// chi-square, runs and serial correlation checks over the pool output.
+// Thresholds are at roughly p = 0.001, so a healthy pool rarely fails.
+
+#include "entropy.h"
+#include "check.h"
+#include "lora_entropy.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK                   37      // Odd size so reads straddle refills
+
+// Forward declarations of static functions
+static bool sha256_known_answer(void);
+
+int sim_entropy_run(size_t bytes, uint32_t seed, double ones) {
+    lora_entropy_t pool;
+    int failures = 0;
+
+    if (bytes < 1024) {
+        bytes = 1024;
+    }
+    uint8_t *data = malloc(bytes);
+    if (!data) {
+        return 1;
+    }
+
+    sim_wideband_ones = ones;
+    sim_node_t *node = sim_check_setup(seed, 1, false);
+    if (!node) {
+        free(data);
+        return 1;
+    }
+
+    failures += sim_check("sha256 known answer", sha256_known_answer(), NULL);
+
+    lora_entropy_init(&pool, &node->lora);
+    bool seeded = lora_entropy_seed(&pool);
+    failures += sim_check("seed", seeded, "%lu samples", (unsigned long)pool.samples);
+
+    // Keep the background refill running while the output is drawn
+    lora_write_register(&node->lora, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_CONTINUOUS);
+    for (size_t offset = 0; offset < bytes; offset += CHUNK) {
+        size_t n = bytes - offset < CHUNK ? bytes - offset : CHUNK;
+        lora_entropy_poll(&pool);
+        lora_entropy_read(&pool, data + offset, n);
+    }
+
+    printf("raw P(1) %.3f, von Neumann yield %.3f bits/sample, %lu reseeds, %lu health failures\n",
+           ones, (double)pool.debiased_bits / pool.samples,
+           (unsigned long)pool.reseeds, (unsigned long)pool.health_failures);
+
+    // Monobit frequency
+    uint64_t set = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        set += __builtin_popcount(data[i]);
+    }
+    double n_bits = 8.0 * bytes;
+    double z = fabs(2.0 * set - n_bits) / sqrt(n_bits);
+    failures += sim_check("monobit", z < 3.29, "|z| %.2f", z);
+
+    // Byte distribution, 255 degrees of freedom
+    uint32_t counts[256] = { 0 };
+    for (size_t i = 0; i < bytes; i++) {
+        counts[data[i]]++;
+    }
+    double expected = bytes / 256.0;
+    double chi2 = 0;
+    for (int i = 0; i < 256; i++) {
+        chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+    }
+    failures += sim_check("byte chi-square", chi2 < 330.5, "%.1f", chi2);
+
+    // Runs of identical bits
+    double pi = set / n_bits;
+    uint64_t runs = 1;
+    int previous = data[0] >> 7;
+    for (size_t i = 0; i < n_bits; i++) {
+        int bit = (data[i / 8] >> (7 - i % 8)) & 1;
+        if (i > 0 && bit != previous) {
+            runs++;
+        }
+        previous = bit;
+    }
+    double runs_z = fabs(runs - 2.0 * n_bits * pi * (1 - pi)) / (2.0 * sqrt(n_bits) * pi * (1 - pi));
+    failures += sim_check("runs", runs_z < 3.29, "|z| %.2f", runs_z);
+
+    // Lag-one serial correlation of bytes
+    double sum = 0, sum_sq = 0, sum_lag = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        sum += data[i];
+        sum_sq += (double)data[i] * data[i];
+        sum_lag += (double)data[i] * data[(i + 1) % bytes];
+    }
+    double correlation = (bytes * sum_lag - sum * sum) / (bytes * sum_sq - sum * sum);
+    failures += sim_check("serial correlation", fabs(correlation) < 3.29 / sqrt(bytes), "%.4f", correlation);
+
+    free(data);
+    return failures;
+}
+
+// Private functions
+static bool sha256_known_answer(void) {
+    static const uint8_t expected[32] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    };
+    lora_sha256_t sha;
+    uint8_t digest[32];
+
+    lora_sha256_init(&sha);
+    lora_sha256_update(&sha, (const uint8_t *)"abc", 3);
+    lora_sha256_final(&sha, digest);
+    return memcmp(digest, expected, sizeof(digest)) == 0;
+}
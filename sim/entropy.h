@@ -0,0 +1,11 @@
+#ifndef SIM_ENTROPY_H
+#define SIM_ENTROPY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Statistical checks of lora_entropy against the simulated radio's biased
+// wideband RSSI noise. Returns the number of failed checks.
+int sim_entropy_run(size_t bytes, uint32_t seed, double ones);
+
+#endif // SIM_ENTROPY_H
@@ -0,0 +1,143 @@
+// FSK register harness: lora_fsk against the simulated radio's FSK page,
+// checking the register values against the SX1276 datasheet formulas.
+
+#include "fsk.h"
+#include "check.h"
+#include "lora_fsk.h"
+
+// Forward declarations of static functions
+static int bandwidths(lora_fsk_t *fsk);
+static int bitrates(lora_fsk_t *fsk);
+static int time_on_air(void);
+
+int sim_fsk_run(void) {
+    lora_fsk_config_t config;
+    lora_fsk_t fsk;
+    int failures = 0;
+
+    sim_node_t *node = sim_check_setup(1, 1, false);
+    if (!node) {
+        return 1;
+    }
+    lora_ctx_t *ctx = &node->lora;
+
+    lora_fsk_default_config(&config);
+    bool started = lora_fsk_begin(&fsk, ctx, &config);
+    uint8_t op_mode = lora_read_register(ctx, REG_OP_MODE);
+    failures += sim_check("begin", started && lora_modem(ctx) == LORA_MODEM_FSK &&
+                          (op_mode & MODE_LONG_RANGE_MODE) == 0, "op mode 0x%02x", op_mode);
+
+    // 166.7 kHz in the datasheet is FXOSC / (24 * 2^3)
+    uint8_t rx_bw = lora_read_register(ctx, REG_FSK_RX_BW);
+    uint8_t afc_bw = lora_read_register(ctx, REG_FSK_AFC_BW);
+    failures += sim_check("default bandwidth", rx_bw == 0x11 && afc_bw == 0x11 &&
+                          fsk.config.rx_bandwidth_hz == 166666, "0x%02x/0x%02x, %lu Hz",
+                          rx_bw, afc_bw, (unsigned long)fsk.config.rx_bandwidth_hz);
+
+    uint8_t fdev[2];
+    lora_read_register_burst(ctx, REG_FSK_FDEV_MSB, fdev, sizeof(fdev));
+    failures += sim_check("deviation", fdev[0] == 0x03 && fdev[1] == 0x33, "0x%02x%02x", fdev[0], fdev[1]);
+
+    uint8_t packet[3];
+    lora_read_register_burst(ctx, REG_FSK_PACKET_CONFIG_1, packet, sizeof(packet));
+    failures += sim_check("variable packet", packet[0] == 0xd8 && packet[1] == 0x40 && packet[2] == 0xff,
+                          "0x%02x 0x%02x 0x%02x", packet[0], packet[1], packet[2]);
+
+    lora_fsk_set_packet_format(&fsk, false, false, 300);
+    lora_read_register_burst(ctx, REG_FSK_PACKET_CONFIG_1, packet, sizeof(packet));
+    failures += sim_check("fixed packet", packet[0] == 0x08 && packet[1] == 0x41 && packet[2] == 0x2c,
+                          "0x%02x 0x%02x 0x%02x", packet[0], packet[1], packet[2]);
+
+    failures += bandwidths(&fsk);
+    failures += bitrates(&fsk);
+    failures += time_on_air();
+
+    // The FSK page must not leak into the LoRa registers
+    lora_fsk_end(&fsk);
+    op_mode = lora_read_register(ctx, REG_OP_MODE);
+    failures += sim_check("back to lora", lora_modem(ctx) == LORA_MODEM_LORA &&
+                          (op_mode & MODE_LONG_RANGE_MODE) && lora_checkpoint_matches(ctx, &fsk.lora_checkpoint) &&
+                          lora_read_register(ctx, REG_IRQ_FLAGS) == 0, "op mode 0x%02x", op_mode);
+    return failures;
+}
+
+// Private functions
+static int bandwidths(lora_fsk_t *fsk) {
+    static const struct {
+        uint32_t requested_hz;
+        uint8_t reg;
+        uint32_t used_hz;
+    } cases[] = {
+        { 250000, 0x01, 250000 },
+        { 200000, 0x09, 200000 },
+        { 166666, 0x11, 166666 },
+        { 31300, 0x04, 31250 },     // Datasheet 31.3 kHz
+        { 10400, 0x15, 10416 },     // Datasheet 10.4 kHz
+        { 2600, 0x17, 2604 },       // Datasheet 2.6 kHz, the narrowest
+        { 170000, 0x09, 200000 },   // Rounds up
+        { 300000, 0x01, 250000 },   // Clamps to the widest
+    };
+    int passed = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint32_t used = lora_fsk_set_rx_bandwidth(fsk, cases[i].requested_hz);
+        uint8_t rx_bw = lora_read_register(fsk->lora, REG_FSK_RX_BW);
+        uint8_t afc_bw = lora_read_register(fsk->lora, REG_FSK_AFC_BW);
+        if (used == cases[i].used_hz && rx_bw == cases[i].reg && afc_bw == cases[i].reg) {
+            passed++;
+        } else {
+            sim_check("bandwidth", false, "%lu Hz: 0x%02x, %lu Hz used", (unsigned long)cases[i].requested_hz,
+                      rx_bw, (unsigned long)used);
+        }
+    }
+    return sim_check("bandwidth table", passed == sizeof(cases) / sizeof(cases[0]), "%d/%d", passed,
+                     (int)(sizeof(cases) / sizeof(cases[0])));
+}
+
+// BitRate = FXOSC / bitrate, with the remainder in sixteenths in BitRateFrac
+static int bitrates(lora_fsk_t *fsk) {
+    static const struct {
+        uint32_t bitrate;
+        uint8_t msb;
+        uint8_t lsb;
+        uint8_t frac;
+    } cases[] = {
+        { 100000, 0x01, 0x40, 0 },
+        { 38400, 0x03, 0x41, 5 },
+        { 4800, 0x1a, 0x0a, 11 },
+    };
+    int passed = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint8_t regs[2];
+        lora_fsk_set_bitrate(fsk, cases[i].bitrate);
+        lora_read_register_burst(fsk->lora, REG_FSK_BITRATE_MSB, regs, sizeof(regs));
+        uint8_t frac = lora_read_register(fsk->lora, REG_FSK_BITRATE_FRAC);
+        if (regs[0] == cases[i].msb && regs[1] == cases[i].lsb && frac == cases[i].frac) {
+            passed++;
+        } else {
+            sim_check("bitrate", false, "%lu bps: 0x%02x%02x frac %u", (unsigned long)cases[i].bitrate,
+                      regs[0], regs[1], frac);
+        }
+    }
+    return sim_check("bitrate table", passed == sizeof(cases) / sizeof(cases[0]), "%d/%d", passed,
+                     (int)(sizeof(cases) / sizeof(cases[0])));
+}
+
+static int time_on_air(void) {
+    lora_fsk_config_t config;
+    int failures = 0;
+
+    // 4 preamble + 2 sync + 1 length + 20 payload + 2 CRC bytes at 100 kbps
+    lora_fsk_default_config(&config);
+    uint32_t airtime = lora_fsk_time_on_air_us(&config, 20);
+    failures += sim_check("airtime variable", airtime == 2320, "%lu us", (unsigned long)airtime);
+
+    // 4 preamble + 2 sync + 300 payload bytes at 4.8 kbps
+    config.bitrate = 4800;
+    config.crc_enabled = false;
+    config.fixed_length = 300;
+    airtime = lora_fsk_time_on_air_us(&config, 300);
+    failures += sim_check("airtime fixed", airtime == 510000, "%lu us", (unsigned long)airtime);
+    return failures;
+}
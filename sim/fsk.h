@@ -0,0 +1,10 @@
+#ifndef SIM_FSK_H
+#define SIM_FSK_H
+
+// Checks of the registers lora_fsk writes for bitrate, deviation, receiver
+// bandwidth and packet format, and of lora_fsk_time_on_air_us. The FSK
+// modem is not simulated, only its registers. Returns the number of
+// failed checks.
+int sim_fsk_run(void);
+
+#endif // SIM_FSK_H
@@ -0,0 +1,213 @@
+// Gateway harness: a lora_bridge gateway and one sender node on the
+// simulated channel. Host commands go in through lora_bridge_input, the
+// sink captures the gateway's output, and the checks decode it the way
+// pico-lora-bridge would.
+
+#include "gateway.h"
+#include "check.h"
+#include "lora_bridge.h"
+#include <string.h>
+
+#define POLL_US                 500
+#define AIR_TIMEOUT_US          500000
+#define SENDER_FRAMES           5
+#define SENDER_PAYLOAD          20
+#define CAPTURE_SIZE            4096
+#define MAX_MESSAGES            16
+
+typedef struct {
+    print_ctx_t print;          // First, so the context casts back to the capture
+    uint8_t data[CAPTURE_SIZE];
+    size_t length;
+} capture_t;
+
+typedef struct {
+    uint8_t bytes[LORA_BRIDGE_MAX_MESSAGE];
+    size_t length;              // Type and body, CRC stripped
+} message_t;
+
+// Forward declarations of static functions
+static size_t capture_write_byte(print_ctx_t *ctx, uint8_t b);
+static size_t capture_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size);
+static void command(lora_bridge_t *bridge, uint8_t type, const uint8_t *body, size_t length);
+static size_t decode_capture(const capture_t *capture, message_t *messages, uint32_t *bad_frames);
+static const message_t *find_message(const message_t *messages, size_t count, uint8_t type, uint8_t tag);
+static int receive(sim_node_t *node, uint8_t *buffer, size_t capacity);
+
+static lora_bridge_t bridge;
+static capture_t capture;
+static message_t messages[MAX_MESSAGES];
+
+int sim_gateway_run(void) {
+    static const uint8_t echo[] = { 'h', 'e', 'l', 'l', 'o', 0, 'w', 'o', 'r', 'l', 'd' };
+    static const uint8_t tx[] = { 7, 'p', 'i', 'n', 'g' };
+    static const uint8_t tx_empty[] = { 8 };
+    static const uint8_t junk[] = { 1, 2, 3, 0, 5, 0x41, 0x42, 0 };
+    uint8_t received[MAX_PKT_LENGTH];
+    int failures = 0;
+
+    sim_node_t *gateway = sim_check_setup(1, 2, true);
+    if (!gateway) {
+        return 1;
+    }
+    sim_node_t *sender = &sim_nodes[1];
+
+    memset(&capture, 0, sizeof(capture));
+    capture.print.write_byte = capture_write_byte;
+    capture.print.write_buffer = capture_write_buffer;
+    lora_bridge_init(&bridge, &gateway->lora, &capture.print);
+
+    // The sender listens before the gateway transmits
+    sim_select(sender);
+    lora_parse_packet(&sender->lora, 0);
+
+    // Commands from the host, including a zero byte inside a body and two
+    // frames of line noise
+    sim_select(gateway);
+    command(&bridge, LORA_BRIDGE_CMD_ECHO, echo, sizeof(echo));
+    lora_bridge_input(&bridge, junk, sizeof(junk));
+    command(&bridge, LORA_BRIDGE_CMD_TX, tx_empty, sizeof(tx_empty));
+    command(&bridge, LORA_BRIDGE_CMD_TX, tx, sizeof(tx));
+    int heard = receive(sender, received, sizeof(received));
+
+    // The gateway forwards what the sender transmits
+    for (int i = 0; i < SENDER_FRAMES; i++) {
+        uint8_t payload[SENDER_PAYLOAD];
+
+        memset(payload, i, sizeof(payload));
+        sim_select(sender);
+        lora_begin_packet(&sender->lora, false);
+        lora_write(&sender->lora, payload, sizeof(payload));
+        lora_end_packet(&sender->lora, true);
+
+        uint64_t deadline_us = sim_now_us() + AIR_TIMEOUT_US;
+        sim_select(gateway);
+        while (!lora_bridge_poll(&bridge) && sim_now_us() < deadline_us) {
+            sleep_us(POLL_US);
+        }
+    }
+    lora_bridge_flush(&bridge);
+
+    uint32_t bad_frames = 0;
+    size_t count = decode_capture(&capture, messages, &bad_frames);
+
+    const message_t *m = find_message(messages, count, LORA_BRIDGE_MSG_ECHO, echo[0]);
+    failures += sim_check("echo", m && m->length == 1 + sizeof(echo) && memcmp(&m->bytes[1], echo, sizeof(echo)) == 0,
+                          NULL);
+
+    m = find_message(messages, count, LORA_BRIDGE_MSG_TX_DONE, tx[0]);
+    failures += sim_check("tx command", m && m->length == 3 && m->bytes[2] == LORA_BRIDGE_TX_OK &&
+                          heard == (int)sizeof(tx) - 1 && memcmp(received, &tx[1], sizeof(tx) - 1) == 0, NULL);
+
+    m = find_message(messages, count, LORA_BRIDGE_MSG_TX_DONE, tx_empty[0]);
+    failures += sim_check("bad input", m && m->length == 3 && m->bytes[2] == LORA_BRIDGE_TX_INVALID &&
+                          bridge.stats.bad_frames == 2, "%lu bad frames", (unsigned long)bridge.stats.bad_frames);
+
+    int forwarded = 0;
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *payload = &messages[i].bytes[LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_RX_HEADER];
+        if (messages[i].bytes[0] == LORA_BRIDGE_MSG_RX &&
+            messages[i].length == LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_RX_HEADER + SENDER_PAYLOAD &&
+            payload[0] == forwarded && payload[SENDER_PAYLOAD - 1] == forwarded) {
+            forwarded++;
+        }
+    }
+    failures += sim_check("forwarded", forwarded == SENDER_FRAMES && bridge.stats.rx_forwarded == SENDER_FRAMES,
+                          "%d/%d in order", forwarded, SENDER_FRAMES);
+
+    failures += sim_check("host decode", bad_frames == 0 && count == bridge.stats.messages_out &&
+                          bridge.stats.batches_out < bridge.stats.messages_out, "%lu messages in %lu writes, %lu bytes",
+                          (unsigned long)bridge.stats.messages_out, (unsigned long)bridge.stats.batches_out,
+                          (unsigned long)capture.length);
+
+    return failures;
+}
+
+// Private functions
+static size_t capture_write_byte(print_ctx_t *ctx, uint8_t b) {
+    return capture_write_buffer(ctx, &b, 1);
+}
+
+static size_t capture_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size) {
+    capture_t *c = (capture_t *)ctx;
+
+    if (size > sizeof(c->data) - c->length) {
+        size = sizeof(c->data) - c->length;
+    }
+    memcpy(c->data + c->length, buffer, size);
+    c->length += size;
+    return size;
+}
+
+// Encode a command as the host would and feed it to the gateway
+static void command(lora_bridge_t *b, uint8_t type, const uint8_t *body, size_t length) {
+    uint8_t message[LORA_BRIDGE_MAX_MESSAGE];
+    uint8_t encoded[LORA_BRIDGE_MAX_ENCODED];
+
+    message[0] = type;
+    memcpy(&message[LORA_BRIDGE_TYPE_SIZE], body, length);
+    length += LORA_BRIDGE_TYPE_SIZE;
+
+    uint16_t crc = lora_wire_crc16(message, length);
+    message[length++] = (uint8_t)crc;
+    message[length++] = (uint8_t)(crc >> 8);
+
+    size_t n = lora_wire_encode(message, length, encoded);
+    encoded[n++] = LORA_WIRE_DELIMITER;
+    lora_bridge_input(b, encoded, n);
+}
+
+static size_t decode_capture(const capture_t *c, message_t *out, uint32_t *bad_frames) {
+    uint8_t frame[LORA_BRIDGE_MAX_ENCODED];
+    size_t frame_length = 0;
+    size_t count = 0;
+
+    for (size_t i = 0; i < c->length; i++) {
+        if (c->data[i] != LORA_WIRE_DELIMITER) {
+            if (frame_length < sizeof(frame)) {
+                frame[frame_length++] = c->data[i];
+            }
+            continue;
+        }
+
+        int n = lora_wire_decode(frame, frame_length, frame);
+        frame_length = 0;
+        if (n < LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_CRC_SIZE) {
+            (*bad_frames)++;
+            continue;
+        }
+        size_t m = (size_t)n - LORA_BRIDGE_CRC_SIZE;
+        if ((uint16_t)(frame[m] | (frame[m + 1] << 8)) != lora_wire_crc16(frame, m)) {
+            (*bad_frames)++;
+        } else if (count < MAX_MESSAGES) {
+            memcpy(out[count].bytes, frame, m);
+            out[count].length = m;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Echo replies are matched on their first body byte, TX_DONE on its tag
+static const message_t *find_message(const message_t *list, size_t count, uint8_t type, uint8_t tag) {
+    for (size_t i = 0; i < count; i++) {
+        if (list[i].bytes[0] == type && list[i].length > 1 && list[i].bytes[1] == tag) {
+            return &list[i];
+        }
+    }
+    return NULL;
+}
+
+static int receive(sim_node_t *node, uint8_t *buffer, size_t capacity) {
+    uint64_t deadline_us = sim_now_us() + AIR_TIMEOUT_US;
+
+    sim_select(node);
+    while (sim_now_us() < deadline_us) {
+        int length = lora_parse_packet(&node->lora, 0);
+        if (length > 0) {
+            return (int)lora_read_bytes(&node->lora, buffer, capacity);
+        }
+        sleep_us(POLL_US);
+    }
+    return 0;
+}
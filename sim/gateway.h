@@ -0,0 +1,9 @@
+#ifndef SIM_GATEWAY_H
+#define SIM_GATEWAY_H
+
+// lora_bridge on the simulated channel: echo and TX commands, line noise,
+// and packets from a second node forwarded to the host. Returns the number
+// of failed checks.
+int sim_gateway_run(void);
+
+#endif // SIM_GATEWAY_H
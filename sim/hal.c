@@ -0,0 +1,249 @@
+// Simulator clock, node registry and the host implementations of the
+// Pico SDK calls used by the driver (time, SPI, GPIO).
+
+#include "sim.h"
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "pico/time.h"
+#include <math.h>
+#include <string.h>
+
+sim_node_t sim_nodes[SIM_MAX_NODES];
+int sim_node_count;
+
+spi_inst_t sim_spi0 = { 0 };
+spi_inst_t sim_spi1 = { 1 };
+
+static uint64_t clock_us;
+static sim_node_t *current;
+static uint64_t rng_state;
+
+void sim_init(const sim_channel_config_t *config) {
+    memset(sim_nodes, 0, sizeof(sim_nodes));
+    sim_node_count = 0;
+    clock_us = 0;
+    current = NULL;
+    rng_state = config->seed ? config->seed : 1;
+    rng_state = rng_state * 0x9e3779b97f4a7c15ULL + 1;
+    sim_channel_init(config);
+}
+
+sim_node_t *sim_add_node(double x, double y, double clock_ppm) {
+    if (sim_node_count >= SIM_MAX_NODES) {
+        return NULL;
+    }
+
+    sim_node_t *node = &sim_nodes[sim_node_count];
+    node->id = sim_node_count++;
+    node->x = x;
+    node->y = y;
+    node->clock_ppm = clock_ppm;
+    node->clock_offset_us = sim_random() % 1000000;
+    node->radio.tx = -1;
+    node->radio.rx_lock = -1;
+    sim_radio_reset(&node->radio);
+    lora_init(&node->lora);
+    return node;
+}
+
+void sim_select(sim_node_t *node) {
+    current = node;
+}
+
+sim_node_t *sim_current(void) {
+    return current;
+}
+
+// Global clock
+uint64_t sim_now_us(void) {
+    return clock_us;
+}
+
+// Run every radio event due up to global_us, in time order
+void sim_advance_to(uint64_t global_us) {
+    for (;;) {
+        sim_node_t *next = NULL;
+        uint64_t next_us = SIM_NO_EVENT;
+
+        for (int i = 0; i < sim_node_count; i++) {
+            if (sim_nodes[i].radio.event_us < next_us) {
+                next_us = sim_nodes[i].radio.event_us;
+                next = &sim_nodes[i];
+            }
+        }
+
+        if (!next || next_us > global_us) {
+            break;
+        }
+        if (next_us > clock_us) {
+            clock_us = next_us;
+        }
+        sim_radio_event(next);
+    }
+
+    if (global_us > clock_us) {
+        clock_us = global_us;
+    }
+}
+
+uint64_t sim_global_to_local(const sim_node_t *node, uint64_t global_us) {
+    return global_us + (int64_t)llround((double)global_us * node->clock_ppm * 1e-6) + node->clock_offset_us;
+}
+
+uint64_t sim_local_to_global(const sim_node_t *node, uint64_t local_us) {
+    if (local_us <= (uint64_t)node->clock_offset_us) {
+        return 0;
+    }
+    return (uint64_t)ceil((double)(local_us - node->clock_offset_us) / (1.0 + node->clock_ppm * 1e-6));
+}
+
+// Randomness (xorshift64*)
+uint32_t sim_random(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+double sim_random_uniform(void) {
+    return (sim_random() + 0.5) / 4294967296.0;
+}
+
+double sim_random_exponential(double mean) {
+    return -mean * log(sim_random_uniform());
+}
+
+double sim_random_gaussian(void) {
+    return sqrt(-2.0 * log(sim_random_uniform())) * cos(2.0 * M_PI * sim_random_uniform());
+}
+
+// pico/time.h
+uint64_t time_us_64(void) {
+    return current ? sim_global_to_local(current, clock_us) : clock_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+void sleep_us(uint64_t us) {
+    sim_advance_to(clock_us + us);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+void sleep_until(absolute_time_t target) {
+    uint64_t global_us = current ? sim_local_to_global(current, target) : target;
+    sim_advance_to(global_us);
+}
+
+void tight_loop_contents(void) {
+    sim_advance_to(clock_us + 1);
+}
+
+// hardware/spi.h
+uint spi_init(spi_inst_t *spi, uint baudrate) {
+    (void)spi;
+    return baudrate;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len) {
+    (void)spi;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t miso = current ? sim_radio_spi_byte(current, src[i]) : 0;
+        if (dst) {
+            dst[i] = miso;
+        }
+    }
+    return (int)len;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    return spi_write_read_blocking(spi, src, NULL, len);
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len) {
+    (void)spi;
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = current ? sim_radio_spi_byte(current, repeated_tx_data) : 0;
+    }
+    return (int)len;
+}
+
+// hardware/gpio.h
+void gpio_init(uint gpio) {
+    (void)gpio;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    (void)gpio;
+    (void)out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (!current) {
+        return;
+    }
+
+    if (gpio == SIM_SS_PIN) {
+        sim_radio_select(&current->radio, !value);
+    } else if (gpio == SIM_RESET_PIN) {
+        if (!value) {
+            sim_radio_reset(&current->radio);
+        }
+        current->radio.in_reset = !value;
+    }
+}
+
+bool gpio_get(uint gpio) {
+    if (current && gpio == current->lora.config.dio0_pin) {
+        return sim_radio_dio0(&current->radio);
+    }
+    return false;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    (void)gpio;
+    (void)event_mask;
+    (void)enabled;
+    (void)callback;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    (void)gpio;
+    (void)event_mask;
+    (void)enabled;
+}
+
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler) {
+    (void)gpio;
+    (void)handler;
+}
+
+void gpio_remove_raw_irq_handler(uint gpio, irq_handler_t handler) {
+    (void)gpio;
+    (void)handler;
+}
+
+uint32_t gpio_get_irq_event_mask(uint gpio) {
+    (void)gpio;
+    return 0;
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask) {
+    (void)gpio;
+    (void)event_mask;
+}
+
+// hardware/irq.h
+void irq_set_enabled(uint num, bool enabled) {
+    (void)num;
+    (void)enabled;
+}
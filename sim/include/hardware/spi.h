@@ -0,0 +1,22 @@
+#ifndef SIM_HARDWARE_SPI_H
+#define SIM_HARDWARE_SPI_H
+
+// Host stand-in for the Pico SDK SPI API; bytes go to the selected node's radio model
+
+#include "pico/types.h"
+
+typedef struct spi_inst {
+    int index;
+} spi_inst_t;
+
+extern spi_inst_t sim_spi0;
+extern spi_inst_t sim_spi1;
+#define spi0 (&sim_spi0)
+#define spi1 (&sim_spi1)
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+
+#endif // SIM_HARDWARE_SPI_H
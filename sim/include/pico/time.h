@@ -0,0 +1,33 @@
+#ifndef SIM_PICO_TIME_H
+#define SIM_PICO_TIME_H
+
+// Host stand-in for the Pico SDK timer API, driven by the simulator clock
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void sleep_until(absolute_time_t target);
+
+// Busy-wait loops cost one simulated microsecond per iteration
+void tight_loop_contents(void);
+
+static inline absolute_time_t from_us_since_boot(uint64_t us) {
+    return us;
+}
+
+static inline absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_PICO_TIME_H
@@ -0,0 +1,265 @@
+// pico-lora-sim: run a traffic scenario over N virtual SX127x radios
+// sharing one channel and report delivery, goodput, latency and collisions.
+
+#include "scenarios.h"
+#include "aggregate.h"
+#include "async.h"
+#include "ccm_bench.h"
+#include "crypto.h"
+#include "entropy.h"
+#include "fsk.h"
+#include "gateway.h"
+#include "print_bench.h"
+#include "recovery.h"
+#include "sim.h"
+#include "sweep.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Forward declarations of static functions
+static void usage(const char *program);
+static int run_entropy(int argc, char **argv);
+static int run_print_bench(int argc, char **argv);
+static int run_ccm_bench(int argc, char **argv);
+static bool parse_iterations(int argc, char **argv, uint32_t *iterations);
+static int compare_u32(const void *a, const void *b);
+static uint32_t percentile(const sim_report_t *report, double p);
+static void print_report(const sim_options_t *options, const sim_report_t *report);
+
+int main(int argc, char **argv) {
+    sim_options_t options;
+    sim_report_t report;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (strcmp(argv[1], "entropy") == 0) {
+        return run_entropy(argc, argv);
+    }
+    if (strcmp(argv[1], "async") == 0) {
+        return sim_async_run();
+    }
+    if (strcmp(argv[1], "crypto") == 0) {
+        return sim_crypto_run();
+    }
+    if (strcmp(argv[1], "recovery") == 0) {
+        return sim_recovery_run();
+    }
+    if (strcmp(argv[1], "bridge") == 0) {
+        return sim_gateway_run();
+    }
+    if (strcmp(argv[1], "sweep") == 0) {
+        return sim_sweep_run();
+    }
+    if (strcmp(argv[1], "aggregate") == 0) {
+        return sim_aggregate_run();
+    }
+    if (strcmp(argv[1], "fsk") == 0) {
+        return sim_fsk_run();
+    }
+    if (strcmp(argv[1], "print") == 0) {
+        return run_print_bench(argc, argv);
+    }
+    if (strcmp(argv[1], "ccm") == 0) {
+        return run_ccm_bench(argc, argv);
+    }
+
+    if (strcmp(argv[1], "aloha") == 0) {
+        sim_options_default(&options, SIM_SCENARIO_ALOHA);
+    } else if (strcmp(argv[1], "tdma") == 0) {
+        sim_options_default(&options, SIM_SCENARIO_TDMA);
+    } else if (strcmp(argv[1], "mesh") == 0) {
+        sim_options_default(&options, SIM_SCENARIO_MESH);
+    } else {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!value) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+
+        if (strcmp(arg, "--nodes") == 0) {
+            options.nodes = atoi(value);
+        } else if (strcmp(arg, "--duration") == 0) {
+            options.duration_s = atof(value);
+        } else if (strcmp(arg, "--rate") == 0) {
+            options.rate_per_min = atof(value);
+        } else if (strcmp(arg, "--sf") == 0) {
+            options.sf = atoi(value);
+        } else if (strcmp(arg, "--payload") == 0) {
+            options.payload = atoi(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            options.seed = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--drift-ppm") == 0) {
+            options.drift_ppm = atof(value);
+        } else if (strcmp(arg, "--radius") == 0) {
+            options.radius_m = atof(value);
+        } else if (strcmp(arg, "--path-loss") == 0) {
+            options.path_loss_exponent = atof(value);
+        } else if (strcmp(arg, "--shadowing") == 0) {
+            options.shadowing_db = atof(value);
+        } else if (strcmp(arg, "--tick") == 0) {
+            options.tick_us = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--queue") == 0) {
+            options.queue = atoi(value);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (!sim_run(&options, &report)) {
+        fprintf(stderr, "scenario setup failed\n");
+        return 1;
+    }
+
+    print_report(&options, &report);
+    sim_report_free(&report);
+    return 0;
+}
+
+// Private functions
+static void usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s aloha|tdma|mesh [options]\n"
+            "       %s entropy [--bytes N] [--seed N] [--ones P]\n"
+            "       %s async\n"
+            "       %s crypto\n"
+            "       %s recovery\n"
+            "       %s bridge\n"
+            "       %s sweep\n"
+            "       %s aggregate\n"
+            "       %s fsk\n"
+            "       %s print [--iterations N]\n"
+            "       %s ccm [--iterations N]\n"
+            "  --nodes N          nodes including gateway/coordinator/sink\n"
+            "  --duration S       traffic duration in seconds\n"
+            "  --rate R           frames per node per minute (Poisson)\n"
+            "  --sf SF            spreading factor 6-12\n"
+            "  --payload BYTES    application payload (min %d)\n"
+            "  --seed N           random seed\n"
+            "  --drift-ppm PPM    max clock error per node\n"
+            "  --radius M         star radius, or hop spacing for mesh\n"
+            "  --path-loss N      path loss exponent\n"
+            "  --shadowing DB     per-link shadowing std deviation\n"
+            "  --tick US          firmware poll period\n"
+            "  --queue N          frames buffered per node\n"
+            "  --bytes N          entropy: pool output to test\n"
+            "  --ones P           entropy: raw wideband LSB bias\n"
+            "  --iterations N     print: calls timed per function; ccm: frames per size\n",
+            program, program, program, program, program, program, program, program, program, program,
+            program, SIM_PAYLOAD_HEADER);
+}
+
+// Entropy pool harness; exit status is the number of failed checks
+static int run_entropy(int argc, char **argv) {
+    size_t bytes = 1 << 20;
+    uint32_t seed = 1;
+    double ones = 0.6;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--bytes") == 0) {
+            bytes = (size_t)strtoul(argv[i + 1], NULL, 0);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            seed = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        } else if (strcmp(argv[i], "--ones") == 0) {
+            ones = atof(argv[i + 1]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc % 2 != 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    return sim_entropy_run(bytes, seed, ones);
+}
+
+// Print formatting benchmark; exit status is the number of functions whose
+// output changed
+static int run_print_bench(int argc, char **argv) {
+    uint32_t iterations = 1000000;
+
+    if (!parse_iterations(argc, argv, &iterations)) {
+        usage(argv[0]);
+        return 2;
+    }
+    return sim_print_bench_run(iterations);
+}
+
+// Seal/open benchmark; exit status is the number of sizes that failed to
+// open
+static int run_ccm_bench(int argc, char **argv) {
+    uint32_t iterations = 100000;
+
+    if (!parse_iterations(argc, argv, &iterations)) {
+        usage(argv[0]);
+        return 2;
+    }
+    return sim_ccm_bench_run(iterations);
+}
+
+// Optional --iterations N after the command; iterations keeps its default
+// when absent
+static bool parse_iterations(int argc, char **argv, uint32_t *iterations) {
+    if (argc == 4 && strcmp(argv[2], "--iterations") == 0) {
+        *iterations = (uint32_t)strtoul(argv[3], NULL, 0);
+    } else if (argc != 2) {
+        return false;
+    }
+    return *iterations != 0;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const sim_report_t *report, double p) {
+    if (report->latency_count == 0) {
+        return 0;
+    }
+    size_t index = (size_t)(p * (report->latency_count - 1) + 0.5);
+    return report->latency_us[index];
+}
+
+static void print_report(const sim_options_t *options, const sim_report_t *report) {
+    static const char *const names[] = { "aloha", "tdma", "mesh" };
+    const sim_channel_stats_t *ch = &sim_channel_stats;
+
+    qsort(report->latency_us, report->latency_count, sizeof(uint32_t), compare_u32);
+
+    printf("scenario %s, %d nodes, %.0f s, SF%d, %d byte payload, %.2f frames/min/node, seed %lu\n",
+           names[options->scenario], options->nodes, options->duration_s, options->sf, options->payload,
+           options->rate_per_min, (unsigned long)options->seed);
+    printf("offered %lu, delivered %lu (%.1f%%), queue drops %lu, duplicates %lu\n",
+           (unsigned long)report->offered, (unsigned long)report->delivered,
+           report->offered ? 100.0 * report->delivered / report->offered : 0.0,
+           (unsigned long)report->queue_drops, (unsigned long)report->duplicates);
+    printf("goodput %.1f bit/s, channel load %.3f\n",
+           report->delivered_bytes * 8.0 / options->duration_s, ch->airtime_us / (options->duration_s * 1e6));
+    printf("latency ms p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+           percentile(report, 0.50) / 1000.0, percentile(report, 0.90) / 1000.0,
+           percentile(report, 0.99) / 1000.0,
+           report->latency_count ? report->latency_us[report->latency_count - 1] / 1000.0 : 0.0);
+    printf("channel tx %lu, collided %lu (%.1f%%), rx ok %lu, corrupted %lu, captured %lu, below sensitivity %lu\n",
+           (unsigned long)ch->transmissions, (unsigned long)ch->collided,
+           ch->transmissions ? 100.0 * ch->collided / ch->transmissions : 0.0,
+           (unsigned long)ch->rx_ok, (unsigned long)ch->rx_corrupted, (unsigned long)ch->rx_captured,
+           (unsigned long)ch->below_sensitivity);
+    if (report->detail[0]) {
+        printf("%s\n", report->detail);
+    }
+}
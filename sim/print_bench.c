@@ -0,0 +1,308 @@
+// Print benchmark: each function formats the same pseudo-random samples
+// into a memory sink behind the usual print_ctx_t function pointers, once
+// through print.c and once through a copy of the per-character code it
+// replaced. Timings are host wall clock, so only the ratio carries over to
+// the RP2040; the outputs are also compared sample by sample.
+
+#include "print_bench.h"
+#include "print.h"
+#include <stdio.h>
+#include <time.h>
+
+// Power of two so the sample index is a mask
+#define SAMPLES                 1024
+#define HEX_LENGTH              32
+#define DOUBLE_DIGITS           2
+
+typedef struct {
+    print_ctx_t print;          // First, so the context casts back to the sink
+    uint8_t data[256];
+    size_t length;
+} sink_t;
+
+typedef size_t (*sample_fn)(print_ctx_t *ctx, uint32_t i);
+
+typedef struct {
+    const char *name;
+    sample_fn after;
+    sample_fn before;
+} bench_t;
+
+// Forward declarations of static functions
+static void make_samples(void);
+static uint64_t next_random(void);
+static void sink_init(sink_t *sink);
+static size_t sink_write_byte(print_ctx_t *ctx, uint8_t b);
+static size_t sink_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size);
+static double ns_per_call(sample_fn fn, uint32_t iterations);
+static uint32_t count_differences(const bench_t *bench);
+static size_t int_after(print_ctx_t *ctx, uint32_t i);
+static size_t int_before(print_ctx_t *ctx, uint32_t i);
+static size_t ulonglong_after(print_ctx_t *ctx, uint32_t i);
+static size_t ulonglong_before(print_ctx_t *ctx, uint32_t i);
+static size_t double_after(print_ctx_t *ctx, uint32_t i);
+static size_t double_before(print_ctx_t *ctx, uint32_t i);
+static size_t hex_after(print_ctx_t *ctx, uint32_t i);
+static size_t hex_before(print_ctx_t *ctx, uint32_t i);
+static size_t baseline_number(print_ctx_t *ctx, unsigned long n, uint8_t base);
+static size_t baseline_ull_number(print_ctx_t *ctx, unsigned long long n64, uint8_t base);
+static size_t baseline_float(print_ctx_t *ctx, double number, int digits);
+
+static int int_samples[SAMPLES];
+static unsigned long long ulonglong_samples[SAMPLES];
+static double double_samples[SAMPLES];
+static uint8_t hex_samples[SAMPLES + HEX_LENGTH];
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+static const bench_t benches[] = {
+    { "print_int", int_after, int_before },
+    { "print_ulonglong", ulonglong_after, ulonglong_before },
+    { "print_double", double_after, double_before },
+    { "print_hex_buffer", hex_after, hex_before },
+};
+
+int sim_print_bench_run(uint32_t iterations) {
+    int failures = 0;
+
+    make_samples();
+
+    printf("%-18s %10s %10s %8s\n", "ns/call", "before", "after", "speedup");
+    for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        const bench_t *bench = &benches[b];
+        double before = ns_per_call(bench->before, iterations);
+        double after = ns_per_call(bench->after, iterations);
+        uint32_t differences = count_differences(bench);
+
+        printf("%-18s %10.1f %10.1f %7.2fx", bench->name, before, after, before / after);
+        if (differences) {
+            printf("  %lu/%d outputs differ", (unsigned long)differences, SAMPLES);
+            failures++;
+        }
+        printf("\n");
+    }
+
+    return failures;
+}
+
+// Private functions
+static void make_samples(void) {
+    for (int i = 0; i < SAMPLES; i++) {
+        uint64_t r = next_random();
+
+        // Every magnitude, both signs
+        int_samples[i] = (int)((int32_t)r >> (r >> 59));
+        // Non-zero: the baseline printed nothing for 0
+        ulonglong_samples[i] = (next_random() >> (r >> 58)) | 1;
+        double_samples[i] = (double)((int64_t)(r % 2000001) - 1000000) / 100.0;
+    }
+    for (int i = 0; i < SAMPLES + HEX_LENGTH; i++) {
+        hex_samples[i] = (uint8_t)next_random();
+    }
+}
+
+static uint64_t next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+static void sink_init(sink_t *sink) {
+    print_init(&sink->print);
+    sink->print.write_byte = sink_write_byte;
+    sink->print.write_buffer = sink_write_buffer;
+    sink->length = 0;
+}
+
+static size_t sink_write_byte(print_ctx_t *ctx, uint8_t b) {
+    sink_t *sink = (sink_t *)ctx;
+
+    if (sink->length < sizeof(sink->data)) {
+        sink->data[sink->length++] = b;
+    }
+    return 1;
+}
+
+static size_t sink_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size) {
+    sink_t *sink = (sink_t *)ctx;
+
+    if (size > sizeof(sink->data) - sink->length) {
+        size = sizeof(sink->data) - sink->length;
+    }
+    memcpy(sink->data + sink->length, buffer, size);
+    sink->length += size;
+    return size;
+}
+
+static double ns_per_call(sample_fn fn, uint32_t iterations) {
+    struct timespec start;
+    struct timespec stop;
+    sink_t sink;
+
+    sink_init(&sink);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < iterations; i++) {
+        sink.length = 0;
+        fn(&sink.print, i & (SAMPLES - 1));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    return ((stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec)) / iterations;
+}
+
+static uint32_t count_differences(const bench_t *bench) {
+    sink_t after;
+    sink_t before;
+    uint32_t differences = 0;
+
+    sink_init(&after);
+    sink_init(&before);
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        after.length = 0;
+        before.length = 0;
+        bench->after(&after.print, i);
+        bench->before(&before.print, i);
+        if (after.length != before.length || memcmp(after.data, before.data, after.length) != 0) {
+            differences++;
+        }
+    }
+    return differences;
+}
+
+static size_t int_after(print_ctx_t *ctx, uint32_t i) {
+    return print_int(ctx, int_samples[i], DEC);
+}
+
+// print_int went through print_long
+static size_t int_before(print_ctx_t *ctx, uint32_t i) {
+    long n = int_samples[i];
+
+    if (n < 0) {
+        size_t t = print_char(ctx, '-');
+        n = -n;
+        return baseline_number(ctx, n, 10) + t;
+    }
+    return baseline_number(ctx, n, 10);
+}
+
+static size_t ulonglong_after(print_ctx_t *ctx, uint32_t i) {
+    return print_ulonglong(ctx, ulonglong_samples[i], DEC);
+}
+
+static size_t ulonglong_before(print_ctx_t *ctx, uint32_t i) {
+    return baseline_ull_number(ctx, ulonglong_samples[i], 10);
+}
+
+static size_t double_after(print_ctx_t *ctx, uint32_t i) {
+    return print_double(ctx, double_samples[i], DOUBLE_DIGITS);
+}
+
+static size_t double_before(print_ctx_t *ctx, uint32_t i) {
+    return baseline_float(ctx, double_samples[i], DOUBLE_DIGITS);
+}
+
+static size_t hex_after(print_ctx_t *ctx, uint32_t i) {
+    return print_hex_buffer(ctx, hex_samples + i, HEX_LENGTH);
+}
+
+// What lora_error_print_hex did per byte
+static size_t hex_before(print_ctx_t *ctx, uint32_t i) {
+    size_t n = 0;
+
+    for (size_t j = 0; j < HEX_LENGTH; j++) {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02x", hex_samples[i + j]);
+        n += print_str(ctx, hex);
+    }
+    return n;
+}
+
+// The print.c number formatting before it rendered into a local buffer
+static size_t baseline_number(print_ctx_t *ctx, unsigned long n, uint8_t base) {
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    *str = '\0';
+    do {
+        char c = n % base;
+        n /= base;
+
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return print_write_str(ctx, str);
+}
+
+static size_t baseline_ull_number(print_ctx_t *ctx, unsigned long long n64, uint8_t base) {
+    char buf[64];
+    uint8_t i = 0;
+    uint8_t inner_loops = 0;
+
+    // Chunks that fit in 16 bit math
+    uint16_t top = 0xffff / base;
+    uint16_t th16 = 1;
+    while (th16 < top) {
+        th16 *= base;
+        inner_loops++;
+    }
+
+    while (n64 > th16) {
+        uint64_t q = n64 / th16;
+        uint16_t r = n64 - q * th16;
+        n64 = q;
+
+        for (uint8_t j = 0; j < inner_loops; j++) {
+            uint16_t qq = r / base;
+            buf[i++] = r - qq * base;
+            r = qq;
+        }
+    }
+
+    uint16_t n16 = n64;
+    while (n16 > 0) {
+        uint16_t qq = n16 / base;
+        buf[i++] = n16 - qq * base;
+        n16 = qq;
+    }
+
+    size_t bytes = i;
+    for (; i > 0; i--) {
+        char c = (buf[i - 1] < 10) ? ('0' + buf[i - 1]) : ('A' + buf[i - 1] - 10);
+        print_char(ctx, c);
+    }
+
+    return bytes;
+}
+
+static size_t baseline_float(print_ctx_t *ctx, double number, int digits) {
+    size_t n = 0;
+
+    if (number < 0.0) {
+        n += print_char(ctx, '-');
+        number = -number;
+    }
+
+    double rounding = 0.5;
+    for (int i = 0; i < digits; i++) {
+        rounding /= 10.0;
+    }
+    number += rounding;
+
+    unsigned long int_part = (unsigned long)number;
+    double remainder = number - (double)int_part;
+    n += baseline_number(ctx, int_part, 10);
+
+    if (digits > 0) {
+        n += print_char(ctx, '.');
+    }
+
+    // One digit, and one write, at a time
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int digit = (unsigned int)remainder;
+        n += baseline_number(ctx, digit, 10);
+        remainder -= digit;
+    }
+
+    return n;
+}
@@ -0,0 +1,12 @@
+#ifndef SIM_PRINT_BENCH_H
+#define SIM_PRINT_BENCH_H
+
+#include <stdint.h>
+
+// Host micro-benchmark of the print number formatting: per-call cost of
+// print_int, print_ulonglong, print_double and print_hex_buffer against the
+// per-character implementation they replaced. Returns the number of
+// functions whose output differs from the baseline.
+int sim_print_bench_run(uint32_t iterations);
+
+#endif // SIM_PRINT_BENCH_H
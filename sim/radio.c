@@ -0,0 +1,473 @@
+// Register-level model of an SX127x in LoRa mode. The driver talks to it
+// over the simulated SPI bus exactly as it would to the real chip. In FSK
+// mode the FSK page registers are plain storage; the FSK modem itself is
+// not simulated.
+
+#include "sim.h"
+#include <math.h>
+#include <string.h>
+
+// Read-only or model-owned registers
+#define REG_FIFO_RX_BYTE_ADDR   0x25
+
+// Registers that differ between the LoRa and FSK pages
+#define REG_PAGE_FIRST          0x0d
+#define REG_PAGE_LAST           0x3f
+
+// Register values after reset (Semtech SX1276/77/78/79 Table 41)
+static const struct {
+    uint8_t address;
+    uint8_t value;
+} reset_values[] = {
+    { REG_OP_MODE, 0x09 },
+    { REG_FRF_MSB, 0x6c }, { REG_FRF_MID, 0x80 }, { REG_FRF_LSB, 0x00 },
+    { REG_PA_CONFIG, 0x4f }, { 0x0a, 0x09 }, { REG_OCP, 0x2b }, { REG_LNA, 0x20 },
+    { REG_FIFO_TX_BASE_ADDR, 0x80 }, { REG_FIFO_RX_BASE_ADDR, 0x00 },
+    { REG_MODEM_CONFIG_1, 0x72 }, { REG_MODEM_CONFIG_2, 0x70 }, { REG_SYMB_TIMEOUT_LSB, 0x64 },
+    { REG_PREAMBLE_MSB, 0x00 }, { REG_PREAMBLE_LSB, 0x08 }, { REG_PAYLOAD_LENGTH, 0x01 },
+    { 0x23, 0xff }, { REG_MODEM_CONFIG_3, 0x00 },
+    { REG_DETECTION_OPTIMIZE, 0xc3 }, { REG_INVERTIQ, 0x27 }, { REG_DETECTION_THRESHOLD, 0x0a },
+    { REG_SYNC_WORD, 0x12 }, { REG_INVERTIQ2, 0x1d }, { REG_VERSION, 0x12 }, { REG_PA_DAC, 0x84 },
+};
+
+double sim_wideband_ones = 0.6;
+
+// Forward declarations of static functions
+static void write_reg(sim_node_t *node, uint8_t address, uint8_t value);
+static uint8_t read_reg(sim_node_t *node, uint8_t address);
+static void set_mode(sim_node_t *node, uint8_t value);
+static void enter_standby(sim_radio_t *radio);
+static void start_rx(sim_node_t *node, bool single);
+static void lock(sim_node_t *node, int tx, double power_dbm);
+static bool cad_detect(sim_node_t *node);
+static uint32_t symbol_us(const sim_radio_t *radio);
+static uint8_t mode_of(const sim_radio_t *radio);
+static bool lora_mode(const sim_radio_t *radio);
+static bool fsk_page(const sim_radio_t *radio, uint8_t address);
+static double current_rssi_dbm(const sim_node_t *node);
+static uint8_t rssi_offset(const sim_radio_t *radio);
+
+void sim_radio_reset(sim_radio_t *radio) {
+    if (radio->tx >= 0) {
+        sim_channel_end_tx(radio->tx);
+    }
+
+    memset(radio->regs, 0, sizeof(radio->regs));
+    memset(radio->fsk_regs, 0, sizeof(radio->fsk_regs));
+    memset(radio->fifo, 0, sizeof(radio->fifo));
+    for (size_t i = 0; i < sizeof(reset_values) / sizeof(reset_values[0]); i++) {
+        radio->regs[reset_values[i].address] = reset_values[i].value;
+    }
+
+    radio->selected = false;
+    radio->have_address = false;
+    radio->event_us = SIM_NO_EVENT;
+    radio->tx = -1;
+    radio->rx_lock = -1;
+    radio->rx_interference_mw = 0;
+}
+
+void sim_radio_select(sim_radio_t *radio, bool selected) {
+    radio->selected = selected;
+    radio->have_address = false;
+}
+
+// One full-duplex SPI byte: the first byte of a transaction is the address,
+// the rest are data with address auto-increment (except on the FIFO)
+uint8_t sim_radio_spi_byte(sim_node_t *node, uint8_t mosi) {
+    sim_radio_t *radio = &node->radio;
+    uint8_t miso = 0;
+
+    if (!radio->selected || radio->in_reset) {
+        return 0;
+    }
+
+    if (!radio->have_address) {
+        radio->address = mosi;
+        radio->have_address = true;
+        return 0;
+    }
+
+    uint8_t address = radio->address & 0x7f;
+    if (radio->address & 0x80) {
+        write_reg(node, address, mosi);
+    } else {
+        miso = read_reg(node, address);
+    }
+
+    if (address != REG_FIFO) {
+        radio->address = (radio->address & 0x80) | ((address + 1) & 0x7f);
+    }
+
+    return miso;
+}
+
+bool sim_radio_dio0(const sim_radio_t *radio) {
+    static const uint8_t dio0_source[4] = { IRQ_RX_DONE_MASK, IRQ_TX_DONE_MASK, IRQ_CAD_DONE_MASK, 0 };
+
+    return (radio->regs[REG_IRQ_FLAGS] & dio0_source[radio->regs[REG_DIO_MAPPING_1] >> 6]) != 0;
+}
+
+// Autonomous completion: TX done, RX timeout or CAD done
+void sim_radio_event(sim_node_t *node) {
+    sim_radio_t *radio = &node->radio;
+
+    radio->event_us = SIM_NO_EVENT;
+
+    switch (mode_of(radio)) {
+        case MODE_TX:
+            sim_channel_end_tx(radio->tx);
+            radio->tx = -1;
+            radio->regs[REG_IRQ_FLAGS] |= IRQ_TX_DONE_MASK;
+            enter_standby(radio);
+            break;
+
+        case MODE_RX_SINGLE:
+            if (radio->rx_lock < 0) {
+                radio->regs[REG_IRQ_FLAGS] |= IRQ_RX_TIMEOUT_MASK;
+                enter_standby(radio);
+            }
+            break;
+
+        case MODE_CAD:
+            radio->regs[REG_IRQ_FLAGS] |= IRQ_CAD_DONE_MASK;
+            if (cad_detect(node)) {
+                radio->regs[REG_IRQ_FLAGS] |= IRQ_CAD_DETECTED_MASK;
+            }
+            enter_standby(radio);
+            break;
+    }
+}
+
+lora_config_t sim_radio_config(const sim_radio_t *radio, bool *implicit_header) {
+    lora_config_t config;
+
+    memset(&config, 0, sizeof(config));
+    config.spreading_factor = radio->regs[REG_MODEM_CONFIG_2] >> 4;
+    config.signal_bandwidth = radio->regs[REG_MODEM_CONFIG_1] >> 4;
+    config.coding_rate = ((radio->regs[REG_MODEM_CONFIG_1] >> 1) & 0x07) + 4;
+    config.preamble_length = (radio->regs[REG_PREAMBLE_MSB] << 8) | radio->regs[REG_PREAMBLE_LSB];
+    config.crc_enabled = (radio->regs[REG_MODEM_CONFIG_2] & 0x04) != 0;
+    config.sync_word = radio->regs[REG_SYNC_WORD];
+    if (implicit_header) {
+        *implicit_header = (radio->regs[REG_MODEM_CONFIG_1] & 0x01) != 0;
+    }
+    return config;
+}
+
+uint32_t sim_radio_frf(const sim_radio_t *radio) {
+    return ((uint32_t)radio->regs[REG_FRF_MSB] << 16) | (radio->regs[REG_FRF_MID] << 8) | radio->regs[REG_FRF_LSB];
+}
+
+double sim_radio_power_dbm(const sim_radio_t *radio) {
+    uint8_t pa_config = radio->regs[REG_PA_CONFIG];
+
+    if (pa_config & PA_BOOST) {
+        double power = 2 + (pa_config & 0x0f);
+        if (radio->regs[REG_PA_DAC] == 0x87) {
+            power += 3;
+        }
+        return power;
+    }
+
+    double max_power = 10.8 + 0.6 * ((pa_config >> 4) & 0x07);
+    return max_power - (15 - (pa_config & 0x0f));
+}
+
+// A frame started on the channel
+void sim_radio_on_air_start(sim_node_t *node, int tx) {
+    sim_radio_t *radio = &node->radio;
+    sim_tx_t *frame = sim_channel_tx(tx);
+    uint8_t mode = mode_of(radio);
+
+    if ((mode != MODE_RX_CONTINUOUS && mode != MODE_RX_SINGLE) || !sim_channel_same_channel(frame, radio)) {
+        return;
+    }
+
+    double power = sim_channel_rx_power_dbm(tx, node);
+    bool decodable = power - sim_channel_noise_dbm(frame->bw) >= sim_channel_snr_limit_db(frame->sf) &&
+                     frame->sync_word == radio->regs[REG_SYNC_WORD];
+
+    if (radio->rx_lock < 0) {
+        if (decodable) {
+            lock(node, tx, power);
+        } else {
+            sim_channel_stats.below_sensitivity++;
+        }
+        return;
+    }
+
+    // A stronger frame arriving during the preamble captures the receiver
+    sim_tx_t *locked = sim_channel_tx(radio->rx_lock);
+    if (decodable && sim_now_us() < locked->preamble_end_us && power >= radio->rx_rssi_dbm + SIM_CAPTURE_DB) {
+        lock(node, tx, power);
+        return;
+    }
+
+    radio->rx_interference_mw += sim_dbm_to_mw(power);
+}
+
+// A frame left the channel
+void sim_radio_on_air_end(sim_node_t *node, int tx) {
+    sim_radio_t *radio = &node->radio;
+
+    if (radio->rx_lock != tx) {
+        return;
+    }
+
+    sim_tx_t *frame = sim_channel_tx(tx);
+    double power = radio->rx_rssi_dbm;
+    double noise = sim_channel_noise_dbm(frame->bw);
+    double snr = power - noise;
+    bool ok = snr >= sim_channel_snr_limit_db(frame->sf) && !frame->truncated &&
+              (radio->rx_interference_mw <= 0 ||
+               power - sim_mw_to_dbm(radio->rx_interference_mw) >= SIM_CAPTURE_DB);
+
+    radio->rx_lock = -1;
+    radio->rx_interference_mw = 0;
+
+    if (ok) {
+        uint8_t base = radio->regs[REG_FIFO_RX_BASE_ADDR];
+        for (int i = 0; i < frame->length; i++) {
+            radio->fifo[(uint8_t)(base + i)] = frame->payload[i];
+        }
+
+        int snr_q = (int)lround(snr * 4);
+        if (snr_q > 127) snr_q = 127;
+        if (snr_q < -128) snr_q = -128;
+        // Inverse of the datasheet correction lora_read_link_quality() applies
+        int rssi = snr >= 0 ? (int)lround((power + rssi_offset(radio)) * 15 / 16)
+                            : (int)lround(noise) + rssi_offset(radio);
+        if (rssi < 0) rssi = 0;
+        if (rssi > 255) rssi = 255;
+
+        radio->regs[REG_FIFO_RX_CURRENT_ADDR] = base;
+        radio->regs[REG_FIFO_RX_BYTE_ADDR] = (uint8_t)(base + frame->length);
+        radio->regs[REG_RX_NB_BYTES] = frame->length;
+        radio->regs[REG_PKT_SNR_VALUE] = (uint8_t)(int8_t)snr_q;
+        radio->regs[REG_PKT_RSSI_VALUE] = (uint8_t)rssi;
+        radio->regs[REG_HOP_CHANNEL] = frame->crc ? 0x40 : 0x00;
+        radio->regs[REG_IRQ_FLAGS] |= IRQ_VALID_HEADER_MASK | IRQ_RX_DONE_MASK;
+
+        sim_channel_stats.rx_ok++;
+        if (frame->collided) {
+            sim_channel_stats.rx_captured++;
+        }
+    } else {
+        sim_channel_stats.rx_corrupted++;
+        if (!frame->crc) {
+            // Header lost as well: nothing is reported, keep listening
+            return;
+        }
+        radio->regs[REG_RX_NB_BYTES] = frame->length;
+        radio->regs[REG_FIFO_RX_CURRENT_ADDR] = radio->regs[REG_FIFO_RX_BASE_ADDR];
+        radio->regs[REG_IRQ_FLAGS] |= IRQ_VALID_HEADER_MASK | IRQ_RX_DONE_MASK | IRQ_PAYLOAD_CRC_ERROR_MASK;
+    }
+
+    if (mode_of(radio) == MODE_RX_SINGLE) {
+        enter_standby(radio);
+    }
+}
+
+// Private functions
+static void write_reg(sim_node_t *node, uint8_t address, uint8_t value) {
+    sim_radio_t *radio = &node->radio;
+
+    if (fsk_page(radio, address)) {
+        radio->fsk_regs[address] = value;
+        return;
+    }
+
+    switch (address) {
+        case REG_FIFO:
+            radio->fifo[radio->regs[REG_FIFO_ADDR_PTR]++] = value;
+            break;
+        case REG_OP_MODE:
+            set_mode(node, value);
+            break;
+        case REG_IRQ_FLAGS:
+            radio->regs[REG_IRQ_FLAGS] &= ~value;
+            break;
+        case REG_FIFO_RX_CURRENT_ADDR:
+        case REG_RX_NB_BYTES:
+        case 0x14: case 0x15: case 0x16: case 0x17:
+        case REG_MODEM_STAT: case REG_PKT_SNR_VALUE: case REG_PKT_RSSI_VALUE:
+        case REG_RSSI_VALUE: case REG_HOP_CHANNEL: case REG_FIFO_RX_BYTE_ADDR:
+        case REG_FREQ_ERROR_MSB: case REG_FREQ_ERROR_MID: case REG_FREQ_ERROR_LSB:
+        case REG_RSSI_WIDEBAND: case REG_VERSION:
+            // Read only
+            break;
+        default:
+            radio->regs[address] = value;
+            break;
+    }
+}
+
+static uint8_t read_reg(sim_node_t *node, uint8_t address) {
+    sim_radio_t *radio = &node->radio;
+
+    if (fsk_page(radio, address)) {
+        return radio->fsk_regs[address];
+    }
+
+    switch (address) {
+        case REG_FIFO:
+            return radio->fifo[radio->regs[REG_FIFO_ADDR_PTR]++];
+        case REG_RSSI_VALUE: {
+            int rssi = (int)lround(current_rssi_dbm(node)) + rssi_offset(radio);
+            return rssi < 0 ? 0 : rssi > 255 ? 255 : (uint8_t)rssi;
+        }
+        case REG_RSSI_WIDEBAND:
+            return (uint8_t)((sim_random() & 0xfe) | (sim_random_uniform() < sim_wideband_ones));
+        default:
+            return radio->regs[address];
+    }
+}
+
+static void set_mode(sim_node_t *node, uint8_t value) {
+    sim_radio_t *radio = &node->radio;
+    uint8_t old_mode = mode_of(radio);
+    uint8_t mode = value & 0x07;
+
+    radio->regs[REG_OP_MODE] = value;
+    if (mode == old_mode) {
+        return;
+    }
+
+    // Leaving the old mode aborts whatever it was doing
+    if (old_mode == MODE_TX && radio->tx >= 0) {
+        sim_channel_end_tx(radio->tx);
+        radio->tx = -1;
+    }
+    radio->rx_lock = -1;
+    radio->rx_interference_mw = 0;
+    radio->event_us = SIM_NO_EVENT;
+
+    // The FSK modem is not simulated
+    if (!lora_mode(radio)) {
+        return;
+    }
+
+    bool implicit_header;
+    lora_config_t config = sim_radio_config(radio, &implicit_header);
+
+    switch (mode) {
+        case MODE_TX: {
+            uint32_t airtime = lora_time_on_air_us(&config, implicit_header, radio->regs[REG_PAYLOAD_LENGTH]);
+            radio->tx = sim_channel_start_tx(node, airtime);
+            radio->event_us = sim_now_us() + airtime;
+            break;
+        }
+        case MODE_RX_CONTINUOUS:
+            start_rx(node, false);
+            break;
+        case MODE_RX_SINGLE:
+            start_rx(node, true);
+            break;
+        case MODE_CAD:
+            // Channel activity detection takes about two symbols
+            radio->cad_start_us = sim_now_us();
+            radio->event_us = sim_now_us() + 2 * symbol_us(radio);
+            break;
+    }
+}
+
+static void enter_standby(sim_radio_t *radio) {
+    radio->regs[REG_OP_MODE] = (radio->regs[REG_OP_MODE] & 0xf8) | MODE_STDBY;
+    radio->rx_lock = -1;
+    radio->rx_interference_mw = 0;
+}
+
+static void start_rx(sim_node_t *node, bool single) {
+    sim_radio_t *radio = &node->radio;
+    uint32_t tsym = symbol_us(radio);
+
+    if (single) {
+        uint32_t timeout = ((radio->regs[REG_MODEM_CONFIG_2] & 0x03) << 8) | radio->regs[REG_SYMB_TIMEOUT_LSB];
+        radio->event_us = sim_now_us() + (uint64_t)timeout * tsym;
+    }
+
+    // Frames already on air can still be picked up during their preamble
+    for (int tx = 0; tx < SIM_MAX_TRANSMISSIONS; tx++) {
+        sim_tx_t *frame = sim_channel_tx(tx);
+        if (!frame->on_air || frame->node == node->id || !sim_channel_same_channel(frame, radio)) {
+            continue;
+        }
+
+        double power = sim_channel_rx_power_dbm(tx, node);
+        bool decodable = power - sim_channel_noise_dbm(frame->bw) >= sim_channel_snr_limit_db(frame->sf) &&
+                         frame->sync_word == radio->regs[REG_SYNC_WORD];
+
+        if (radio->rx_lock < 0 && decodable && sim_now_us() + 5 * tsym <= frame->preamble_end_us) {
+            lock(node, tx, power);
+        } else if (radio->rx_lock >= 0) {
+            radio->rx_interference_mw += sim_dbm_to_mw(power);
+        }
+    }
+}
+
+static void lock(sim_node_t *node, int tx, double power_dbm) {
+    sim_radio_t *radio = &node->radio;
+
+    radio->rx_lock = tx;
+    radio->rx_rssi_dbm = power_dbm;
+    radio->rx_interference_mw = sim_channel_interference_mw(node, tx);
+
+    // A receiving radio no longer times out
+    radio->event_us = SIM_NO_EVENT;
+}
+
+static bool cad_detect(sim_node_t *node) {
+    sim_radio_t *radio = &node->radio;
+
+    for (int tx = 0; tx < SIM_MAX_TRANSMISSIONS; tx++) {
+        sim_tx_t *frame = sim_channel_tx(tx);
+        if (!frame->used || frame->node == node->id || !sim_channel_same_channel(frame, radio)) {
+            continue;
+        }
+        if (frame->start_us >= sim_now_us() || (!frame->on_air && frame->end_us <= radio->cad_start_us)) {
+            continue;
+        }
+        double snr = sim_channel_rx_power_dbm(tx, node) - sim_channel_noise_dbm(frame->bw);
+        if (snr >= sim_channel_snr_limit_db(frame->sf)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint32_t symbol_us(const sim_radio_t *radio) {
+    uint32_t bandwidth = lora_bandwidth_hz(radio->regs[REG_MODEM_CONFIG_1] >> 4);
+    uint8_t sf = radio->regs[REG_MODEM_CONFIG_2] >> 4;
+
+    if (bandwidth == 0) {
+        return 1000;
+    }
+    return (uint32_t)(((uint64_t)1000000 << sf) / bandwidth);
+}
+
+static uint8_t mode_of(const sim_radio_t *radio) {
+    return radio->regs[REG_OP_MODE] & 0x07;
+}
+
+static bool lora_mode(const sim_radio_t *radio) {
+    return (radio->regs[REG_OP_MODE] & MODE_LONG_RANGE_MODE) != 0;
+}
+
+static bool fsk_page(const sim_radio_t *radio, uint8_t address) {
+    return !lora_mode(radio) && address >= REG_PAGE_FIRST && address <= REG_PAGE_LAST;
+}
+
+static double current_rssi_dbm(const sim_node_t *node) {
+    const sim_radio_t *radio = &node->radio;
+    double noise = sim_channel_noise_dbm(radio->regs[REG_MODEM_CONFIG_1] >> 4);
+
+    return sim_mw_to_dbm(sim_dbm_to_mw(noise) + sim_channel_interference_mw(node, -1));
+}
+
+// Same band split as lora_rssi(): 157 for the HF port, 164 for LF
+static uint8_t rssi_offset(const sim_radio_t *radio) {
+    uint64_t frequency = ((uint64_t)sim_radio_frf(radio) * 32000000) >> 19;
+    return frequency < 868000000 ? 164 : 157;
+}
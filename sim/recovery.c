@@ -0,0 +1,152 @@
+// Recovery harness: each fault is injected straight into the virtual
+// radio's registers, then the recovery action and its latency are checked
+// against the bounds documented in lora.h.
+
+#include "recovery.h"
+#include "check.h"
+#include "lora_stats.h"
+#include "lora_tdma.h"
+
+#define POLL_US                 100
+
+// Recovery without a reset is SPI traffic only
+#define REGISTER_BOUND_US       1000
+#define RESET_BOUND_US          (LORA_RESET_PULSE_US + LORA_RESET_TIMEOUT_US + REGISTER_BOUND_US)
+
+// Forward declarations of static functions
+static int check_recovery(const char *name, lora_ctx_t *ctx, lora_recovery_t expected, uint32_t bound_us);
+static const char *action_name(lora_recovery_t action);
+static int tdma_lost_tx_done(sim_node_t *node);
+
+int sim_recovery_run(void) {
+    int failures = 0;
+
+    sim_node_t *node = sim_check_setup(1, 1, false);
+    if (!node) {
+        return 1;
+    }
+    lora_ctx_t *ctx = &node->lora;
+    sim_radio_t *radio = &node->radio;
+
+    lora_set_spreading_factor(ctx, 9);
+    lora_set_sync_word(ctx, 0x34);
+    lora_enable_crc(ctx);
+    lora_enable_recovery(ctx);
+
+    // Registers drift (brown-out, bus noise): rewritten from the checkpoint
+    radio->regs[REG_SYNC_WORD] = 0x12;
+    radio->regs[REG_MODEM_CONFIG_2] ^= 0x04;
+    lora_recover(ctx);
+    failures += check_recovery("drifted config", ctx, LORA_RECOVERY_REPROGRAMMED, REGISTER_BOUND_US);
+    failures += sim_check("config restored", lora_read_register(ctx, REG_SYNC_WORD) == 0x34 &&
+                                             lora_checkpoint_matches(ctx, &ctx->recovery), NULL);
+
+    // Radio stops answering: reset, then rewritten
+    radio->regs[REG_VERSION] = 0x00;
+    radio->regs[REG_SYNC_WORD] = 0x00;
+    lora_recover(ctx);
+    failures += check_recovery("zeroed version", ctx, LORA_RECOVERY_RESET, RESET_BOUND_US);
+    failures += sim_check("config after reset", lora_read_register(ctx, REG_VERSION) == 0x12 &&
+                                                lora_checkpoint_matches(ctx, &ctx->recovery), NULL);
+
+    // TX the driver never started: given the longest packet's deadline,
+    // then aborted
+    uint32_t bound_us = 2 * lora_packet_time_on_air_us(ctx, MAX_PKT_LENGTH) + LORA_TX_TIMEOUT_MARGIN_US +
+                        REGISTER_BOUND_US + POLL_US;
+    uint32_t count = ctx->recovery_count;
+    uint64_t start_us = time_us_64();
+    radio->regs[REG_OP_MODE] = MODE_LONG_RANGE_MODE | MODE_TX;
+    while (lora_is_transmitting(ctx) && time_us_64() - start_us < 2ULL * bound_us) {
+        sleep_us(POLL_US);
+    }
+    uint32_t stuck_us = (uint32_t)(time_us_64() - start_us);
+    failures += sim_check("spurious tx", ctx->recovery_count == count + 1 && stuck_us <= bound_us,
+                          "cleared after %lu us, bound %lu us", (unsigned long)stuck_us, (unsigned long)bound_us);
+    failures += check_recovery("spurious tx action", ctx, LORA_RECOVERY_VERIFIED, REGISTER_BOUND_US);
+
+    // CAD shares the TX mode bits; polling through a long CAD must not
+    // arm a TX deadline or recover
+    count = ctx->recovery_count;
+    for (int i = 0; i < 20; i++) {
+        radio->regs[REG_OP_MODE] = MODE_LONG_RANGE_MODE | MODE_CAD;
+        lora_is_transmitting(ctx);
+        sleep_us(bound_us / 10);
+    }
+    failures += sim_check("cad is not tx", ctx->recovery_count == count && ctx->tx_deadline_us == 0,
+                          "%lu recoveries", (unsigned long)(ctx->recovery_count - count));
+    lora_idle(ctx);
+
+    failures += tdma_lost_tx_done(node);
+    return failures;
+}
+
+// Private functions
+static int check_recovery(const char *name, lora_ctx_t *ctx, lora_recovery_t expected, uint32_t bound_us) {
+    const lora_recovery_event_t *event = lora_last_recovery(ctx);
+
+    return sim_check(name, event->action == expected && event->duration_us <= bound_us, "%s in %lu us, bound %lu us",
+                     action_name(event->action), (unsigned long)event->duration_us, (unsigned long)bound_us);
+}
+
+static const char *action_name(lora_recovery_t action) {
+    static const char *const names[] = { "none", "verified", "reprogrammed", "reset", "failed" };
+    return action <= LORA_RECOVERY_FAILED ? names[action] : "?";
+}
+
+// A TDMA coordinator whose beacon never signals TX done: the poll must hit
+// the deadline lora_end_packet_at armed, recover, and carry on beaconing
+static int tdma_lost_tx_done(sim_node_t *node) {
+    static const lora_tdma_config_t config = {
+        .superframe_us = 2000000, .slot_count = 4, .max_payload = 16, .min_guard_us = 2000, .max_drift_ppm = 40,
+    };
+    lora_ctx_t *ctx = &node->lora;
+    lora_tdma_t tdma;
+    lora_stats_t stats;
+    int failures = 0;
+
+    lora_stats_init(&stats, ctx);
+    if (!lora_tdma_begin(&tdma, ctx, &config, LORA_TDMA_COORDINATOR)) {
+        return 1;
+    }
+
+    // First beacon completes normally
+    while (tdma.stats.beacons_tx == 0 || tdma.tx_active) {
+        lora_tdma_poll(&tdma);
+        sleep_us(POLL_US);
+    }
+    failures += sim_check("tdma tx done", stats.tx_done == 1 && ctx->tx_done_us != 0, "%lu recorded",
+                          (unsigned long)stats.tx_done);
+
+    // Second beacon: the radio stays in TX and never raises the flag
+    while (tdma.stats.beacons_tx == 1) {
+        lora_tdma_poll(&tdma);
+        sleep_us(POLL_US);
+    }
+    node->radio.event_us = SIM_NO_EVENT;
+
+    uint32_t bound_us = 2 * lora_packet_time_on_air_us(ctx, LORA_TDMA_BEACON_LENGTH) + LORA_TX_TIMEOUT_MARGIN_US +
+                        REGISTER_BOUND_US + POLL_US;
+    uint32_t count = ctx->recovery_count;
+    uint64_t start_us = ctx->tx_start_us;
+    while (tdma.tx_active && time_us_64() - start_us < 2ULL * bound_us) {
+        lora_tdma_poll(&tdma);
+        sleep_us(POLL_US);
+    }
+    uint32_t stuck_us = (uint32_t)(time_us_64() - start_us);
+    failures += sim_check("tdma lost tx done", !tdma.tx_active && ctx->recovery_count == count + 1 &&
+                          stats.tx_timeouts == 1 && stuck_us <= bound_us, "cleared after %lu us, bound %lu us",
+                          (unsigned long)stuck_us, (unsigned long)bound_us);
+
+    // The next superframe's beacon goes out and completes
+    uint64_t deadline_us = time_us_64() + 2ULL * config.superframe_us;
+    while ((tdma.stats.beacons_tx < 3 || tdma.tx_active) && time_us_64() < deadline_us) {
+        lora_tdma_poll(&tdma);
+        sleep_us(POLL_US);
+    }
+    failures += sim_check("tdma resumes", tdma.stats.beacons_tx == 3 && !tdma.tx_active && stats.tx_done == 2,
+                          "%lu beacons", (unsigned long)tdma.stats.beacons_tx);
+
+    lora_idle(ctx);
+    ctx->stats = NULL;
+    return failures;
+}
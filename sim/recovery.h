@@ -0,0 +1,9 @@
+#ifndef SIM_RECOVERY_H
+#define SIM_RECOVERY_H
+
+// Fault injection for lora_recover: drifted configuration, a radio that
+// stops answering, a TX the driver never started, and a CAD that must not
+// be mistaken for one. Returns the number of failed checks.
+int sim_recovery_run(void);
+
+#endif // SIM_RECOVERY_H
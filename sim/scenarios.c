@@ -0,0 +1,411 @@
+// Traffic scenarios run against the real driver and protocol modules:
+// pure ALOHA star, TDMA star with drifting clocks, and a managed-flooding line.
+
+#include "scenarios.h"
+#include "sim.h"
+#include "lora_tdma.h"
+#include "lora_mesh.h"
+#include "lora_stats.h"
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_MAX_QUEUE           64
+#define SIM_DRAIN_US            5000000     // Run on without new traffic so queues empty
+
+// Per-node application state
+typedef struct {
+    uint64_t next_arrival_us;
+    uint32_t queue[SIM_MAX_QUEUE];      // Enqueue times (global us)
+    int queue_head;
+    int queue_count;
+    uint16_t seq;
+    lora_tdma_t tdma;
+    lora_mesh_t mesh;
+} node_app_t;
+
+static node_app_t apps[SIM_MAX_NODES];
+static lora_stats_t gateway_stats;
+static uint8_t seen[SIM_MAX_NODES][65536 / 8];
+static const sim_options_t *options;
+static sim_report_t *report;
+static uint64_t traffic_end_us;
+
+// Forward declarations of static functions
+static bool setup_radio(sim_node_t *node);
+static void place_star(void);
+static void place_line(void);
+static void generate(sim_node_t *node);
+static uint8_t build_payload(sim_node_t *node, uint8_t *buffer);
+static void dequeue(sim_node_t *node);
+static void deliver(const uint8_t *payload, int length);
+static void poll_aloha(sim_node_t *node);
+static void poll_tdma(sim_node_t *node);
+static void poll_mesh(sim_node_t *node);
+static bool setup_tdma(void);
+static bool setup_mesh(void);
+static void summarize_aloha(void);
+static void summarize_tdma(void);
+static void summarize_mesh(void);
+
+void sim_options_default(sim_options_t *o, sim_scenario_t scenario) {
+    memset(o, 0, sizeof(sim_options_t));
+    o->scenario = scenario;
+    o->nodes = scenario == SIM_SCENARIO_MESH ? 4 : 20;
+    o->duration_s = 600;
+    o->rate_per_min = 1;
+    o->sf = 7;
+    o->payload = 20;
+    o->seed = 1;
+    o->drift_ppm = 20;
+    o->radius_m = scenario == SIM_SCENARIO_MESH ? 8000 : 2000;
+    o->path_loss_exponent = 2.7;
+    o->shadowing_db = 0;
+    o->tick_us = 200;
+    o->queue = 8;
+}
+
+bool sim_run(const sim_options_t *o, sim_report_t *r) {
+    sim_channel_config_t channel = {
+        .path_loss_exponent = o->path_loss_exponent,
+        .shadowing_db = o->shadowing_db,
+        .seed = o->seed,
+    };
+    void (*poll)(sim_node_t *node);
+
+    options = o;
+    report = r;
+    memset(r, 0, sizeof(sim_report_t));
+    memset(apps, 0, sizeof(apps));
+    memset(seen, 0, sizeof(seen));
+
+    if (o->nodes < 2 || o->nodes > SIM_MAX_NODES || o->payload < SIM_PAYLOAD_HEADER || o->queue > SIM_MAX_QUEUE) {
+        return false;
+    }
+
+    sim_init(&channel);
+    if (o->scenario == SIM_SCENARIO_MESH) {
+        place_line();
+    } else {
+        place_star();
+    }
+
+    for (int i = 0; i < sim_node_count; i++) {
+        if (!setup_radio(&sim_nodes[i])) {
+            return false;
+        }
+    }
+
+    switch (o->scenario) {
+        case SIM_SCENARIO_TDMA:
+            if (!setup_tdma()) {
+                return false;
+            }
+            poll = poll_tdma;
+            break;
+        case SIM_SCENARIO_MESH:
+            if (!setup_mesh()) {
+                return false;
+            }
+            poll = poll_mesh;
+            break;
+        default:
+            poll = poll_aloha;
+            break;
+    }
+    if (o->scenario == SIM_SCENARIO_ALOHA) {
+        lora_stats_init(&gateway_stats, &sim_nodes[0].lora);
+    }
+
+    // Statistics cover the traffic phase only, not radio bring-up
+    memset(&sim_channel_stats, 0, sizeof(sim_channel_stats));
+    uint64_t start_us = sim_now_us();
+    traffic_end_us = start_us + (uint64_t)(o->duration_s * 1e6);
+
+    for (int i = 1; i < sim_node_count; i++) {
+        apps[i].next_arrival_us = o->rate_per_min > 0
+            ? start_us + (uint64_t)sim_random_exponential(60e6 / o->rate_per_min)
+            : SIM_NO_EVENT;
+    }
+
+    uint64_t end_us = traffic_end_us + SIM_DRAIN_US;
+    if (o->scenario == SIM_SCENARIO_TDMA) {
+        end_us += 2 * (uint64_t)apps[0].tdma.config.superframe_us;
+    }
+
+    while (sim_now_us() < end_us) {
+        for (int i = 0; i < sim_node_count; i++) {
+            sim_select(&sim_nodes[i]);
+            poll(&sim_nodes[i]);
+        }
+        sim_select(NULL);
+        sim_advance_to(sim_now_us() + o->tick_us);
+    }
+
+    if (o->scenario == SIM_SCENARIO_ALOHA) {
+        summarize_aloha();
+    } else if (o->scenario == SIM_SCENARIO_TDMA) {
+        summarize_tdma();
+    } else if (o->scenario == SIM_SCENARIO_MESH) {
+        summarize_mesh();
+    }
+    return true;
+}
+
+void sim_report_free(sim_report_t *r) {
+    free(r->latency_us);
+    r->latency_us = NULL;
+    r->latency_count = 0;
+    r->latency_capacity = 0;
+}
+
+// Private functions
+static bool setup_radio(sim_node_t *node) {
+    sim_select(node);
+    if (!lora_begin(&node->lora, SIM_FREQUENCY)) {
+        return false;
+    }
+    lora_set_spreading_factor(&node->lora, options->sf);
+    lora_enable_crc(&node->lora);
+    lora_idle(&node->lora);
+    return true;
+}
+
+// Gateway at the origin, nodes uniformly over a disc
+static void place_star(void) {
+    sim_add_node(0, 0, (2 * sim_random_uniform() - 1) * options->drift_ppm);
+    for (int i = 1; i < options->nodes; i++) {
+        double radius = options->radius_m * sqrt(sim_random_uniform());
+        double angle = 2 * M_PI * sim_random_uniform();
+        sim_add_node(radius * cos(angle), radius * sin(angle), (2 * sim_random_uniform() - 1) * options->drift_ppm);
+    }
+}
+
+// Sink at one end of a line of relays
+static void place_line(void) {
+    for (int i = 0; i < options->nodes; i++) {
+        sim_add_node(i * options->radius_m, 0, (2 * sim_random_uniform() - 1) * options->drift_ppm);
+    }
+}
+
+// Poisson arrivals into a bounded queue
+static void generate(sim_node_t *node) {
+    node_app_t *app = &apps[node->id];
+    uint64_t now = sim_now_us();
+
+    while (app->next_arrival_us <= now && app->next_arrival_us < traffic_end_us) {
+        report->offered++;
+        if (app->queue_count < options->queue) {
+            app->queue[(app->queue_head + app->queue_count) % SIM_MAX_QUEUE] = (uint32_t)app->next_arrival_us;
+            app->queue_count++;
+        } else {
+            report->queue_drops++;
+        }
+        app->next_arrival_us += (uint64_t)sim_random_exponential(60e6 / options->rate_per_min) + 1;
+    }
+}
+
+static uint8_t build_payload(sim_node_t *node, uint8_t *buffer) {
+    node_app_t *app = &apps[node->id];
+    uint32_t enqueued = app->queue[app->queue_head];
+
+    buffer[0] = (uint8_t)node->id;
+    buffer[1] = (uint8_t)(app->seq >> 0);
+    buffer[2] = (uint8_t)(app->seq >> 8);
+    for (int i = 0; i < 4; i++) {
+        buffer[3 + i] = (uint8_t)(enqueued >> (8 * i));
+    }
+    memset(&buffer[SIM_PAYLOAD_HEADER], 0xa5, options->payload - SIM_PAYLOAD_HEADER);
+    return (uint8_t)options->payload;
+}
+
+static void dequeue(sim_node_t *node) {
+    node_app_t *app = &apps[node->id];
+
+    app->queue_head = (app->queue_head + 1) % SIM_MAX_QUEUE;
+    app->queue_count--;
+    app->seq++;
+}
+
+static void deliver(const uint8_t *payload, int length) {
+    if (length < SIM_PAYLOAD_HEADER) {
+        return;
+    }
+
+    uint8_t origin = payload[0];
+    uint16_t seq = payload[1] | (payload[2] << 8);
+    uint32_t enqueued = payload[3] | (payload[4] << 8) | (payload[5] << 16) | ((uint32_t)payload[6] << 24);
+
+    if (seen[origin][seq >> 3] & (1 << (seq & 7))) {
+        report->duplicates++;
+        return;
+    }
+    seen[origin][seq >> 3] |= 1 << (seq & 7);
+
+    report->delivered++;
+    report->delivered_bytes += length;
+
+    if (report->latency_count == report->latency_capacity) {
+        report->latency_capacity = report->latency_capacity ? 2 * report->latency_capacity : 1024;
+        report->latency_us = realloc(report->latency_us, report->latency_capacity * sizeof(uint32_t));
+    }
+    report->latency_us[report->latency_count++] = (uint32_t)sim_now_us() - enqueued;
+}
+
+// Pure ALOHA: send as soon as the radio is free, gateway listens
+static void poll_aloha(sim_node_t *node) {
+    node_app_t *app = &apps[node->id];
+    lora_ctx_t *ctx = &node->lora;
+    uint8_t buffer[MAX_PKT_LENGTH];
+
+    if (node->id == 0) {
+        int length = lora_parse_packet(ctx, 0);
+        if (length > 0) {
+            lora_read_bytes(ctx, buffer, length);
+            deliver(buffer, length);
+        }
+        return;
+    }
+
+    generate(node);
+    if (app->queue_count > 0 && !lora_is_transmitting(ctx)) {
+        uint8_t length = build_payload(node, buffer);
+        lora_begin_packet(ctx, false);
+        lora_write(ctx, buffer, length);
+        lora_end_packet(ctx, true);
+        dequeue(node);
+    }
+}
+
+// Superframe sized for one slot per node plus drift guards
+static bool setup_tdma(void) {
+    lora_tdma_config_t config = {
+        .slot_count = (uint8_t)(options->nodes - 1),
+        .max_payload = (uint8_t)options->payload,
+        .min_guard_us = 1000 + 2 * options->tick_us,
+        .max_drift_ppm = (uint16_t)ceil(2 * options->drift_ppm) + 5,
+        .network_id = 0x42,
+    };
+    const lora_config_t *radio = &sim_nodes[0].lora.config;
+    double beacon = lora_time_on_air_us(radio, false, LORA_TDMA_BEACON_LENGTH);
+    double slot = lora_time_on_air_us(radio, false, LORA_TDMA_DATA_HEADER + config.max_payload);
+    double fixed = beacon + 2.0 * config.min_guard_us + config.slot_count * (slot + 2.0 * config.min_guard_us);
+    double scale = 1.0 - (2.0 * config.slot_count + 2) * config.max_drift_ppm * 1e-6;
+
+    if (options->nodes - 1 > 255 || scale <= 0) {
+        return false;
+    }
+    config.superframe_us = (uint32_t)ceil(fixed / scale) + 1000;
+
+    for (int i = 0; i < sim_node_count; i++) {
+        sim_select(&sim_nodes[i]);
+        if (!lora_tdma_begin(&apps[i].tdma, &sim_nodes[i].lora, &config, i == 0 ? LORA_TDMA_COORDINATOR : i - 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void poll_tdma(sim_node_t *node) {
+    node_app_t *app = &apps[node->id];
+    uint8_t buffer[MAX_PKT_LENGTH];
+
+    int length = lora_tdma_poll(&app->tdma);
+    if (node->id == 0) {
+        if (length > 0) {
+            lora_read_bytes(&node->lora, buffer, length);
+            deliver(buffer, length);
+        }
+        return;
+    }
+
+    generate(node);
+    if (app->queue_count > 0 && !app->tdma.tx_pending) {
+        uint8_t size = build_payload(node, buffer);
+        if (lora_tdma_send(&app->tdma, buffer, size)) {
+            dequeue(node);
+        }
+    }
+}
+
+// Gateway packet accounting from lora_stats
+static void summarize_aloha(void) {
+    const lora_stats_t *st = &gateway_stats;
+    uint8_t exported[512];
+
+    snprintf(report->detail, sizeof(report->detail),
+             "gateway rx ok %lu, crc errors %lu, header errors %lu, per %u/1000, stats export %zu bytes",
+             (unsigned long)st->rx_ok, (unsigned long)st->rx_crc_errors, (unsigned long)st->rx_header_errors,
+             lora_stats_per_permille(st), lora_stats_export(st, exported, sizeof(exported)));
+}
+
+static void summarize_tdma(void) {
+    lora_tdma_stats_t total;
+
+    memset(&total, 0, sizeof(total));
+    for (int i = 1; i < sim_node_count; i++) {
+        const lora_tdma_stats_t *st = &apps[i].tdma.stats;
+        total.beacons_rx += st->beacons_rx;
+        total.beacons_missed += st->beacons_missed;
+        total.sync_lost += st->sync_lost;
+        total.frames_tx += st->frames_tx;
+        total.slots_skipped += st->slots_skipped;
+    }
+
+    snprintf(report->detail, sizeof(report->detail),
+             "tdma superframe %lu us, beacons tx %lu rx %lu missed %lu, sync lost %lu, frames tx %lu, slots skipped %lu",
+             (unsigned long)apps[0].tdma.config.superframe_us, (unsigned long)apps[0].tdma.stats.beacons_tx,
+             (unsigned long)total.beacons_rx, (unsigned long)total.beacons_missed, (unsigned long)total.sync_lost,
+             (unsigned long)total.frames_tx, (unsigned long)total.slots_skipped);
+}
+
+// Every node relays at up to 10% duty cycle
+static bool setup_mesh(void) {
+    for (int i = 0; i < sim_node_count; i++) {
+        sim_select(&sim_nodes[i]);
+        lora_mesh_init(&apps[i].mesh, &sim_nodes[i].lora, (uint8_t)i, 100, 5000000);
+    }
+    return true;
+}
+
+static void poll_mesh(sim_node_t *node) {
+    node_app_t *app = &apps[node->id];
+    uint8_t buffer[MAX_PKT_LENGTH];
+
+    int length = lora_mesh_poll(&app->mesh);
+    if (node->id == 0) {
+        if (length > 0) {
+            deliver(lora_mesh_payload(&app->mesh), length);
+        }
+        return;
+    }
+
+    generate(node);
+    if (app->queue_count > 0) {
+        uint8_t size = build_payload(node, buffer);
+        if (lora_mesh_send(&app->mesh, 0, buffer, size)) {
+            dequeue(node);
+        }
+    }
+}
+
+static void summarize_mesh(void) {
+    lora_mesh_stats_t total;
+
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < sim_node_count; i++) {
+        const lora_mesh_stats_t *st = &apps[i].mesh.stats;
+        total.relayed += st->relayed;
+        total.suppressed += st->suppressed;
+        total.duplicates += st->duplicates;
+        total.ttl_expired += st->ttl_expired;
+        total.rate_limited += st->rate_limited;
+        total.queue_full += st->queue_full;
+    }
+
+    snprintf(report->detail, sizeof(report->detail),
+             "mesh relayed %lu, suppressed %lu, duplicates %lu, ttl expired %lu, rate limited %lu, relay queue full %lu",
+             (unsigned long)total.relayed, (unsigned long)total.suppressed, (unsigned long)total.duplicates,
+             (unsigned long)total.ttl_expired, (unsigned long)total.rate_limited, (unsigned long)total.queue_full);
+}
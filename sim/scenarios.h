@@ -0,0 +1,48 @@
+#ifndef SIM_SCENARIOS_H
+#define SIM_SCENARIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Application payload header: origin, sequence (LE16), enqueue time (LE32, global us)
+#define SIM_PAYLOAD_HEADER      7
+
+typedef enum {
+    SIM_SCENARIO_ALOHA,
+    SIM_SCENARIO_TDMA,
+    SIM_SCENARIO_MESH,
+} sim_scenario_t;
+
+typedef struct {
+    sim_scenario_t scenario;
+    int nodes;                  // Including the gateway / coordinator / sink
+    double duration_s;
+    double rate_per_min;        // Offered frames per node per minute
+    int sf;
+    int payload;                // Application payload bytes
+    uint32_t seed;
+    double drift_ppm;           // Max clock error per node
+    double radius_m;            // Star: node placement radius; mesh: hop spacing
+    double path_loss_exponent;
+    double shadowing_db;
+    uint32_t tick_us;           // Firmware poll period
+    int queue;                  // Frames a node buffers before dropping
+} sim_options_t;
+
+typedef struct {
+    uint32_t offered;
+    uint32_t queue_drops;
+    uint32_t delivered;
+    uint32_t duplicates;
+    uint64_t delivered_bytes;
+    uint32_t *latency_us;       // One entry per delivered frame
+    uint32_t latency_count;
+    uint32_t latency_capacity;
+    char detail[256];           // Scenario-specific summary line
+} sim_report_t;
+
+void sim_options_default(sim_options_t *options, sim_scenario_t scenario);
+bool sim_run(const sim_options_t *options, sim_report_t *report);
+void sim_report_free(sim_report_t *report);
+
+#endif // SIM_SCENARIOS_H
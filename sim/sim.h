@@ -0,0 +1,151 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lora.h"
+
+// Capacity
+#define SIM_MAX_NODES           256
+#define SIM_MAX_TRANSMISSIONS   1024    // Concurrently tracked on-air and recent frames
+
+// Pins the driver uses (must match lora.c)
+#define SIM_SS_PIN              8
+#define SIM_RESET_PIN           9
+
+// Frequency the scenarios and check harnesses run on
+#define SIM_FREQUENCY           868100000
+
+// Channel model defaults
+#define SIM_NOISE_FIGURE_DB     6.0
+#define SIM_CAPTURE_DB          6.0     // Margin needed to survive a collision
+#define SIM_PATH_LOSS_D0_DB     31.2    // Free space loss at 1 m, 868 MHz
+#define SIM_NO_EVENT            UINT64_MAX
+
+// Virtual SX127x in LoRa mode, driven through its SPI register interface
+typedef struct {
+    uint8_t regs[128];
+    uint8_t fsk_regs[128];      // Only 0x0d-0x3f, the FSK page; storage only
+    uint8_t fifo[256];
+
+    // SPI transaction state
+    bool selected;
+    bool have_address;
+    uint8_t address;
+
+    bool in_reset;
+
+    // Modem state
+    uint64_t event_us;          // Next autonomous event (TX done, RX timeout, CAD done)
+    int tx;                     // Transmission being sent, -1 when none
+    int rx_lock;                // Transmission being received, -1 when none
+    double rx_rssi_dbm;
+    double rx_interference_mw;
+    uint64_t cad_start_us;
+} sim_radio_t;
+
+// One simulated node: position, clock, radio and the real driver context
+typedef struct {
+    int id;
+    double x;
+    double y;
+    double clock_ppm;           // Local clock error
+    int64_t clock_offset_us;
+    sim_radio_t radio;
+    lora_ctx_t lora;
+    void *app;                  // Scenario state
+} sim_node_t;
+
+// A frame on the shared channel
+typedef struct {
+    bool used;
+    bool on_air;
+    int node;
+    uint64_t start_us;
+    uint64_t end_us;
+    uint64_t preamble_end_us;
+    uint32_t frf;
+    uint8_t sf;
+    uint8_t bw;
+    uint8_t sync_word;
+    double power_dbm;
+    bool crc;
+    bool collided;              // Overlapped another frame on the same channel
+    bool truncated;             // Sender left TX before the frame finished
+    uint8_t length;
+    uint8_t payload[256];
+} sim_tx_t;
+
+// Channel-wide counters
+typedef struct {
+    uint32_t transmissions;
+    uint32_t collided;
+    uint32_t rx_ok;
+    uint32_t rx_corrupted;      // Lost to interference
+    uint32_t rx_captured;       // Survived a collision through capture
+    uint32_t below_sensitivity;
+    uint64_t airtime_us;
+} sim_channel_stats_t;
+
+typedef struct {
+    double path_loss_exponent;
+    double shadowing_db;        // Std deviation of per-link static shadowing
+    uint32_t seed;
+} sim_channel_config_t;
+
+// Simulator
+extern sim_node_t sim_nodes[SIM_MAX_NODES];
+extern int sim_node_count;
+extern sim_channel_stats_t sim_channel_stats;
+
+void sim_init(const sim_channel_config_t *config);
+sim_node_t *sim_add_node(double x, double y, double clock_ppm);
+
+// Select which node's radio receives SPI/GPIO traffic and whose clock is read
+void sim_select(sim_node_t *node);
+sim_node_t *sim_current(void);
+
+// Global clock
+uint64_t sim_now_us(void);
+void sim_advance_to(uint64_t global_us);
+uint64_t sim_local_to_global(const sim_node_t *node, uint64_t local_us);
+uint64_t sim_global_to_local(const sim_node_t *node, uint64_t global_us);
+
+// Randomness shared by models and scenarios
+uint32_t sim_random(void);
+double sim_random_uniform(void);
+double sim_random_exponential(double mean);
+double sim_random_gaussian(void);
+
+// Radio model (radio.c)
+extern double sim_wideband_ones;    // P(LSB = 1) of RegRssiWideband, a biased noise source
+void sim_radio_reset(sim_radio_t *radio);
+void sim_radio_select(sim_radio_t *radio, bool selected);
+uint8_t sim_radio_spi_byte(sim_node_t *node, uint8_t mosi);
+bool sim_radio_dio0(const sim_radio_t *radio);
+void sim_radio_event(sim_node_t *node);
+lora_config_t sim_radio_config(const sim_radio_t *radio, bool *implicit_header);
+uint32_t sim_radio_frf(const sim_radio_t *radio);
+double sim_radio_power_dbm(const sim_radio_t *radio);
+
+// Radio hooks called by the channel
+void sim_radio_on_air_start(sim_node_t *node, int tx);
+void sim_radio_on_air_end(sim_node_t *node, int tx);
+
+// Channel model (channel.c)
+void sim_channel_init(const sim_channel_config_t *config);
+int sim_channel_start_tx(sim_node_t *node, uint32_t airtime_us);
+void sim_channel_end_tx(int tx);
+sim_tx_t *sim_channel_tx(int tx);
+double sim_channel_rx_power_dbm(int tx, const sim_node_t *receiver);
+double sim_channel_noise_dbm(uint8_t bw);         // bw is the bandwidth index
+double sim_channel_snr_limit_db(uint8_t sf);
+bool sim_channel_same_channel(const sim_tx_t *tx, const sim_radio_t *radio);
+// Sum of on-air power at the receiver on its channel, excluding one frame
+double sim_channel_interference_mw(const sim_node_t *receiver, int exclude_tx);
+
+// dBm <-> mW
+double sim_dbm_to_mw(double dbm);
+double sim_mw_to_dbm(double mw);
+
+#endif // SIM_H
@@ -0,0 +1,82 @@
+// Sweep harness: pass duration against the per-step settle and sample
+// budget, quiet-channel selection around a busy step, and the radio left
+// on its own frequency afterwards.
+
+#include "sweep.h"
+#include "check.h"
+#include "lora_sweep.h"
+#include <stdlib.h>
+
+#define BUSY_FREQUENCY          868125000
+#define QUIET_COUNT             4
+#define QUIET_SPACING_HZ        500000
+
+// Settling plus every sample interval; SPI costs no simulated time
+#define STEP_BOUND_US           (LORA_SWEEP_SETTLE_US + LORA_SWEEP_SAMPLES * LORA_SWEEP_SAMPLE_INTERVAL_US)
+
+// Forward declarations of static functions
+static int check_pass(const char *name, uint16_t steps, uint16_t expected, uint32_t duration_us);
+
+static lora_sweep_t sweep;
+
+int sim_sweep_run(void) {
+    uint8_t frame[MAX_PKT_LENGTH] = {0};
+    uint16_t quiet[QUIET_COUNT];
+    int failures = 0;
+
+    sim_node_t *node = sim_check_setup(1, 2, false);
+    if (!node) {
+        return 1;
+    }
+    sim_node_t *busy = &sim_nodes[1];
+
+    // A frame long enough to stay on the air for the whole pass
+    sim_select(busy);
+    lora_set_frequency(&busy->lora, BUSY_FREQUENCY);
+    lora_begin_packet(&busy->lora, false);
+    lora_write(&busy->lora, frame, sizeof(frame));
+    lora_end_packet(&busy->lora, true);
+
+    sim_select(node);
+    lora_sweep_begin(&sweep, &node->lora, 863000000, 870000000, 125000);
+    uint32_t duration_us = lora_sweep_run(&sweep);
+    failures += check_pass("sweep 863-870", sweep.step_count, 57, duration_us);
+
+    uint16_t loudest = 0;
+    for (uint16_t i = 1; i < sweep.step_count; i++) {
+        if (lora_sweep_average_dbm(&sweep, i) > lora_sweep_average_dbm(&sweep, loudest)) {
+            loudest = i;
+        }
+    }
+    failures += sim_check("busy step", sweep.steps[loudest].frequency == BUSY_FREQUENCY, "%lu Hz at %d dBm",
+                          (unsigned long)sweep.steps[loudest].frequency, lora_sweep_average_dbm(&sweep, loudest));
+
+    size_t picked = lora_sweep_quietest(&sweep, quiet, QUIET_COUNT, QUIET_SPACING_HZ);
+    bool spaced = true;
+    for (size_t i = 0; i < picked; i++) {
+        for (size_t j = i + 1; j < picked; j++) {
+            spaced &= (uint32_t)abs((int32_t)(sweep.steps[quiet[i]].frequency - sweep.steps[quiet[j]].frequency)) >=
+                      QUIET_SPACING_HZ;
+        }
+        spaced &= quiet[i] != loudest;
+    }
+    failures += sim_check("quietest", picked == QUIET_COUNT && spaced, "%lu picked", (unsigned long)picked);
+
+    lora_sweep_begin(&sweep, &node->lora, 902000000, 928000000, 200000);
+    duration_us = lora_sweep_run(&sweep);
+    failures += check_pass("sweep 902-928", sweep.step_count, 131, duration_us);
+
+    uint32_t frf = (uint32_t)(((uint64_t)SIM_FREQUENCY << 19) / 32000000);
+    failures += sim_check("frequency restored", sim_radio_frf(&node->radio) == frf &&
+                          (lora_read_register(&node->lora, REG_OP_MODE) & 0x07) == MODE_STDBY, NULL);
+
+    return failures;
+}
+
+// Private functions
+static int check_pass(const char *name, uint16_t steps, uint16_t expected, uint32_t duration_us) {
+    uint32_t bound_us = (uint32_t)steps * STEP_BOUND_US;
+
+    return sim_check(name, steps == expected && duration_us <= bound_us, "%u steps in %.1f ms, bound %.1f ms", steps,
+                     duration_us / 1000.0, bound_us / 1000.0);
+}
@@ -0,0 +1,9 @@
+#ifndef SIM_SWEEP_H
+#define SIM_SWEEP_H
+
+// lora_sweep over 863-870 MHz at 125 kHz, next to a node transmitting on
+// one of the steps, then over 902-928 MHz at 200 kHz. Returns the number
+// of failed checks.
+int sim_sweep_run(void);
+
+#endif // SIM_SWEEP_H
@@ -1,10 +1,14 @@
 #include "lora.h"
+#include "lora_stats.h"
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/irq.h"
 #include "print.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
 
 // Default pins for RP2040
 //#define LORA_DEFAULT_SS_PIN    17
@@ -33,28 +37,67 @@ static void implicit_header_mode(lora_ctx_t *ctx);
 static bool is_transmitting(lora_ctx_t *ctx);
 static int get_spreading_factor(lora_ctx_t *ctx);
 static uint32_t get_signal_bandwidth(lora_ctx_t *ctx);
+static int rssi_offset(lora_ctx_t *ctx);
+static bool wait_tx_done(lora_ctx_t *ctx);
+static void arm_tx_deadline(lora_ctx_t *ctx);
+static void tx_finished(lora_ctx_t *ctx);
+static void tx_timed_out(lora_ctx_t *ctx);
+static void init_bus(lora_ctx_t *ctx);
+static uint8_t reset_radio(lora_ctx_t *ctx);
+static void record_start(lora_ctx_t *ctx, lora_start_t type, uint64_t start_us);
+static uint32_t checkpoint_checksum(const lora_checkpoint_t *checkpoint);
+static uint32_t checksum_update(uint32_t hash, const void *data, size_t size);
+static void dio0_irq_handler(void);
+
+// Context whose DIO0 edges are timestamped
+static lora_ctx_t *dio0_ctx;
 
 #if LORA_ERROR_PRINT
-void lora_error_print(lora_ctx_t *ctx, const char *format, ...) {
+static const char *const log_prefix[] = {
+    "", "[LoRa Error] ", "[LoRa Warn] ", "[LoRa Info] ", "[LoRa Debug] "
+};
+
+// Format a whole line and hand it to the print backend in one write
+static void log_vprint(lora_ctx_t *ctx, int level, const char *format, va_list args) {
     if (!ctx || !ctx->print.write_buffer) return;
-    
-    print_str(&ctx->print, "[LoRa Error] ");
-    
-    // Check if format contains any format specifiers
+
+    char line[LORA_LOG_LINE_LENGTH];
+    size_t n = strlen(log_prefix[level]);
+    memcpy(line, log_prefix[level], n);
+
     if (strchr(format, '%') != NULL) {
         // Handle formatted string
-        va_list args;
-        va_start(args, format);
-        char buffer[256];
-        vsnprintf(buffer, sizeof(buffer), format, args);
-        va_end(args);
-        print_str(&ctx->print, buffer);
+        int len = vsnprintf(line + n, sizeof(line) - n - 2, format, args);
+        if (len > 0) {
+            n += ((size_t)len < sizeof(line) - n - 2) ? (size_t)len : sizeof(line) - n - 3;
+        }
     } else {
         // Handle simple string
-        print_str(&ctx->print, format);
+        size_t len = strlen(format);
+        if (len > sizeof(line) - n - 2) len = sizeof(line) - n - 2;
+        memcpy(line + n, format, len);
+        n += len;
     }
-    
-    println(&ctx->print);
+
+    line[n++] = '\r';
+    line[n++] = '\n';
+    print_write_buffer(&ctx->print, (const uint8_t *)line, n);
+}
+
+void lora_log(lora_ctx_t *ctx, int level, const char *format, ...) {
+    if (level < LORA_LOG_LEVEL_ERROR || level > LORA_LOG_LEVEL_DEBUG) return;
+
+    va_list args;
+    va_start(args, format);
+    log_vprint(ctx, level, format, args);
+    va_end(args);
+}
+
+void lora_error_print(lora_ctx_t *ctx, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    log_vprint(ctx, LORA_LOG_LEVEL_ERROR, format, args);
+    va_end(args);
 }
 
 void lora_error_print_hex(lora_ctx_t *ctx, const char *prefix, const uint8_t *data, size_t len) {
@@ -66,11 +109,7 @@ void lora_error_print_hex(lora_ctx_t *ctx, const char *prefix, const uint8_t *da
         print_str(&ctx->print, " ");
     }
     
-    for (size_t i = 0; i < len; i++) {
-        char hex[3];
-        snprintf(hex, sizeof(hex), "%02x", data[i]);
-        print_str(&ctx->print, hex);
-    }
+    print_hex_buffer(&ctx->print, data, len);
     println(&ctx->print);
 }
 #endif
@@ -83,50 +122,34 @@ void lora_init(lora_ctx_t *ctx) {
 
 // Begin LoRa operation
 bool lora_begin(lora_ctx_t *ctx, uint32_t frequency) {
-    lora_error_print(ctx, "lora_begin %ld", frequency);
-    
-    // Initialize SPI
-    spi_init(LORA_DEFAULT_SPI_PORT, LORA_SPI_CLOCK_SPEED);
-    
-    // Configure SPI pins
-    gpio_set_function(LORA_SPI_SCK_PIN, GPIO_FUNC_SPI);   // SCK
-    gpio_set_function(LORA_SPI_MOSI_PIN, GPIO_FUNC_SPI);  // MOSI
-    gpio_set_function(LORA_SPI_MISO_PIN, GPIO_FUNC_SPI);  // MISO
-    
-    // Configure SS pin
-    gpio_init(LORA_DEFAULT_SS_PIN);
-    gpio_set_dir(LORA_DEFAULT_SS_PIN, GPIO_OUT);
-    gpio_put(LORA_DEFAULT_SS_PIN, 1);  // Set SS high (inactive)
-    
-    // Configure RESET pin
-    gpio_init(LORA_DEFAULT_RESET_PIN);
-    gpio_set_dir(LORA_DEFAULT_RESET_PIN, GPIO_OUT);
-    gpio_put(LORA_DEFAULT_RESET_PIN, 1);  // Set RESET high (active)
-    
-    // Configure DIO0 pin
-    gpio_init(LORA_DEFAULT_DIO0_PIN);
-    gpio_set_dir(LORA_DEFAULT_DIO0_PIN, GPIO_IN);
-    
-    // Set SPI format
-    //spi_set_format(LORA_DEFAULT_SPI_PORT, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
-    
-    // Reset module
-    gpio_put(LORA_DEFAULT_RESET_PIN, 0);
-    sleep_ms(10);
-    gpio_put(LORA_DEFAULT_RESET_PIN, 1);
-    sleep_ms(10);
-    
-    // Check version
-    uint8_t version = read_register(ctx, REG_VERSION);
-    lora_error_print(ctx, "Version: 0x%02x", version);
+    uint64_t start_us = time_us_64();
+
+    LORA_LOG_DEBUG(ctx, "lora_begin %ld", (long)frequency);
+
+    init_bus(ctx);
+
+    // Reset module and check version
+    uint8_t version = reset_radio(ctx);
+    LORA_LOG_DEBUG(ctx, "Version: 0x%02x", version);
     if (version != 0x12) {
-        lora_error_print(ctx, "Failed to read the REG_VERSION register");
+        LORA_LOG_ERROR(ctx, "Failed to read the REG_VERSION register");
+        record_start(ctx, LORA_START_FAILED, start_us);
         return false;
     }
 
-    // Put in sleep mode
+    // Put in sleep mode, switching to LoRa
+    ctx->modem = LORA_MODEM_LORA;
     lora_sleep(ctx);
 
+    // Modem defaults after reset
+    ctx->config.spreading_factor = 7;
+    ctx->config.signal_bandwidth = 7;
+    ctx->config.coding_rate = 5;
+    ctx->config.preamble_length = 8;
+    ctx->config.sync_word = 0x12;
+    ctx->config.crc_enabled = false;
+    ctx->config.invert_iq = false;
+
     // Set frequency
     lora_set_frequency(ctx, frequency);
 
@@ -147,16 +170,195 @@ bool lora_begin(lora_ctx_t *ctx, uint32_t frequency) {
     lora_idle(ctx);
 
     ctx->initialized = true;
+    record_start(ctx, LORA_START_COLD, start_us);
     return true;
 }
 
 // End LoRa operation
 void lora_end(lora_ctx_t *ctx) {
+    lora_disable_timestamps(ctx);
+
     // Put in sleep mode
     lora_sleep(ctx);
     ctx->initialized = false;
 }
 
+// Configuration registers kept in a checkpoint. Per-operation registers
+// (payload length, DIO mapping) are left out; the driver sets them itself.
+static const struct {
+    uint8_t address;
+    uint8_t length;
+} checkpoint_ranges[] = {
+    { REG_FRF_MSB, 7 },             // FRF, PA config, PA ramp, OCP, LNA
+    { REG_FIFO_TX_BASE_ADDR, 2 },
+    { 0x11, 1 },                    // IRQ flags mask
+    { REG_MODEM_CONFIG_1, 3 },      // Modem config 1/2, symbol timeout
+    { REG_PREAMBLE_MSB, 2 },
+    { 0x23, 2 },                    // Max payload length, hop period
+    { REG_MODEM_CONFIG_3, 2 },      // Modem config 3, PPM correction
+    { REG_DETECTION_OPTIMIZE, 1 },
+    { REG_INVERTIQ, 1 },
+    { REG_DETECTION_THRESHOLD, 1 },
+    { REG_SYNC_WORD, 1 },
+    { REG_INVERTIQ2, 1 },
+    { REG_PA_DAC, 1 },
+};
+
+// The header mode bit follows each packet and is not configuration
+static uint8_t checkpoint_mask(uint8_t address) {
+    return address == REG_MODEM_CONFIG_1 ? 0xfe : 0xff;
+}
+
+void lora_checkpoint_save(lora_ctx_t *ctx, lora_checkpoint_t *checkpoint) {
+    size_t offset = 0;
+
+    memset(checkpoint, 0, sizeof(lora_checkpoint_t));
+    for (size_t i = 0; i < sizeof(checkpoint_ranges) / sizeof(checkpoint_ranges[0]); i++) {
+        read_register_burst(ctx, checkpoint_ranges[i].address, &checkpoint->image[offset], checkpoint_ranges[i].length);
+        for (uint8_t j = 0; j < checkpoint_ranges[i].length; j++) {
+            checkpoint->image[offset + j] &= checkpoint_mask(checkpoint_ranges[i].address + j);
+        }
+        offset += checkpoint_ranges[i].length;
+    }
+
+    memcpy(&checkpoint->config, &ctx->config, sizeof(lora_config_t));
+    checkpoint->checksum = checkpoint_checksum(checkpoint);
+}
+
+bool lora_checkpoint_valid(const lora_checkpoint_t *checkpoint) {
+    return checkpoint && checkpoint->checksum == checkpoint_checksum(checkpoint);
+}
+
+// Compare the radio against the checkpoint with one burst read
+bool lora_checkpoint_matches(lora_ctx_t *ctx, const lora_checkpoint_t *checkpoint) {
+    uint8_t regs[REG_PA_DAC + 1];
+    size_t offset = 0;
+
+    read_register_burst(ctx, REG_OP_MODE, &regs[REG_OP_MODE], REG_PA_DAC);
+    if ((regs[REG_OP_MODE] & MODE_LONG_RANGE_MODE) == 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(checkpoint_ranges) / sizeof(checkpoint_ranges[0]); i++) {
+        for (uint8_t j = 0; j < checkpoint_ranges[i].length; j++) {
+            uint8_t address = checkpoint_ranges[i].address + j;
+            if ((regs[address] & checkpoint_mask(address)) != checkpoint->image[offset + j]) {
+                return false;
+            }
+        }
+        offset += checkpoint_ranges[i].length;
+    }
+
+    return true;
+}
+
+// Write the checkpoint back range by range; leaves the radio in standby
+void lora_checkpoint_restore(lora_ctx_t *ctx, const lora_checkpoint_t *checkpoint) {
+    size_t offset = 0;
+
+    // A checkpoint is LoRa configuration
+    lora_sleep(ctx);
+    ctx->modem = LORA_MODEM_LORA;
+    lora_sleep(ctx);
+    for (size_t i = 0; i < sizeof(checkpoint_ranges) / sizeof(checkpoint_ranges[0]); i++) {
+        write_register_burst(ctx, checkpoint_ranges[i].address, &checkpoint->image[offset], checkpoint_ranges[i].length);
+        offset += checkpoint_ranges[i].length;
+    }
+
+    memcpy(&ctx->config, &checkpoint->config, sizeof(lora_config_t));
+    ctx->implicit_header_mode = 0;
+    lora_idle(ctx);
+}
+
+// Bring the radio up without a reset when it still holds the checkpoint
+lora_start_t lora_resume(lora_ctx_t *ctx, const lora_checkpoint_t *checkpoint) {
+    uint64_t start_us = time_us_64();
+
+    if (!lora_checkpoint_valid(checkpoint)) {
+        LORA_LOG_ERROR(ctx, "Invalid checkpoint");
+        record_start(ctx, LORA_START_FAILED, start_us);
+        return LORA_START_FAILED;
+    }
+
+    memcpy(&ctx->config, &checkpoint->config, sizeof(lora_config_t));
+    init_bus(ctx);
+
+    if (read_register(ctx, REG_VERSION) == 0x12 && lora_checkpoint_matches(ctx, checkpoint)) {
+        ctx->implicit_header_mode = 0;
+        lora_idle(ctx);
+        record_start(ctx, LORA_START_WARM, start_us);
+    } else {
+        if (reset_radio(ctx) != 0x12) {
+            LORA_LOG_ERROR(ctx, "Failed to read the REG_VERSION register");
+            record_start(ctx, LORA_START_FAILED, start_us);
+            return LORA_START_FAILED;
+        }
+        lora_checkpoint_restore(ctx, checkpoint);
+        record_start(ctx, LORA_START_RESTORED, start_us);
+    }
+
+    ctx->initialized = true;
+    LORA_LOG_DEBUG(ctx, "Resume type %d in %ld us", ctx->start_type, (long)ctx->start_duration_us);
+    return ctx->start_type;
+}
+
+// TX timeout recovery
+void lora_enable_recovery(lora_ctx_t *ctx) {
+    lora_checkpoint_save(ctx, &ctx->recovery);
+    ctx->recovery_enabled = true;
+}
+
+void lora_disable_recovery(lora_ctx_t *ctx) {
+    ctx->recovery_enabled = false;
+}
+
+// Abort whatever the radio is doing and bring it back to the checkpoint
+lora_recovery_t lora_recover(lora_ctx_t *ctx) {
+    uint64_t start_us = time_us_64();
+    lora_recovery_t action;
+
+    lora_idle(ctx);
+    write_register(ctx, REG_IRQ_FLAGS, 0xff);
+    ctx->tx_deadline_us = 0;
+
+    if (read_register(ctx, REG_VERSION) == 0x12) {
+        if (!ctx->recovery_enabled || lora_checkpoint_matches(ctx, &ctx->recovery)) {
+            action = LORA_RECOVERY_VERIFIED;
+        } else {
+            lora_checkpoint_restore(ctx, &ctx->recovery);
+            action = LORA_RECOVERY_REPROGRAMMED;
+        }
+    } else if (ctx->recovery_enabled && reset_radio(ctx) == 0x12) {
+        lora_checkpoint_restore(ctx, &ctx->recovery);
+        action = LORA_RECOVERY_RESET;
+    } else {
+        action = LORA_RECOVERY_FAILED;
+    }
+
+    ctx->last_recovery.action = action;
+    ctx->last_recovery.timestamp_us = start_us;
+    ctx->last_recovery.duration_us = (uint32_t)(time_us_64() - start_us);
+    ctx->recovery_count++;
+
+    if (action == LORA_RECOVERY_FAILED) {
+        ctx->initialized = false;
+        LORA_LOG_ERROR(ctx, "Radio recovery failed");
+    }
+    return action;
+}
+
+const lora_recovery_event_t *lora_last_recovery(lora_ctx_t *ctx) {
+    return &ctx->last_recovery;
+}
+
+lora_start_t lora_start_type(lora_ctx_t *ctx) {
+    return ctx->start_type;
+}
+
+uint32_t lora_start_duration_us(lora_ctx_t *ctx) {
+    return ctx->start_duration_us;
+}
+
 // Send packet
 bool lora_begin_packet(lora_ctx_t *ctx, bool implicit_header) {
     if (is_transmitting(ctx)) {
@@ -180,25 +382,131 @@ bool lora_begin_packet(lora_ctx_t *ctx, bool implicit_header) {
 }
 
 bool lora_end_packet(lora_ctx_t *ctx, bool async) {
-    if ((async) && (ctx->config.dio0_pin > 0)) {
-        write_register(ctx, REG_DIO_MAPPING_1, 0x40); // DIO0 => TXDONE
+    if (((async) && (ctx->config.dio0_pin > 0)) || ctx->timestamps_enabled) {
+        write_register(ctx, REG_DIO_MAPPING_1, DIO0_TX_DONE); // DIO0 => TXDONE
     }
 
     // Put in TX mode
-    write_register(ctx, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_TX);
+    ctx->dio0_timestamp_us = 0;
+    ctx->tx_start_us = time_us_64();
+    set_mode(ctx, MODE_TX);
+    arm_tx_deadline(ctx);
 
     if (!async) {
-        // Wait for TX done
-        while ((read_register(ctx, REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) == 0) {
-            sleep_ms(1);
-        }
-        // Clear IRQ's
-        write_register(ctx, REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+        return wait_tx_done(ctx);
     }
 
     return true;
 }
 
+// True while a packet is on air; records the TX done time once it finishes
+bool lora_is_transmitting(lora_ctx_t *ctx) {
+    return is_transmitting(ctx);
+}
+
+// Transmit the preloaded FIFO at an absolute time_us_64() deadline
+bool lora_end_packet_at(lora_ctx_t *ctx, uint64_t deadline_us, bool async) {
+    if (((async) && (ctx->config.dio0_pin > 0)) || ctx->timestamps_enabled) {
+        write_register(ctx, REG_DIO_MAPPING_1, DIO0_TX_DONE); // DIO0 => TXDONE
+    }
+
+    // Lock the synthesizer now so keying up is a single mode change
+    set_mode(ctx, MODE_FSTX);
+
+    if (time_us_64() + LORA_TX_SCHEDULE_SPIN_US / 2 > deadline_us) {
+        // Too late to key up on time
+        lora_idle(ctx);
+        LORA_LOG_WARN(ctx, "TX deadline missed");
+        return false;
+    }
+
+    if (deadline_us - time_us_64() > LORA_TX_SCHEDULE_SPIN_US) {
+        sleep_until(from_us_since_boot(deadline_us - LORA_TX_SCHEDULE_SPIN_US));
+    }
+
+    // Spin the last stretch with interrupts off
+    uint32_t irq_state = save_and_disable_interrupts();
+    while (time_us_64() < deadline_us) {
+        tight_loop_contents();
+    }
+    ctx->dio0_timestamp_us = 0;
+    set_mode(ctx, MODE_TX);
+    ctx->tx_start_us = time_us_64();
+    restore_interrupts(irq_state);
+    arm_tx_deadline(ctx);
+
+    if (!async) {
+        return wait_tx_done(ctx);
+    }
+
+    return true;
+}
+
+// Event timestamps
+static void dio0_irq_handler(void) {
+    if (!dio0_ctx) {
+        return;
+    }
+
+    // Raw handlers run for every bank 0 interrupt; take only our edge
+    uint pin = dio0_ctx->config.dio0_pin;
+    if (gpio_get_irq_event_mask(pin) & GPIO_IRQ_EDGE_RISE) {
+        gpio_acknowledge_irq(pin, GPIO_IRQ_EDGE_RISE);
+        dio0_ctx->dio0_timestamp_us = time_us_64();
+    }
+}
+
+void lora_enable_timestamps(lora_ctx_t *ctx) {
+    dio0_ctx = ctx;
+    ctx->dio0_timestamp_us = 0;
+    if (ctx->timestamps_enabled) {
+        return;
+    }
+    ctx->timestamps_enabled = true;
+
+    // A raw handler for this pin only, so the application keeps the shared
+    // GPIO callback for its own pins
+    gpio_add_raw_irq_handler(ctx->config.dio0_pin, &dio0_irq_handler);
+    gpio_set_irq_enabled(ctx->config.dio0_pin, GPIO_IRQ_EDGE_RISE, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
+
+void lora_disable_timestamps(lora_ctx_t *ctx) {
+    if (!ctx->timestamps_enabled) {
+        return;
+    }
+    gpio_set_irq_enabled(ctx->config.dio0_pin, GPIO_IRQ_EDGE_RISE, false);
+    gpio_remove_raw_irq_handler(ctx->config.dio0_pin, &dio0_irq_handler);
+    ctx->timestamps_enabled = false;
+    if (dio0_ctx == ctx) {
+        dio0_ctx = NULL;
+    }
+}
+
+// Consume the DIO0 edge time, falling back to now when no edge was captured
+uint64_t lora_take_event_timestamp(lora_ctx_t *ctx) {
+    // The 64-bit read and clear are several accesses on the M0+; keep the
+    // interrupt from landing between them
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint64_t timestamp = ctx->dio0_timestamp_us;
+    ctx->dio0_timestamp_us = 0;
+    restore_interrupts(irq_state);
+
+    return timestamp ? timestamp : time_us_64();
+}
+
+uint64_t lora_packet_timestamp(lora_ctx_t *ctx) {
+    return ctx->packet_timestamp_us;
+}
+
+uint64_t lora_tx_start_timestamp(lora_ctx_t *ctx) {
+    return ctx->tx_start_us;
+}
+
+uint64_t lora_tx_done_timestamp(lora_ctx_t *ctx) {
+    return ctx->tx_done_us;
+}
+
 // Receive packet
 int lora_parse_packet(lora_ctx_t *ctx, int size) {
     int packet_length = 0;
@@ -214,9 +522,34 @@ int lora_parse_packet(lora_ctx_t *ctx, int size) {
     // Clear IRQ's
     write_register(ctx, REG_IRQ_FLAGS, irq_flags);
 
+    if (ctx->stats) {
+        if ((irq_flags & IRQ_RX_DONE_MASK) && (irq_flags & IRQ_PAYLOAD_CRC_ERROR_MASK)) {
+            lora_stats_rx_crc_error(ctx->stats);
+        }
+        if (irq_flags & IRQ_RX_TIMEOUT_MASK) {
+            lora_stats_rx_timeout(ctx->stats);
+        }
+    }
+
     if ((irq_flags & IRQ_RX_DONE_MASK) && (irq_flags & IRQ_PAYLOAD_CRC_ERROR_MASK) == 0) {
         // Received a packet
         ctx->packet_index = 0;
+        ctx->packet_timestamp_us = lora_take_event_timestamp(ctx);
+        lora_read_link_quality(ctx, &ctx->link);
+
+        // A corrupted header can clear the CRC flag, leaving the payload
+        // unchecked. CrcOnPayload is only valid with an explicit header.
+        if (ctx->require_payload_crc && ctx->config.crc_enabled && !ctx->implicit_header_mode &&
+            !ctx->link.crc_on_payload) {
+            if (ctx->stats) {
+                lora_stats_rx_header_error(ctx->stats);
+            }
+            lora_idle(ctx);
+            return 0;
+        }
+        if (ctx->stats) {
+            lora_stats_rx_ok(ctx->stats, &ctx->link);
+        }
 
         // Read packet length
         if (ctx->implicit_header_mode) {
@@ -235,37 +568,79 @@ int lora_parse_packet(lora_ctx_t *ctx, int size) {
         // Reset FIFO address
         write_register(ctx, REG_FIFO_ADDR_PTR, 0);
 
+        if (ctx->timestamps_enabled) {
+            write_register(ctx, REG_DIO_MAPPING_1, DIO0_RX_DONE); // DIO0 => RXDONE
+            ctx->dio0_timestamp_us = 0;
+        }
+
         // Put in single RX mode
-        write_register(ctx, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_SINGLE);
+        set_mode(ctx, MODE_RX_SINGLE);
     }
 
     return packet_length;
 }
 
+// RSSI register offset: LF port (below 868 MHz) or HF port
+int lora_rssi_offset(uint32_t frequency) {
+    return frequency < 868000000 ? 164 : 157;
+}
+
+// Current channel RSSI
 int16_t lora_rssi(lora_ctx_t *ctx) {
-    return (read_register(ctx, REG_PKT_RSSI_VALUE) - (ctx->config.frequency < 868E6 ? 164 : 157));
+    return read_register(ctx, REG_RSSI_VALUE) - rssi_offset(ctx);
+}
+
+// Link quality of the last packet returned by lora_parse_packet
+int lora_packet_rssi(lora_ctx_t *ctx) {
+    return ctx->link.rssi_dbm;
 }
 
 float lora_packet_snr(lora_ctx_t *ctx) {
-    return ((int8_t)read_register(ctx, REG_PKT_SNR_VALUE)) * 0.25;
+    return ctx->link.snr_q * 0.25f;
 }
 
 long lora_packet_frequency_error(lora_ctx_t *ctx) {
-    int32_t freq_error = 0;
-    freq_error = (int32_t)(read_register(ctx, REG_FREQ_ERROR_MSB) & 0x7);
-    freq_error <<= 8L;
-    freq_error += (int32_t)(read_register(ctx, REG_FREQ_ERROR_MID));
-    freq_error <<= 8L;
-    freq_error += (int32_t)(read_register(ctx, REG_FREQ_ERROR_LSB));
+    return ctx->link.frequency_error_hz;
+}
 
-    if (read_register(ctx, REG_FREQ_ERROR_MSB) & 0x8) { // Sign bit is on
-        freq_error -= 524288; // B1000'0000'0000'0000'0000
+const lora_link_quality_t *lora_packet_link_quality(lora_ctx_t *ctx) {
+    return &ctx->link;
+}
+
+// SNR, packet RSSI, current RSSI and frequency error in one burst from
+// REG_PKT_SNR_VALUE to REG_FREQ_ERROR_LSB, converted with integer math
+void lora_read_link_quality(lora_ctx_t *ctx, lora_link_quality_t *link) {
+    uint8_t regs[REG_FREQ_ERROR_LSB - REG_PKT_SNR_VALUE + 1];
+    int offset = rssi_offset(ctx);
+
+    read_register_burst(ctx, REG_PKT_SNR_VALUE, regs, sizeof(regs));
+
+    int8_t snr_q = (int8_t)regs[0];
+    int16_t packet_rssi = regs[REG_PKT_RSSI_VALUE - REG_PKT_SNR_VALUE];
+
+    link->snr_q = snr_q;
+    link->crc_on_payload = (regs[REG_HOP_CHANNEL - REG_PKT_SNR_VALUE] & 0x40) != 0;
+    link->current_rssi_dbm = regs[REG_RSSI_VALUE - REG_PKT_SNR_VALUE] - offset;
+
+    // Semtech SX1276/77/78/79 5.5.5.: above the noise floor the register
+    // under-reads by 1/16; below it, SNR adds to the measured noise power
+    if (snr_q >= 0) {
+        link->rssi_dbm = (packet_rssi * 16) / 15 - offset;
+    } else {
+        link->rssi_dbm = packet_rssi - offset + (snr_q - 3) / 4;
     }
 
-    const float fXtal = 32E6; // FXOSC: crystal oscillator (XTAL) frequency (2.5. Chip Specification, p.14)
-    const float fError = ((float)(freq_error) * (1L << 24)) / fXtal;
+    // 20-bit two's complement; Ferr = FreqError * 2^24 / Fxtal * BW / 500 kHz,
+    // where 2^24 / 32 MHz reduces to 8192 / 15625
+    const uint8_t *fe = &regs[REG_FREQ_ERROR_MSB - REG_PKT_SNR_VALUE];
+    int32_t freq_error = ((int32_t)(fe[0] & 0x0f) << 16) | (fe[1] << 8) | fe[2];
+    if (freq_error & 0x80000) {
+        freq_error -= 0x100000;
+    }
 
-    return (long)(fError * (get_signal_bandwidth(ctx) / 500000.0)); // Given the frequency error in Hz
+    int64_t numerator = (int64_t)freq_error * 8192 * lora_bandwidth_hz(ctx->config.signal_bandwidth);
+    int64_t denominator = 15625LL * 500000;
+    link->frequency_error_hz = (int32_t)((numerator + (numerator < 0 ? -denominator : denominator) / 2) / denominator);
 }
 
 // Write data
@@ -278,9 +653,7 @@ size_t lora_write(lora_ctx_t *ctx, const uint8_t *buffer, size_t size) {
     }
 
     // Write data
-    for (size_t i = 0; i < size; i++) {
-        write_register(ctx, REG_FIFO, buffer[i]);
-    }
+    write_register_burst(ctx, REG_FIFO, buffer, size);
 
     // Update length
     write_register(ctx, REG_PAYLOAD_LENGTH, current_length + size);
@@ -328,22 +701,51 @@ void lora_flush(lora_ctx_t *ctx) {
 }
 
 size_t lora_read_bytes(lora_ctx_t *ctx, uint8_t *buffer, size_t size) {
-    size_t read_bytes = 0;
+    int available = lora_available(ctx);
 
-    while (read_bytes < size && lora_available(ctx)) {
-        buffer[read_bytes++] = lora_read(ctx);
+    if (available <= 0) {
+        return 0;
+    }
+    if (size > (size_t)available) {
+        size = available;
     }
 
-    return read_bytes;
+    // Read the whole span in one burst
+    read_register_burst(ctx, REG_FIFO, buffer, size);
+    ctx->packet_index += size;
+
+    return size;
 }
 
 // Configuration
 void lora_idle(lora_ctx_t *ctx) {
-    write_register(ctx, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_STDBY);
+    set_mode(ctx, MODE_STDBY);
 }
 
 void lora_sleep(lora_ctx_t *ctx) {
-    write_register(ctx, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_SLEEP);
+    set_mode(ctx, MODE_SLEEP);
+}
+
+// Operating mode (MODE_*) in the current modem
+void lora_set_mode(lora_ctx_t *ctx, uint8_t mode) {
+    set_mode(ctx, mode);
+}
+
+// LongRangeMode can only change in sleep; the radio ends up in standby.
+// The LoRa packet functions (lora_*_packet) assume LORA_MODEM_LORA.
+void lora_set_modem(lora_ctx_t *ctx, lora_modem_t modem) {
+    if (modem == ctx->modem) {
+        return;
+    }
+
+    lora_sleep(ctx);
+    ctx->modem = modem;
+    lora_sleep(ctx);
+    lora_idle(ctx);
+}
+
+lora_modem_t lora_modem(lora_ctx_t *ctx) {
+    return ctx->modem;
 }
 
 void lora_set_tx_power(lora_ctx_t *ctx, int level, int output_pin) {
@@ -383,13 +785,25 @@ void lora_set_tx_power(lora_ctx_t *ctx, int level, int output_pin) {
 }
 
 void lora_set_frequency(lora_ctx_t *ctx, uint32_t frequency) {
+    uint8_t frf[3];
+
     ctx->config.frequency = frequency;
+    lora_frequency_to_frf(frequency, frf);
+    lora_set_frf(ctx, frf);
+}
+
+// Convert a frequency in Hz to the three REG_FRF_* bytes (MSB first)
+void lora_frequency_to_frf(uint32_t frequency, uint8_t frf[3]) {
+    uint64_t value = ((uint64_t)frequency << 19) / 32000000;
 
-    uint64_t frf = ((uint64_t)frequency << 19) / 32000000;
+    frf[0] = (uint8_t)(value >> 16);
+    frf[1] = (uint8_t)(value >> 8);
+    frf[2] = (uint8_t)(value >> 0);
+}
 
-    write_register(ctx, REG_FRF_MSB, (uint8_t)(frf >> 16));
-    write_register(ctx, REG_FRF_MID, (uint8_t)(frf >> 8));
-    write_register(ctx, REG_FRF_LSB, (uint8_t)(frf >> 0));
+// Retune with a single burst write of precomputed FRF bytes
+void lora_set_frf(lora_ctx_t *ctx, const uint8_t frf[3]) {
+    write_register_burst(ctx, REG_FRF_MSB, frf, 3);
 }
 
 void lora_set_spreading_factor(lora_ctx_t *ctx, int sf) {
@@ -407,6 +821,7 @@ void lora_set_spreading_factor(lora_ctx_t *ctx, int sf) {
         write_register(ctx, REG_DETECTION_THRESHOLD, 0x0a);
     }
 
+    ctx->config.spreading_factor = sf;
     write_register(ctx, REG_MODEM_CONFIG_2, (read_register(ctx, REG_MODEM_CONFIG_2) & 0x0f) | ((sf << 4) & 0xf0));
     set_ldo_flag(ctx);
 }
@@ -436,6 +851,7 @@ void lora_set_signal_bandwidth(lora_ctx_t *ctx, uint32_t sbw) {
         bw = 9;
     }
 
+    ctx->config.signal_bandwidth = bw;
     write_register(ctx, REG_MODEM_CONFIG_1, (read_register(ctx, REG_MODEM_CONFIG_1) & 0x0f) | (bw << 4));
     set_ldo_flag(ctx);
 }
@@ -448,49 +864,212 @@ void lora_set_coding_rate4(lora_ctx_t *ctx, int denominator) {
     }
 
     int cr = denominator - 4;
+    ctx->config.coding_rate = denominator;
     write_register(ctx, REG_MODEM_CONFIG_1, (read_register(ctx, REG_MODEM_CONFIG_1) & 0xf1) | (cr << 1));
 }
 
 void lora_set_preamble_length(lora_ctx_t *ctx, uint16_t length) {
+    ctx->config.preamble_length = length;
     write_register(ctx, REG_PREAMBLE_MSB, (uint8_t)(length >> 8));
     write_register(ctx, REG_PREAMBLE_LSB, (uint8_t)(length >> 0));
 }
 
 void lora_set_sync_word(lora_ctx_t *ctx, int sw) {
+    ctx->config.sync_word = sw;
     write_register(ctx, REG_SYNC_WORD, sw);
 }
 
 void lora_enable_crc(lora_ctx_t *ctx) {
+    ctx->config.crc_enabled = true;
     write_register(ctx, REG_MODEM_CONFIG_2, read_register(ctx, REG_MODEM_CONFIG_2) | 0x04);
 }
 
 void lora_disable_crc(lora_ctx_t *ctx) {
+    ctx->config.crc_enabled = false;
     write_register(ctx, REG_MODEM_CONFIG_2, read_register(ctx, REG_MODEM_CONFIG_2) & 0xfb);
 }
 
+void lora_require_payload_crc(lora_ctx_t *ctx, bool require) {
+    ctx->require_payload_crc = require;
+}
+
 void lora_enable_invert_iq(lora_ctx_t *ctx) {
+    ctx->config.invert_iq = true;
     write_register(ctx, REG_INVERTIQ, 0x66);
     write_register(ctx, REG_INVERTIQ2, 0x19);
 }
 
 void lora_disable_invert_iq(lora_ctx_t *ctx) {
+    ctx->config.invert_iq = false;
     write_register(ctx, REG_INVERTIQ, 0x27);
     write_register(ctx, REG_INVERTIQ2, 0x1d);
 }
 
+// Airtime
+uint32_t lora_bandwidth_hz(uint8_t bandwidth_index) {
+    switch (bandwidth_index) {
+        case 0: return 7.8E3;
+        case 1: return 10.4E3;
+        case 2: return 15.6E3;
+        case 3: return 20.8E3;
+        case 4: return 31.25E3;
+        case 5: return 41.7E3;
+        case 6: return 62.5E3;
+        case 7: return 125E3;
+        case 8: return 250E3;
+        case 9: return 500E3;
+    }
+    return 0;
+}
+
+// Time on air of a packet (Semtech SX1276/77/78/79 4.1.1.6.)
+uint32_t lora_time_on_air_us(const lora_config_t *config, bool implicit_header, uint8_t payload_length) {
+    uint32_t bandwidth = lora_bandwidth_hz(config->signal_bandwidth);
+    int sf = config->spreading_factor;
+    int cr = config->coding_rate - 4;
+
+    if (bandwidth == 0 || sf < 6 || sf > 12 || cr < 1 || cr > 4) {
+        return 0;
+    }
+
+    // Low data rate optimization as set by set_ldo_flag()
+    uint32_t symbol_duration_ms = (1000 * (1L << sf)) / (bandwidth / 1000);
+    int de = symbol_duration_ms > 16 ? 1 : 0;
+
+    int32_t num = 8 * payload_length - 4 * sf + 28 + (config->crc_enabled ? 16 : 0) - (implicit_header ? 20 : 0);
+    int32_t den = 4 * (sf - 2 * de);
+    int32_t payload_symbols = 8;
+    if (num > 0) {
+        payload_symbols += ((num + den - 1) / den) * (cr + 4);
+    }
+
+    // Count in quarter symbols for the 4.25 preamble symbol overhead
+    uint64_t quarter_symbols = 4 * ((uint64_t)config->preamble_length + payload_symbols) + 17;
+    return (uint32_t)((quarter_symbols * (1ULL << sf) * 1000000ULL) / (4ULL * bandwidth));
+}
+
+uint32_t lora_packet_time_on_air_us(lora_ctx_t *ctx, uint8_t payload_length) {
+    return lora_time_on_air_us(&ctx->config, ctx->implicit_header_mode, payload_length);
+}
+
 // Status
 uint8_t lora_random(lora_ctx_t *ctx) {
     return read_register(ctx, REG_RSSI_WIDEBAND);
 }
 
 void lora_dump_registers(lora_ctx_t *ctx) {
-    for (int i = 0; i < 128; i++) {
-        print_str(&ctx->print, "0x");
-        print_uchar(&ctx->print, i, HEX);
-        print_str(&ctx->print, ": 0x");
-        print_uchar(&ctx->print, read_register(ctx, i), HEX);
-        println(&ctx->print);
+    lora_reg_snapshot_t snapshot;
+
+    lora_snapshot_registers(ctx, &snapshot);
+    lora_print_registers(&ctx->print, &snapshot);
+}
+
+// Register snapshots
+
+// Status and per-packet registers that change during normal operation
+static const uint8_t volatile_registers[] = {
+    REG_OP_MODE, REG_FIFO_ADDR_PTR, REG_FIFO_RX_CURRENT_ADDR, REG_IRQ_FLAGS,
+    REG_RX_NB_BYTES, 0x14, 0x15, 0x16, 0x17, REG_MODEM_STAT, REG_PKT_SNR_VALUE,
+    REG_PKT_RSSI_VALUE, 0x1b, 0x1c, REG_PAYLOAD_LENGTH, 0x25, REG_FREQ_ERROR_MSB,
+    REG_FREQ_ERROR_MID, REG_FREQ_ERROR_LSB, REG_RSSI_WIDEBAND, 0x3c, 0x3d, 0x3e,
+    0x3f, REG_DIO_MAPPING_1
+};
+
+// Capture 0x01-0x7F in a single burst read
+void lora_snapshot_registers(lora_ctx_t *ctx, lora_reg_snapshot_t *snapshot) {
+    snapshot->regs[REG_FIFO] = 0;
+    read_register_burst(ctx, LORA_REG_FIRST, &snapshot->regs[LORA_REG_FIRST], LORA_REG_COUNT - LORA_REG_FIRST);
+    snapshot->timestamp_us = time_us_64();
+}
+
+// Collect registers that differ, skipping those set in the ignore bitmask
+size_t lora_diff_registers(const lora_reg_snapshot_t *before, const lora_reg_snapshot_t *after,
+                           const uint8_t *ignore, lora_reg_diff_t *diffs, size_t max) {
+    size_t count = 0;
+
+    for (int address = LORA_REG_FIRST; address < LORA_REG_COUNT; address++) {
+        if (before->regs[address] == after->regs[address]) {
+            continue;
+        }
+        if (ignore && (ignore[address >> 3] & (1 << (address & 7)))) {
+            continue;
+        }
+        if (count < max) {
+            diffs[count].address = address;
+            diffs[count].before = before->regs[address];
+            diffs[count].after = after->regs[address];
+        }
+        count++;
     }
+
+    return count;
+}
+
+void lora_print_registers(print_ctx_t *print, const lora_reg_snapshot_t *snapshot) {
+    for (int i = LORA_REG_FIRST; i < LORA_REG_COUNT; i++) {
+        print_str(print, "0x");
+        print_uchar(print, i, HEX);
+        print_str(print, ": 0x");
+        print_uchar(print, snapshot->regs[i], HEX);
+        println(print);
+    }
+}
+
+void lora_print_register_diff(print_ctx_t *print, const lora_reg_diff_t *diffs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        print_str(print, "0x");
+        print_uchar(print, diffs[i].address, HEX);
+        print_str(print, ": 0x");
+        print_uchar(print, diffs[i].before, HEX);
+        print_str(print, " -> 0x");
+        print_uchar(print, diffs[i].after, HEX);
+        println(print);
+    }
+}
+
+// Configuration drift watch
+void lora_watch_begin(lora_reg_watch_t *watch, lora_ctx_t *ctx, uint32_t interval_us) {
+    memset(watch, 0, sizeof(lora_reg_watch_t));
+    watch->lora = ctx;
+    watch->interval_us = interval_us;
+
+    for (size_t i = 0; i < sizeof(volatile_registers); i++) {
+        lora_watch_ignore(watch, volatile_registers[i]);
+    }
+
+    lora_watch_rebaseline(watch);
+}
+
+// Accept the radio's current configuration as the expected one
+void lora_watch_rebaseline(lora_reg_watch_t *watch) {
+    lora_snapshot_registers(watch->lora, &watch->baseline);
+    watch->next_us = watch->baseline.timestamp_us + watch->interval_us;
+    watch->drift_count = 0;
+}
+
+void lora_watch_ignore(lora_reg_watch_t *watch, uint8_t address) {
+    address &= 0x7f;
+    watch->ignore[address >> 3] |= 1 << (address & 7);
+}
+
+// Take a snapshot when due; returns the number of drifted registers
+int lora_watch_poll(lora_reg_watch_t *watch) {
+    if (time_us_64() < watch->next_us) {
+        return 0;
+    }
+
+    lora_snapshot_registers(watch->lora, &watch->current);
+    watch->next_us = watch->current.timestamp_us + watch->interval_us;
+    watch->snapshots++;
+
+    size_t count = lora_diff_registers(&watch->baseline, &watch->current, watch->ignore,
+                                       watch->drift, LORA_REG_WATCH_MAX_DIFFS);
+    watch->drift_count = count < LORA_REG_WATCH_MAX_DIFFS ? count : LORA_REG_WATCH_MAX_DIFFS;
+    if (count > 0) {
+        watch->drift_events++;
+    }
+
+    return (int)count;
 }
 
 float lora_snr(lora_ctx_t *ctx) {
@@ -534,6 +1113,22 @@ uint8_t lora_single_transfer(lora_ctx_t *ctx, uint8_t address, uint8_t value) {
     return response;
 }
 
+uint8_t lora_read_register(lora_ctx_t *ctx, uint8_t address) {
+    return read_register(ctx, address);
+}
+
+void lora_write_register(lora_ctx_t *ctx, uint8_t address, uint8_t value) {
+    write_register(ctx, address, value);
+}
+
+void lora_read_register_burst(lora_ctx_t *ctx, uint8_t address, uint8_t *buffer, size_t size) {
+    read_register_burst(ctx, address, buffer, size);
+}
+
+void lora_write_register_burst(lora_ctx_t *ctx, uint8_t address, const uint8_t *buffer, size_t size) {
+    write_register_burst(ctx, address, buffer, size);
+}
+
 // Private functions
 static uint8_t read_register(lora_ctx_t *ctx, uint8_t address) {
     return lora_single_transfer(ctx, address & 0x7f, 0x00);
@@ -559,8 +1154,11 @@ static void read_register_burst(lora_ctx_t *ctx, uint8_t address, uint8_t *buffe
     gpio_put(LORA_DEFAULT_SS_PIN, 1);
 }
 
+// Every mode write goes through here so the modem bit is never lost
 static void set_mode(lora_ctx_t *ctx, uint8_t mode) {
-    write_register(ctx, REG_OP_MODE, mode);
+    uint8_t modem = ctx->modem == LORA_MODEM_LORA ? MODE_LONG_RANGE_MODE : MODE_MODULATION_FSK;
+
+    write_register(ctx, REG_OP_MODE, modem | mode);
 }
 
 static void set_ldo_flag(lora_ctx_t *ctx) {
@@ -594,35 +1192,172 @@ static void implicit_header_mode(lora_ctx_t *ctx) {
 }
 
 static bool is_transmitting(lora_ctx_t *ctx) {
-    if ((read_register(ctx, REG_OP_MODE) & MODE_TX) == MODE_TX) {
+    // Mode bits only: MODE_CAD (0x07) also has both MODE_TX bits set
+    if ((read_register(ctx, REG_OP_MODE) & 0x07) == MODE_TX) {
+        if (ctx->tx_deadline_us == 0) {
+            // TX we never started (glitch or garbage on the bus): allow the
+            // longest possible packet before giving up on it
+            ctx->tx_start_us = time_us_64();
+            ctx->tx_deadline_us = ctx->tx_start_us + 2ULL * lora_packet_time_on_air_us(ctx, MAX_PKT_LENGTH) +
+                                  LORA_TX_TIMEOUT_MARGIN_US;
+        } else if (time_us_64() > ctx->tx_deadline_us) {
+            tx_timed_out(ctx);
+            return false;
+        }
         return true;
     }
 
     if (read_register(ctx, REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) {
-        // Clear IRQ
-        write_register(ctx, REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+        // Async TX finished since the last packet
+        tx_finished(ctx);
     }
 
+    // Out of TX, so no deadline may outlive it
+    ctx->tx_deadline_us = 0;
     return false;
 }
 
+static void init_bus(lora_ctx_t *ctx) {
+    // Initialize SPI
+    spi_init(LORA_DEFAULT_SPI_PORT, LORA_SPI_CLOCK_SPEED);
+
+    // Configure SPI pins
+    gpio_set_function(LORA_SPI_SCK_PIN, GPIO_FUNC_SPI);   // SCK
+    gpio_set_function(LORA_SPI_MOSI_PIN, GPIO_FUNC_SPI);  // MOSI
+    gpio_set_function(LORA_SPI_MISO_PIN, GPIO_FUNC_SPI);  // MISO
+
+    // Configure SS pin
+    gpio_init(LORA_DEFAULT_SS_PIN);
+    gpio_put(LORA_DEFAULT_SS_PIN, 1);  // Set SS high (inactive)
+    gpio_set_dir(LORA_DEFAULT_SS_PIN, GPIO_OUT);
+
+    // Configure RESET pin; drive high before enabling the output so a
+    // warm resume does not glitch the radio into reset
+    gpio_init(LORA_DEFAULT_RESET_PIN);
+    gpio_put(LORA_DEFAULT_RESET_PIN, 1);  // Set RESET high (active)
+    gpio_set_dir(LORA_DEFAULT_RESET_PIN, GPIO_OUT);
+
+    // Configure DIO0 pin
+    if (ctx->config.dio0_pin == 0) {
+        ctx->config.dio0_pin = LORA_DEFAULT_DIO0_PIN;
+    }
+    gpio_init(ctx->config.dio0_pin);
+    gpio_set_dir(ctx->config.dio0_pin, GPIO_IN);
+
+    // Set SPI format
+    //spi_set_format(LORA_DEFAULT_SPI_PORT, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+}
+
+// Pulse NRESET and poll until the chip answers; returns REG_VERSION
+static uint8_t reset_radio(lora_ctx_t *ctx) {
+    uint8_t version;
+
+    gpio_put(LORA_DEFAULT_RESET_PIN, 0);
+    sleep_us(LORA_RESET_PULSE_US);
+    gpio_put(LORA_DEFAULT_RESET_PIN, 1);
+
+    uint64_t deadline = time_us_64() + LORA_RESET_TIMEOUT_US;
+    do {
+        version = read_register(ctx, REG_VERSION);
+        if (version == 0x12) {
+            break;
+        }
+        sleep_us(100);
+    } while (time_us_64() < deadline);
+
+    return version;
+}
+
+static void record_start(lora_ctx_t *ctx, lora_start_t type, uint64_t start_us) {
+    ctx->start_type = type;
+    ctx->start_duration_us = (uint32_t)(time_us_64() - start_us);
+}
+
+// FNV-1a over the register image and driver configuration, field by field
+// so struct padding never reaches the hash
+static uint32_t checkpoint_checksum(const lora_checkpoint_t *checkpoint) {
+    const lora_config_t *config = &checkpoint->config;
+    uint32_t hash = 2166136261u;
+
+    hash = checksum_update(hash, checkpoint->image, sizeof(checkpoint->image));
+    hash = checksum_update(hash, &config->frequency, sizeof(config->frequency));
+    hash = checksum_update(hash, &config->power, sizeof(config->power));
+    hash = checksum_update(hash, &config->tx_power, sizeof(config->tx_power));
+    hash = checksum_update(hash, &config->spreading_factor, sizeof(config->spreading_factor));
+    hash = checksum_update(hash, &config->signal_bandwidth, sizeof(config->signal_bandwidth));
+    hash = checksum_update(hash, &config->coding_rate, sizeof(config->coding_rate));
+    hash = checksum_update(hash, &config->preamble_length, sizeof(config->preamble_length));
+    hash = checksum_update(hash, &config->sync_word, sizeof(config->sync_word));
+    hash = checksum_update(hash, &config->crc_enabled, sizeof(config->crc_enabled));
+    hash = checksum_update(hash, &config->invert_iq, sizeof(config->invert_iq));
+    hash = checksum_update(hash, &config->dio0_pin, sizeof(config->dio0_pin));
+
+    return hash;
+}
+
+static uint32_t checksum_update(uint32_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static bool wait_tx_done(lora_ctx_t *ctx) {
+    // Wait for TX done
+    while ((read_register(ctx, REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) == 0) {
+        if (time_us_64() > ctx->tx_deadline_us) {
+            tx_timed_out(ctx);
+            return false;
+        }
+        sleep_ms(1);
+    }
+    tx_finished(ctx);
+    return true;
+}
+
+// Twice the time on air of the loaded payload; a TX still running by then is stuck
+static void arm_tx_deadline(lora_ctx_t *ctx) {
+    uint8_t length = read_register(ctx, REG_PAYLOAD_LENGTH);
+    ctx->tx_deadline_us = ctx->tx_start_us + 2ULL * lora_packet_time_on_air_us(ctx, length) + LORA_TX_TIMEOUT_MARGIN_US;
+}
+
+static void tx_finished(lora_ctx_t *ctx) {
+    ctx->tx_done_us = lora_take_event_timestamp(ctx);
+    ctx->tx_deadline_us = 0;
+
+    // Clear IRQ's
+    write_register(ctx, REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+
+    if (ctx->stats) {
+        lora_stats_tx_done(ctx->stats, (uint32_t)(ctx->tx_done_us - ctx->tx_start_us));
+    }
+}
+
+static void tx_timed_out(lora_ctx_t *ctx) {
+    uint32_t overrun_us = (uint32_t)(time_us_64() - ctx->tx_start_us);
+
+    lora_recover(ctx);
+    ctx->last_recovery.overrun_us = overrun_us;
+    LORA_LOG_WARN(ctx, "TX timeout after %lu us, recovery %d took %lu us", (unsigned long)overrun_us,
+                  ctx->last_recovery.action, (unsigned long)ctx->last_recovery.duration_us);
+
+    if (ctx->stats) {
+        lora_stats_tx_timeout(ctx->stats);
+    }
+}
+
+static int rssi_offset(lora_ctx_t *ctx) {
+    return lora_rssi_offset(ctx->config.frequency);
+}
+
 static int get_spreading_factor(lora_ctx_t *ctx) {
     return read_register(ctx, REG_MODEM_CONFIG_2) >> 4;
 }
 
 static uint32_t get_signal_bandwidth(lora_ctx_t *ctx) {
-    uint8_t bw = (read_register(ctx, REG_MODEM_CONFIG_1) >> 4);
-    switch (bw) {
-        case 0: return 7.8E3;
-        case 1: return 10.4E3;
-        case 2: return 15.6E3;
-        case 3: return 20.8E3;
-        case 4: return 31.25E3;
-        case 5: return 41.7E3;
-        case 6: return 62.5E3;
-        case 7: return 125E3;
-        case 8: return 250E3;
-        case 9: return 500E3;
-    }
-    return 0;
+    return lora_bandwidth_hz(read_register(ctx, REG_MODEM_CONFIG_1) >> 4);
 } 
\ No newline at end of file
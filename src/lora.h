@@ -4,70 +4,46 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "print.h"
+#include "lora_registers.h"
 #include "pico/time.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Error printing configuration
 #ifndef LORA_ERROR_PRINT
 #define LORA_ERROR_PRINT 1
 #endif
 
-// Maximum packet length
-#define MAX_PKT_LENGTH 255
-
-// LoRa registers
-#define REG_FIFO                 0x00
-#define REG_OP_MODE             0x01
-#define REG_FRF_MSB             0x06
-#define REG_FRF_MID             0x07
-#define REG_FRF_LSB             0x08
-#define REG_PA_CONFIG           0x09
-#define REG_LNA                 0x0c
-#define REG_FIFO_ADDR_PTR       0x0d
-#define REG_FIFO_TX_BASE_ADDR   0x0e
-#define REG_FIFO_RX_BASE_ADDR   0x0f
-#define REG_FIFO_RX_CURRENT_ADDR 0x10
-#define REG_IRQ_FLAGS           0x12
-#define REG_RX_NB_BYTES         0x13
-#define REG_PKT_SNR_VALUE       0x19
-#define REG_PKT_RSSI_VALUE      0x1a
-#define REG_MODEM_CONFIG_1      0x1d
-#define REG_MODEM_CONFIG_2      0x1e
-#define REG_PREAMBLE_MSB        0x20
-#define REG_PREAMBLE_LSB        0x21
-#define REG_PAYLOAD_LENGTH      0x22
-#define REG_MODEM_CONFIG_3      0x26
-#define REG_FREQ_ERROR_MSB      0x28
-#define REG_FREQ_ERROR_MID      0x29
-#define REG_FREQ_ERROR_LSB      0x2a
-#define REG_RSSI_WIDEBAND       0x2c
-#define REG_DETECTION_OPTIMIZE   0x31
-#define REG_DETECTION_THRESHOLD  0x37
-#define REG_SYNC_WORD           0x39
-#define REG_DIO_MAPPING_1       0x40
-#define REG_VERSION             0x42
-#define REG_PA_DAC              0x4d
-#define REG_INVERTIQ            0x33
-#define REG_INVERTIQ2           0x3b
-#define REG_OCP                 0x0b
-
-// Modes
-#define MODE_LONG_RANGE_MODE    0x80
-#define MODE_SLEEP             0x00
-#define MODE_STDBY             0x01
-#define MODE_TX                0x03
-#define MODE_RX_CONTINUOUS     0x05
-#define MODE_RX_SINGLE         0x06
-#define MODE_CAD               0x07
-
-// PA config
-#define PA_BOOST               0x80
-#define PA_OUTPUT_RFO_PIN      0
-#define PA_OUTPUT_PA_BOOST_PIN 1
-
-// IRQ masks
-#define IRQ_TX_DONE_MASK           0x08
-#define IRQ_PAYLOAD_CRC_ERROR_MASK 0x20
-#define IRQ_RX_DONE_MASK           0x40
+// Log levels
+#define LORA_LOG_LEVEL_NONE    0
+#define LORA_LOG_LEVEL_ERROR   1
+#define LORA_LOG_LEVEL_WARN    2
+#define LORA_LOG_LEVEL_INFO    3
+#define LORA_LOG_LEVEL_DEBUG   4
+
+// Call sites above this level are compiled out
+#ifndef LORA_LOG_LEVEL
+#define LORA_LOG_LEVEL LORA_LOG_LEVEL_INFO
+#endif
+
+// Longest formatted log line, including prefix and line ending
+#ifndef LORA_LOG_LINE_LENGTH
+#define LORA_LOG_LINE_LENGTH 128
+#endif
+
+// Scheduled transmission: sleep until this long before the deadline, then spin
+#ifndef LORA_TX_SCHEDULE_SPIN_US
+#define LORA_TX_SCHEDULE_SPIN_US 200
+#endif
+
+// TX is given up after twice its time on air plus this margin
+#ifndef LORA_TX_TIMEOUT_MARGIN_US
+#define LORA_TX_TIMEOUT_MARGIN_US 10000
+#endif
+
+struct lora_stats;
 
 // LoRa configuration
 typedef struct {
@@ -75,30 +51,126 @@ typedef struct {
     int8_t power;
     uint8_t tx_power;
     uint8_t spreading_factor;
-    uint8_t signal_bandwidth;
-    uint8_t coding_rate;
-    uint8_t preamble_length;
+    uint8_t signal_bandwidth;   // REG_MODEM_CONFIG_1 bandwidth index (0-9)
+    uint8_t coding_rate;        // Coding rate denominator (5-8)
+    uint16_t preamble_length;
     uint8_t sync_word;
     bool crc_enabled;
     bool invert_iq;
     uint8_t dio0_pin;
 } lora_config_t;
 
+// Link quality of a received packet, captured in one burst read
+typedef struct {
+    int16_t rssi_dbm;               // Packet RSSI, corrected for SNR
+    int16_t current_rssi_dbm;       // Channel RSSI when captured
+    int8_t snr_q;                   // Packet SNR in quarter dB
+    int32_t frequency_error_hz;     // Transmitter offset as seen by this receiver
+    bool crc_on_payload;            // Header announced a payload CRC
+} lora_link_quality_t;
+
+// How the radio was brought up
+typedef enum {
+    LORA_START_FAILED = 0,
+    LORA_START_COLD,        // Reset and programmed from defaults (lora_begin)
+    LORA_START_WARM,        // Radio already held the checkpointed configuration
+    LORA_START_RESTORED     // Reset and restored from a checkpoint
+} lora_start_t;
+
+// Configuration checkpoint for fast resume
+#define LORA_CHECKPOINT_SIZE    25
+
+typedef struct {
+    uint8_t image[LORA_CHECKPOINT_SIZE];    // Configuration registers, range by range
+    lora_config_t config;
+    uint32_t checksum;                      // Validates the checkpoint itself
+} lora_checkpoint_t;
+
+// What recovery after a TX timeout had to do
+typedef enum {
+    LORA_RECOVERY_NONE = 0,
+    LORA_RECOVERY_VERIFIED,     // Radio answered with its configuration intact
+    LORA_RECOVERY_REPROGRAMMED, // Configuration had drifted and was rewritten
+    LORA_RECOVERY_RESET,        // Radio lost; reset and reprogrammed
+    LORA_RECOVERY_FAILED        // Radio did not come back
+} lora_recovery_t;
+
+typedef struct {
+    lora_recovery_t action;
+    uint64_t timestamp_us;      // When the timeout was detected
+    uint32_t overrun_us;        // Detection time past the TX start
+    uint32_t duration_us;       // Time spent recovering
+} lora_recovery_event_t;
+
+// Modem selected in REG_OP_MODE
+typedef enum {
+    LORA_MODEM_LORA = 0,
+    LORA_MODEM_FSK
+} lora_modem_t;
+
 // LoRa context
 typedef struct {
     print_ctx_t print;
     lora_config_t config;
+    lora_modem_t modem;
     bool initialized;
     int implicit_header_mode;
     uint8_t frequency_error;
-    int8_t packet_index;
-    int8_t packet_length;
-    int16_t packet_rssi;
-    float packet_snr;
+    int16_t packet_index;
+    int16_t packet_length;
+    lora_link_quality_t link;       // Captured for each packet by lora_parse_packet
     bool is_receiving;
     bool enable_crc;
+    bool require_payload_crc;       // Drop explicit-header frames without CrcOnPayload
+    bool timestamps_enabled;
+    volatile uint64_t dio0_timestamp_us;  // Written from the DIO0 GPIO interrupt
+    uint64_t packet_timestamp_us;         // RX done time of the current packet
+    uint64_t tx_start_us;                 // Time the last TX was keyed up
+    uint64_t tx_done_us;                  // TX done time of the last packet
+    uint64_t tx_deadline_us;              // TX counts as timed out after this
+    struct lora_stats *stats;             // Optional, see lora_stats_init
+    bool recovery_enabled;
+    lora_checkpoint_t recovery;           // Known-good configuration for recovery
+    lora_recovery_event_t last_recovery;
+    uint32_t recovery_count;
+    lora_start_t start_type;
+    uint32_t start_duration_us;           // Time spent in lora_begin/lora_resume
 } lora_ctx_t;
 
+// Register image captured in one burst
+#define LORA_REG_FIRST          0x01
+#define LORA_REG_COUNT          128
+
+// Drifted registers remembered per watch snapshot
+#ifndef LORA_REG_WATCH_MAX_DIFFS
+#define LORA_REG_WATCH_MAX_DIFFS 16
+#endif
+
+typedef struct {
+    uint8_t regs[LORA_REG_COUNT];   // Indexed by address; REG_FIFO is not captured
+    uint64_t timestamp_us;
+} lora_reg_snapshot_t;
+
+typedef struct {
+    uint8_t address;
+    uint8_t before;
+    uint8_t after;
+} lora_reg_diff_t;
+
+// Periodic snapshots compared against a baseline configuration
+typedef struct {
+    lora_ctx_t *lora;
+    lora_reg_snapshot_t baseline;
+    lora_reg_snapshot_t current;
+    uint8_t ignore[LORA_REG_COUNT / 8];     // Registers expected to change
+    uint32_t interval_us;
+    uint64_t next_us;
+    lora_reg_diff_t drift[LORA_REG_WATCH_MAX_DIFFS];
+    uint8_t drift_count;
+    uint32_t snapshots;
+    uint32_t drift_events;
+} lora_reg_watch_t;
+
 // Initialize LoRa context
 void lora_init(lora_ctx_t *ctx);
 
@@ -108,15 +180,46 @@ bool lora_begin(lora_ctx_t *ctx, uint32_t frequency);
 // End LoRa operation
 void lora_end(lora_ctx_t *ctx);
 
+// Fast resume from a configuration checkpoint
+void lora_checkpoint_save(lora_ctx_t *ctx, lora_checkpoint_t *checkpoint);
+bool lora_checkpoint_valid(const lora_checkpoint_t *checkpoint);
+bool lora_checkpoint_matches(lora_ctx_t *ctx, const lora_checkpoint_t *checkpoint);
+void lora_checkpoint_restore(lora_ctx_t *ctx, const lora_checkpoint_t *checkpoint);
+lora_start_t lora_resume(lora_ctx_t *ctx, const lora_checkpoint_t *checkpoint);
+lora_start_t lora_start_type(lora_ctx_t *ctx);
+uint32_t lora_start_duration_us(lora_ctx_t *ctx);
+
 // Send packet
 bool lora_begin_packet(lora_ctx_t *ctx, bool implicit_header);
 bool lora_end_packet(lora_ctx_t *ctx, bool async);
+bool lora_end_packet_at(lora_ctx_t *ctx, uint64_t deadline_us, bool async);
+bool lora_is_transmitting(lora_ctx_t *ctx);
+
+// TX timeout recovery. A TX still running at twice its time on air plus
+// LORA_TX_TIMEOUT_MARGIN_US is aborted, then the radio is verified against
+// the checkpoint taken here, rewritten, or reset and rewritten. Call again
+// after changing the configuration. Worst case for a blocking send is the
+// deadline plus one reset (LORA_RESET_PULSE_US + LORA_RESET_TIMEOUT_US).
+void lora_enable_recovery(lora_ctx_t *ctx);
+void lora_disable_recovery(lora_ctx_t *ctx);
+lora_recovery_t lora_recover(lora_ctx_t *ctx);
+const lora_recovery_event_t *lora_last_recovery(lora_ctx_t *ctx);
 
 // Receive packet
 int lora_parse_packet(lora_ctx_t *ctx, int size);
 int lora_packet_rssi(lora_ctx_t *ctx);
 float lora_packet_snr(lora_ctx_t *ctx);
 long lora_packet_frequency_error(lora_ctx_t *ctx);
+const lora_link_quality_t *lora_packet_link_quality(lora_ctx_t *ctx);
+void lora_read_link_quality(lora_ctx_t *ctx, lora_link_quality_t *link);
+
+// Event timestamps (time_us_64() at the DIO0 edge)
+void lora_enable_timestamps(lora_ctx_t *ctx);
+void lora_disable_timestamps(lora_ctx_t *ctx);
+uint64_t lora_take_event_timestamp(lora_ctx_t *ctx);
+uint64_t lora_packet_timestamp(lora_ctx_t *ctx);
+uint64_t lora_tx_start_timestamp(lora_ctx_t *ctx);
+uint64_t lora_tx_done_timestamp(lora_ctx_t *ctx);
 
 // Write data
 size_t lora_write(lora_ctx_t *ctx, const uint8_t *buffer, size_t size);
@@ -132,8 +235,13 @@ size_t lora_read_bytes(lora_ctx_t *ctx, uint8_t *buffer, size_t size);
 // Configuration
 void lora_idle(lora_ctx_t *ctx);
 void lora_sleep(lora_ctx_t *ctx);
+void lora_set_mode(lora_ctx_t *ctx, uint8_t mode);
+void lora_set_modem(lora_ctx_t *ctx, lora_modem_t modem);
+lora_modem_t lora_modem(lora_ctx_t *ctx);
 void lora_set_tx_power(lora_ctx_t *ctx, int level, int output_pin);
 void lora_set_frequency(lora_ctx_t *ctx, uint32_t frequency);
+void lora_frequency_to_frf(uint32_t frequency, uint8_t frf[3]);
+void lora_set_frf(lora_ctx_t *ctx, const uint8_t frf[3]);
 void lora_set_spreading_factor(lora_ctx_t *ctx, int sf);
 void lora_set_signal_bandwidth(lora_ctx_t *ctx, uint32_t sbw);
 void lora_set_coding_rate4(lora_ctx_t *ctx, int denominator);
@@ -141,23 +249,80 @@ void lora_set_preamble_length(lora_ctx_t *ctx, uint16_t length);
 void lora_set_sync_word(lora_ctx_t *ctx, int sw);
 void lora_enable_crc(lora_ctx_t *ctx);
 void lora_disable_crc(lora_ctx_t *ctx);
+
+// With CRC enabled, drop explicit-header frames whose header announces no
+// payload CRC instead of accepting them unchecked. Off by default.
+void lora_require_payload_crc(lora_ctx_t *ctx, bool require);
 void lora_enable_invert_iq(lora_ctx_t *ctx);
 void lora_disable_invert_iq(lora_ctx_t *ctx);
 void lora_set_ocp(lora_ctx_t *ctx, uint8_t current);
 
+// Airtime
+uint32_t lora_bandwidth_hz(uint8_t bandwidth_index);
+uint32_t lora_time_on_air_us(const lora_config_t *config, bool implicit_header, uint8_t payload_length);
+uint32_t lora_packet_time_on_air_us(lora_ctx_t *ctx, uint8_t payload_length);
+
 // Status
 uint8_t lora_random(lora_ctx_t *ctx);
 void lora_dump_registers(lora_ctx_t *ctx);
+
+// Register snapshots
+void lora_snapshot_registers(lora_ctx_t *ctx, lora_reg_snapshot_t *snapshot);
+size_t lora_diff_registers(const lora_reg_snapshot_t *before, const lora_reg_snapshot_t *after,
+                           const uint8_t *ignore, lora_reg_diff_t *diffs, size_t max);
+void lora_print_registers(print_ctx_t *print, const lora_reg_snapshot_t *snapshot);
+void lora_print_register_diff(print_ctx_t *print, const lora_reg_diff_t *diffs, size_t count);
+
+// Configuration drift watch
+void lora_watch_begin(lora_reg_watch_t *watch, lora_ctx_t *ctx, uint32_t interval_us);
+void lora_watch_rebaseline(lora_reg_watch_t *watch);
+void lora_watch_ignore(lora_reg_watch_t *watch, uint8_t address);
+int lora_watch_poll(lora_reg_watch_t *watch);
 int16_t lora_rssi(lora_ctx_t *ctx);
+int lora_rssi_offset(uint32_t frequency);
 float lora_snr(lora_ctx_t *ctx);
 
 // Low-level SPI
 uint8_t lora_single_transfer(lora_ctx_t *ctx, uint8_t address, uint8_t value);
+uint8_t lora_read_register(lora_ctx_t *ctx, uint8_t address);
+void lora_write_register(lora_ctx_t *ctx, uint8_t address, uint8_t value);
+void lora_read_register_burst(lora_ctx_t *ctx, uint8_t address, uint8_t *buffer, size_t size);
+void lora_write_register_burst(lora_ctx_t *ctx, uint8_t address, const uint8_t *buffer, size_t size);
 
 // Error printing functions
 #if LORA_ERROR_PRINT
+void lora_log(lora_ctx_t *ctx, int level, const char *format, ...);
 void lora_error_print(lora_ctx_t *ctx, const char *format, ...);
 void lora_error_print_hex(lora_ctx_t *ctx, const char *prefix, const uint8_t *data, size_t len);
 #endif
 
-#endif // LORA_H 
\ No newline at end of file
+// Leveled logging; disabled levels cost nothing at the call site
+#if LORA_ERROR_PRINT && LORA_LOG_LEVEL >= LORA_LOG_LEVEL_ERROR
+#define LORA_LOG_ERROR(ctx, ...) lora_log((ctx), LORA_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LORA_LOG_ERROR(ctx, ...) ((void)0)
+#endif
+
+#if LORA_ERROR_PRINT && LORA_LOG_LEVEL >= LORA_LOG_LEVEL_WARN
+#define LORA_LOG_WARN(ctx, ...) lora_log((ctx), LORA_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LORA_LOG_WARN(ctx, ...) ((void)0)
+#endif
+
+#if LORA_ERROR_PRINT && LORA_LOG_LEVEL >= LORA_LOG_LEVEL_INFO
+#define LORA_LOG_INFO(ctx, ...) lora_log((ctx), LORA_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LORA_LOG_INFO(ctx, ...) ((void)0)
+#endif
+
+#if LORA_ERROR_PRINT && LORA_LOG_LEVEL >= LORA_LOG_LEVEL_DEBUG
+#define LORA_LOG_DEBUG(ctx, ...) lora_log((ctx), LORA_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LORA_LOG_DEBUG(ctx, ...) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LORA_H 
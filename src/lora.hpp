@@ -0,0 +1,472 @@
+#ifndef LORA_HPP
+#define LORA_HPP
+
+// Header-only C++ driver for the SX127x. The SPI port, pins and logging are
+// template parameters, so register transfers compile down to direct accesses
+// to the PL022 data/status registers with constant pin masks, and a disabled
+// log policy leaves no code behind. Register definitions are shared with the
+// C driver through lora_registers.h.
+//
+//   using Radio = lora::Sx127x<lora::Spi0, 8, 9, 10>;
+//   Radio radio;
+//   radio.begin(868100000);
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "lora_registers.h"
+
+namespace lora {
+
+// SPI controller and pins bound at compile time
+template <uint Index, uint SckPin, uint MosiPin, uint MisoPin, uint ClockHz = 10000000>
+struct SpiPort {
+    static_assert(Index < 2, "RP2040 has spi0 and spi1");
+
+    static spi_inst_t *inst() {
+        return Index == 0 ? spi0 : spi1;
+    }
+
+    static spi_hw_t *hw() {
+        return Index == 0 ? spi0_hw : spi1_hw;
+    }
+
+    static void init() {
+        spi_init(inst(), ClockHz);
+        gpio_set_function(SckPin, GPIO_FUNC_SPI);
+        gpio_set_function(MosiPin, GPIO_FUNC_SPI);
+        gpio_set_function(MisoPin, GPIO_FUNC_SPI);
+    }
+
+    // One byte in lock-step; the RX FIFO is empty between transactions
+    static inline uint8_t transfer(uint8_t value) {
+        spi_hw_t *spi = hw();
+        while (!(spi->sr & SPI_SSPSR_TNF_BITS)) {
+        }
+        spi->dr = value;
+        while (!(spi->sr & SPI_SSPSR_RNE_BITS)) {
+        }
+        return (uint8_t)spi->dr;
+    }
+
+    // Keep the TX FIFO full, then discard what came back
+    static inline void write(const uint8_t *buffer, size_t size) {
+        spi_hw_t *spi = hw();
+        for (size_t i = 0; i < size; i++) {
+            while (!(spi->sr & SPI_SSPSR_TNF_BITS)) {
+            }
+            spi->dr = buffer[i];
+        }
+        while (spi->sr & SPI_SSPSR_BSY_BITS) {
+        }
+        while (spi->sr & SPI_SSPSR_RNE_BITS) {
+            (void)spi->dr;
+        }
+        spi->icr = SPI_SSPICR_RORIC_BITS;
+    }
+
+    // Up to a FIFO's worth of dummy bytes in flight
+    static inline void read(uint8_t *buffer, size_t size) {
+        spi_hw_t *spi = hw();
+        const size_t fifo_depth = 8;
+        size_t tx = size;
+        size_t rx = size;
+        while (tx || rx) {
+            if (tx && (spi->sr & SPI_SSPSR_TNF_BITS) && rx < tx + fifo_depth) {
+                spi->dr = 0;
+                tx--;
+            }
+            if (rx && (spi->sr & SPI_SSPSR_RNE_BITS)) {
+                *buffer++ = (uint8_t)spi->dr;
+                rx--;
+            }
+        }
+    }
+};
+
+// Same wiring as the C driver (lora.c)
+using Spi0 = SpiPort<0, 18, 19, 16>;
+
+// Logging policies
+struct NoLog {
+    template <typename... Args> static void error(const char *, Args...) {}
+    template <typename... Args> static void warn(const char *, Args...) {}
+    template <typename... Args> static void info(const char *, Args...) {}
+    template <typename... Args> static void debug(const char *, Args...) {}
+};
+
+// Same prefixes and line endings as lora_log()
+struct StdioLog {
+    template <typename... Args> static void error(const char *format, Args... args) {
+        line("[LoRa Error] ", format, args...);
+    }
+    template <typename... Args> static void warn(const char *format, Args... args) {
+        line("[LoRa Warn] ", format, args...);
+    }
+    template <typename... Args> static void info(const char *format, Args... args) {
+        line("[LoRa Info] ", format, args...);
+    }
+    template <typename... Args> static void debug(const char *format, Args... args) {
+        line("[LoRa Debug] ", format, args...);
+    }
+
+private:
+    template <typename... Args> static void line(const char *prefix, const char *format, Args... args) {
+        fputs(prefix, stdout);
+        if constexpr (sizeof...(Args) > 0) {
+            printf(format, args...);
+        } else {
+            fputs(format, stdout);
+        }
+        fputs("\r\n", stdout);
+    }
+};
+
+template <typename Spi, uint CsPin, uint ResetPin, uint Dio0Pin, typename Log = NoLog>
+class Sx127x {
+public:
+    // Begin LoRa operation
+    bool begin(uint32_t frequency) {
+        Log::debug("begin %lu", (unsigned long)frequency);
+
+        Spi::init();
+        gpio_init(CsPin);
+        gpio_put(CsPin, 1);
+        gpio_set_dir(CsPin, GPIO_OUT);
+        gpio_init(ResetPin);
+        gpio_put(ResetPin, 1);
+        gpio_set_dir(ResetPin, GPIO_OUT);
+        gpio_init(Dio0Pin);
+        gpio_set_dir(Dio0Pin, GPIO_IN);
+
+        // Reset module and check version
+        gpio_put(ResetPin, 0);
+        sleep_us(LORA_RESET_PULSE_US);
+        gpio_put(ResetPin, 1);
+
+        uint8_t version;
+        uint64_t deadline = time_us_64() + LORA_RESET_TIMEOUT_US;
+        do {
+            version = read_register(REG_VERSION);
+            if (version == 0x12) {
+                break;
+            }
+            sleep_us(100);
+        } while (time_us_64() < deadline);
+
+        if (version != 0x12) {
+            Log::error("Failed to read the REG_VERSION register");
+            return false;
+        }
+
+        sleep();
+        set_frequency(frequency);
+
+        // Base addresses, LNA boost, auto AGC
+        write_register(REG_FIFO_TX_BASE_ADDR, 0);
+        write_register(REG_FIFO_RX_BASE_ADDR, 0);
+        write_register(REG_LNA, read_register(REG_LNA) | 0x03);
+        write_register(REG_MODEM_CONFIG_3, 0x04);
+
+        set_tx_power(17);
+        idle();
+        return true;
+    }
+
+    void end() {
+        sleep();
+    }
+
+    // Send packet
+    bool begin_packet(bool implicit_header = false) {
+        if (is_transmitting()) {
+            return false;
+        }
+
+        idle();
+        set_implicit_header(implicit_header);
+        write_register(REG_FIFO_ADDR_PTR, 0);
+        write_register(REG_PAYLOAD_LENGTH, 0);
+        return true;
+    }
+
+    bool end_packet(bool async = false) {
+        if (async) {
+            write_register(REG_DIO_MAPPING_1, DIO0_TX_DONE);
+        }
+        write_register(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_TX);
+
+        if (!async) {
+            while ((read_register(REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) == 0) {
+                sleep_ms(1);
+            }
+            write_register(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+        }
+        return true;
+    }
+
+    bool is_transmitting() {
+        if ((read_register(REG_OP_MODE) & 0x07) == MODE_TX) {
+            return true;
+        }
+        if (read_register(REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) {
+            write_register(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+        }
+        return false;
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) {
+        size_t current_length = read_register(REG_PAYLOAD_LENGTH);
+
+        if (current_length + size > MAX_PKT_LENGTH) {
+            size = MAX_PKT_LENGTH - current_length;
+        }
+        write_register_burst(REG_FIFO, buffer, size);
+        write_register(REG_PAYLOAD_LENGTH, (uint8_t)(current_length + size));
+        return size;
+    }
+
+    // Receive packet; polls RX_SINGLE like lora_parse_packet()
+    int parse_packet(int size = 0) {
+        int packet_length = 0;
+        uint8_t irq_flags = read_register(REG_IRQ_FLAGS);
+
+        set_implicit_header(size > 0);
+        if (size > 0) {
+            write_register(REG_PAYLOAD_LENGTH, (uint8_t)size);
+        }
+        write_register(REG_IRQ_FLAGS, irq_flags);
+
+        if ((irq_flags & IRQ_RX_DONE_MASK) && (irq_flags & IRQ_PAYLOAD_CRC_ERROR_MASK) == 0) {
+            packet_index_ = 0;
+            packet_length = read_register(implicit_header_ ? REG_PAYLOAD_LENGTH : REG_RX_NB_BYTES);
+            packet_length_ = (int16_t)packet_length;
+            write_register(REG_FIFO_ADDR_PTR, read_register(REG_FIFO_RX_CURRENT_ADDR));
+            idle();
+        } else if (read_register(REG_OP_MODE) != (MODE_LONG_RANGE_MODE | MODE_RX_SINGLE)) {
+            write_register(REG_FIFO_ADDR_PTR, 0);
+            write_register(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_SINGLE);
+        }
+
+        return packet_length;
+    }
+
+    int available() const {
+        return packet_length_ - packet_index_;
+    }
+
+    int read() {
+        if (available() <= 0) {
+            return -1;
+        }
+        packet_index_++;
+        return read_register(REG_FIFO);
+    }
+
+    size_t read_bytes(uint8_t *buffer, size_t size) {
+        int remaining = available();
+
+        if (remaining <= 0) {
+            return 0;
+        }
+        if (size > (size_t)remaining) {
+            size = remaining;
+        }
+        read_register_burst(REG_FIFO, buffer, size);
+        packet_index_ += size;
+        return size;
+    }
+
+    int16_t packet_rssi() {
+        return read_register(REG_PKT_RSSI_VALUE) - (frequency_ < 868000000 ? 164 : 157);
+    }
+
+    // Quarter dB
+    int8_t packet_snr_q() {
+        return (int8_t)read_register(REG_PKT_SNR_VALUE);
+    }
+
+    bool dio0() const {
+        return gpio_get(Dio0Pin);
+    }
+
+    // Symbol duration at the configured spreading factor and bandwidth
+    uint32_t symbol_time_us() {
+        uint8_t bw = read_register(REG_MODEM_CONFIG_1) >> 4;
+        uint8_t sf = read_register(REG_MODEM_CONFIG_2) >> 4;
+        return (uint32_t)(((1ULL << sf) * 1000000ULL) / bandwidth_hz(bw));
+    }
+
+    // Time on air of a packet with the current registers (Semtech
+    // SX1276/77/78/79 4.1.1.6.), as lora_time_on_air_us() in the C driver
+    uint32_t time_on_air_us(uint8_t payload_length) {
+        uint8_t config1 = read_register(REG_MODEM_CONFIG_1);
+        uint8_t config2 = read_register(REG_MODEM_CONFIG_2);
+        uint32_t bandwidth = bandwidth_hz(config1 >> 4);
+        int sf = config2 >> 4;
+        int cr = (config1 >> 1) & 0x07;
+        int de = (read_register(REG_MODEM_CONFIG_3) & 0x08) ? 1 : 0;
+        uint16_t preamble = (read_register(REG_PREAMBLE_MSB) << 8) | read_register(REG_PREAMBLE_LSB);
+
+        int32_t num = 8 * payload_length - 4 * sf + 28 + ((config2 & 0x04) ? 16 : 0) - ((config1 & 0x01) ? 20 : 0);
+        int32_t den = 4 * (sf - 2 * de);
+        int32_t payload_symbols = 8;
+        if (num > 0) {
+            payload_symbols += ((num + den - 1) / den) * (cr + 4);
+        }
+
+        uint64_t quarter_symbols = 4 * ((uint64_t)preamble + payload_symbols) + 17;
+        return (uint32_t)((quarter_symbols * (1ULL << sf) * 1000000ULL) / (4ULL * bandwidth));
+    }
+
+    // Configuration
+    void idle() {
+        write_register(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_STDBY);
+    }
+
+    void sleep() {
+        write_register(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_SLEEP);
+    }
+
+    void set_tx_power(int level, bool pa_boost = true) {
+        if (!pa_boost) {
+            level = level < 0 ? 0 : level > 14 ? 14 : level;
+            write_register(REG_PA_CONFIG, 0x70 | level);
+            return;
+        }
+
+        if (level > 17) {
+            // High Power +20 dBm Operation (Semtech SX1276/77/78/79 5.4.3.)
+            level = (level > 20 ? 20 : level) - 3;
+            write_register(REG_PA_DAC, 0x87);
+            set_ocp(140);
+        } else {
+            level = level < 2 ? 2 : level;
+            write_register(REG_PA_DAC, 0x84);
+            set_ocp(100);
+        }
+        write_register(REG_PA_CONFIG, PA_BOOST | (level - 2));
+    }
+
+    void set_frequency(uint32_t frequency) {
+        uint64_t frf = ((uint64_t)frequency << 19) / 32000000;
+        const uint8_t bytes[3] = { (uint8_t)(frf >> 16), (uint8_t)(frf >> 8), (uint8_t)frf };
+
+        frequency_ = frequency;
+        write_register_burst(REG_FRF_MSB, bytes, 3);
+    }
+
+    void set_spreading_factor(int sf) {
+        sf = sf < 6 ? 6 : sf > 12 ? 12 : sf;
+
+        write_register(REG_DETECTION_OPTIMIZE, sf == 6 ? 0xc5 : 0xc3);
+        write_register(REG_DETECTION_THRESHOLD, sf == 6 ? 0x0c : 0x0a);
+        write_register(REG_MODEM_CONFIG_2, (read_register(REG_MODEM_CONFIG_2) & 0x0f) | (sf << 4));
+        set_ldo_flag();
+    }
+
+    // Bandwidth index 0-9 (7 = 125 kHz), as in lora_config_t
+    void set_signal_bandwidth_index(uint8_t bw) {
+        write_register(REG_MODEM_CONFIG_1, (read_register(REG_MODEM_CONFIG_1) & 0x0f) | ((bw > 9 ? 9 : bw) << 4));
+        set_ldo_flag();
+    }
+
+    void set_coding_rate4(int denominator) {
+        denominator = denominator < 5 ? 5 : denominator > 8 ? 8 : denominator;
+        write_register(REG_MODEM_CONFIG_1, (read_register(REG_MODEM_CONFIG_1) & 0xf1) | ((denominator - 4) << 1));
+    }
+
+    void set_preamble_length(uint16_t length) {
+        const uint8_t bytes[2] = { (uint8_t)(length >> 8), (uint8_t)length };
+        write_register_burst(REG_PREAMBLE_MSB, bytes, 2);
+    }
+
+    void set_sync_word(uint8_t sync_word) {
+        write_register(REG_SYNC_WORD, sync_word);
+    }
+
+    void enable_crc() {
+        write_register(REG_MODEM_CONFIG_2, read_register(REG_MODEM_CONFIG_2) | 0x04);
+    }
+
+    void disable_crc() {
+        write_register(REG_MODEM_CONFIG_2, read_register(REG_MODEM_CONFIG_2) & 0xfb);
+    }
+
+    void set_ocp(uint8_t current) {
+        uint8_t ocp_trim = current <= 120 ? (current - 45) / 5 : current <= 240 ? (current + 30) / 10 : 27;
+        write_register(REG_OCP, 0x20 | (0x1f & ocp_trim));
+    }
+
+    uint8_t random() {
+        return read_register(REG_RSSI_WIDEBAND);
+    }
+
+    // Low-level SPI
+    uint8_t read_register(uint8_t address) {
+        return single_transfer(address & 0x7f, 0x00);
+    }
+
+    void write_register(uint8_t address, uint8_t value) {
+        single_transfer(address | 0x80, value);
+    }
+
+    void read_register_burst(uint8_t address, uint8_t *buffer, size_t size) {
+        gpio_put(CsPin, 0);
+        Spi::transfer(address & 0x7f);
+        Spi::read(buffer, size);
+        gpio_put(CsPin, 1);
+    }
+
+    void write_register_burst(uint8_t address, const uint8_t *buffer, size_t size) {
+        gpio_put(CsPin, 0);
+        Spi::transfer(address | 0x80);
+        Spi::write(buffer, size);
+        gpio_put(CsPin, 1);
+    }
+
+private:
+    uint32_t frequency_ = 0;
+    bool implicit_header_ = false;
+    int16_t packet_index_ = 0;
+    int16_t packet_length_ = 0;
+
+    static inline uint8_t single_transfer(uint8_t address, uint8_t value) {
+        gpio_put(CsPin, 0);
+        Spi::transfer(address);
+        uint8_t response = Spi::transfer(value);
+        gpio_put(CsPin, 1);
+        return response;
+    }
+
+    void set_implicit_header(bool implicit_header) {
+        uint8_t config1 = read_register(REG_MODEM_CONFIG_1);
+
+        implicit_header_ = implicit_header;
+        write_register(REG_MODEM_CONFIG_1, implicit_header ? (config1 | 0x01) : (config1 & 0xfe));
+    }
+
+    static uint32_t bandwidth_hz(uint8_t bw) {
+        static const uint32_t hz[10] = {
+            7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000
+        };
+        return hz[bw > 9 ? 9 : bw];
+    }
+
+    // Low data rate optimization for symbols longer than 16 ms (4.1.1.6)
+    void set_ldo_flag() {
+        uint8_t bw = read_register(REG_MODEM_CONFIG_1) >> 4;
+        uint8_t sf = read_register(REG_MODEM_CONFIG_2) >> 4;
+        uint32_t symbol_ms = (1000 * (1UL << sf)) / (bandwidth_hz(bw) / 1000);
+        uint8_t config3 = read_register(REG_MODEM_CONFIG_3);
+
+        write_register(REG_MODEM_CONFIG_3, symbol_ms > 16 ? (config3 | 0x08) : (config3 & ~0x08));
+    }
+};
+
+} // namespace lora
+
+#endif // LORA_HPP
@@ -0,0 +1,206 @@
+#include "lora_aggregate.h"
+#include <string.h>
+
+// Forward declarations of static functions
+static bool send_frame(lora_aggregate_t *agg, uint32_t *reason);
+static bool frame_full(const lora_aggregate_t *agg);
+static uint32_t permille(uint64_t numerator, uint64_t denominator);
+
+void lora_aggregate_init(lora_aggregate_t *agg, lora_ctx_t *ctx, bool async) {
+    memset(agg, 0, sizeof(lora_aggregate_t));
+    agg->lora = ctx;
+    agg->async = async;
+}
+
+bool lora_aggregate_add(lora_aggregate_t *agg, const uint8_t *data, uint8_t length, uint32_t max_latency_us) {
+    if (length == 0 || length > LORA_AGGREGATE_MAX_RECORD) {
+        return false;
+    }
+
+    if (agg->length + LORA_AGGREGATE_RECORD_HEADER + length > MAX_PKT_LENGTH) {
+        if (!send_frame(agg, &agg->stats.flush_full)) {
+            return false;
+        }
+    }
+
+    if (max_latency_us == 0) {
+        max_latency_us = LORA_AGGREGATE_DEFAULT_LATENCY_US;
+    }
+    uint64_t deadline_us = time_us_64() + max_latency_us;
+    if (agg->records == 0 || deadline_us < agg->deadline_us) {
+        agg->deadline_us = deadline_us;
+    }
+
+    agg->frame[agg->length] = length;
+    memcpy(&agg->frame[agg->length + LORA_AGGREGATE_RECORD_HEADER], data, length);
+    agg->length += LORA_AGGREGATE_RECORD_HEADER + length;
+    agg->records++;
+    agg->solo_airtime_us += lora_time_on_air_us(&agg->lora->config, false, length);
+
+    // No room left for even a one-byte record; if the radio is busy the
+    // next poll retries
+    if (frame_full(agg)) {
+        send_frame(agg, &agg->stats.flush_full);
+    }
+    return true;
+}
+
+bool lora_aggregate_poll(lora_aggregate_t *agg) {
+    if (agg->records == 0) {
+        return false;
+    }
+    if (frame_full(agg)) {
+        return send_frame(agg, &agg->stats.flush_full);
+    }
+    if (time_us_64() >= agg->deadline_us) {
+        return send_frame(agg, &agg->stats.flush_deadline);
+    }
+    return false;
+}
+
+bool lora_aggregate_flush(lora_aggregate_t *agg) {
+    if (agg->records == 0) {
+        return false;
+    }
+    return send_frame(agg, &agg->stats.flush_manual);
+}
+
+size_t lora_aggregate_pending(const lora_aggregate_t *agg) {
+    return agg->records;
+}
+
+uint32_t lora_aggregate_time_to_deadline_us(const lora_aggregate_t *agg) {
+    if (agg->records == 0) {
+        return 0;
+    }
+
+    uint64_t now = time_us_64();
+    if (now >= agg->deadline_us) {
+        return 0;
+    }
+    uint64_t remaining = agg->deadline_us - now;
+    return remaining > UINT32_MAX ? UINT32_MAX : (uint32_t)remaining;
+}
+
+void lora_aggregate_reader_init(lora_aggregate_reader_t *reader, const uint8_t *frame, size_t length,
+                                lora_aggregate_stats_t *stats) {
+    reader->frame = frame;
+    reader->length = length;
+    reader->offset = 0;
+    reader->stats = stats;
+
+    if (stats) {
+        stats->frames_rx++;
+    }
+}
+
+bool lora_aggregate_next(lora_aggregate_reader_t *reader, const uint8_t **record, uint8_t *length) {
+    if (reader->offset >= reader->length) {
+        return false;
+    }
+
+    uint8_t n = reader->frame[reader->offset];
+    if (n == 0) {
+        // Padding after the last record
+        reader->offset = reader->length;
+        return false;
+    }
+    if (reader->offset + LORA_AGGREGATE_RECORD_HEADER + n > reader->length) {
+        reader->offset = reader->length;
+        if (reader->stats) {
+            reader->stats->malformed_rx++;
+        }
+        return false;
+    }
+
+    *record = &reader->frame[reader->offset + LORA_AGGREGATE_RECORD_HEADER];
+    *length = n;
+    reader->offset += LORA_AGGREGATE_RECORD_HEADER + n;
+    if (reader->stats) {
+        reader->stats->records_rx++;
+    }
+    return true;
+}
+
+uint32_t lora_aggregate_payload_permille(const lora_aggregate_t *agg) {
+    return permille(agg->stats.payload_bytes, agg->stats.frame_bytes);
+}
+
+uint32_t lora_aggregate_airtime_gain_permille(const lora_aggregate_t *agg) {
+    return permille(agg->stats.solo_airtime_us, agg->stats.airtime_us);
+}
+
+void lora_aggregate_print_stats(lora_aggregate_t *agg) {
+    print_ctx_t *p = &agg->lora->print;
+    const lora_aggregate_stats_t *s = &agg->stats;
+
+    print_str(p, "aggregate tx records=");
+    print_ulong(p, s->records_tx, DEC);
+    print_str(p, " frames=");
+    print_ulong(p, s->frames_tx, DEC);
+    print_str(p, " full=");
+    print_ulong(p, s->flush_full, DEC);
+    print_str(p, " deadline=");
+    print_ulong(p, s->flush_deadline, DEC);
+    print_str(p, " manual=");
+    print_ulong(p, s->flush_manual, DEC);
+    print_str(p, " fail=");
+    print_ulong(p, s->send_failures, DEC);
+    println(p);
+
+    print_str(p, "payload permille=");
+    print_ulong(p, lora_aggregate_payload_permille(agg), DEC);
+    print_str(p, " airtime gain permille=");
+    print_ulong(p, lora_aggregate_airtime_gain_permille(agg), DEC);
+    println(p);
+
+    print_str(p, "aggregate rx records=");
+    print_ulong(p, s->records_rx, DEC);
+    print_str(p, " frames=");
+    print_ulong(p, s->frames_rx, DEC);
+    print_str(p, " malformed=");
+    print_ulong(p, s->malformed_rx, DEC);
+    println(p);
+}
+
+// Private functions
+
+// One lora_write of the whole frame; on failure the frame stays pending
+static bool send_frame(lora_aggregate_t *agg, uint32_t *reason) {
+    lora_ctx_t *ctx = agg->lora;
+
+    if (!lora_begin_packet(ctx, false)) {
+        agg->stats.send_failures++;
+        return false;
+    }
+    lora_write(ctx, agg->frame, agg->length);
+    if (!lora_end_packet(ctx, agg->async)) {
+        agg->stats.send_failures++;
+        return false;
+    }
+
+    lora_aggregate_stats_t *s = &agg->stats;
+    s->records_tx += agg->records;
+    s->frames_tx++;
+    s->payload_bytes += agg->length - agg->records * LORA_AGGREGATE_RECORD_HEADER;
+    s->frame_bytes += agg->length;
+    s->airtime_us += lora_time_on_air_us(&ctx->config, false, agg->length);
+    s->solo_airtime_us += agg->solo_airtime_us;
+    (*reason)++;
+
+    agg->length = 0;
+    agg->records = 0;
+    agg->solo_airtime_us = 0;
+    return true;
+}
+
+static bool frame_full(const lora_aggregate_t *agg) {
+    return agg->length + LORA_AGGREGATE_RECORD_HEADER + 1 > MAX_PKT_LENGTH;
+}
+
+static uint32_t permille(uint64_t numerator, uint64_t denominator) {
+    if (denominator == 0) {
+        return 0;
+    }
+    return (uint32_t)(numerator * 1000 / denominator);
+}
@@ -0,0 +1,89 @@
+#ifndef LORA_AGGREGATE_H
+#define LORA_AGGREGATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lora.h"
+
+// Frame layout: records back to back, each [length][data]. A zero length
+// byte ends the frame early; a frame is at most MAX_PKT_LENGTH bytes.
+#define LORA_AGGREGATE_RECORD_HEADER    1
+#define LORA_AGGREGATE_MAX_RECORD       (MAX_PKT_LENGTH - LORA_AGGREGATE_RECORD_HEADER)
+
+// Latency used by lora_aggregate_add when none is given
+#ifndef LORA_AGGREGATE_DEFAULT_LATENCY_US
+#define LORA_AGGREGATE_DEFAULT_LATENCY_US 2000000
+#endif
+
+typedef struct {
+    uint32_t records_tx;
+    uint32_t frames_tx;
+    uint32_t flush_full;        // Frame full or the next record did not fit
+    uint32_t flush_deadline;    // Oldest record's latency expired
+    uint32_t flush_manual;
+    uint32_t send_failures;     // Radio busy; the frame was kept
+    uint64_t payload_bytes;     // Record data sent, without length prefixes
+    uint64_t frame_bytes;       // Frame bytes sent
+    uint64_t airtime_us;        // Air time of the aggregated frames
+    uint64_t solo_airtime_us;   // Air time had each record been its own packet
+    uint32_t records_rx;
+    uint32_t frames_rx;
+    uint32_t malformed_rx;      // Frames with a record overrunning the frame
+} lora_aggregate_stats_t;
+
+// The pending frame is built in place, so a flush is a single lora_write
+typedef struct {
+    lora_ctx_t *lora;
+    bool async;                 // Passed to lora_end_packet
+    uint8_t frame[MAX_PKT_LENGTH];
+    uint8_t length;
+    uint8_t records;
+    uint64_t deadline_us;       // Earliest deadline of the pending records
+    uint32_t solo_airtime_us;   // Pending records' air time if sent one by one
+    lora_aggregate_stats_t stats;
+} lora_aggregate_t;
+
+// Zero-copy iterator over a received frame
+typedef struct {
+    const uint8_t *frame;
+    size_t length;
+    size_t offset;
+    lora_aggregate_stats_t *stats;
+} lora_aggregate_reader_t;
+
+void lora_aggregate_init(lora_aggregate_t *agg, lora_ctx_t *ctx, bool async);
+
+// Queue a record that must be on air within max_latency_us (0 for the
+// default). The pending frame is sent first if the record does not fit.
+// False if the record is empty or too long, or the radio was busy.
+bool lora_aggregate_add(lora_aggregate_t *agg, const uint8_t *data, uint8_t length, uint32_t max_latency_us);
+
+// Send the pending frame once its deadline has passed; call often.
+// Returns true if a frame was sent.
+bool lora_aggregate_poll(lora_aggregate_t *agg);
+
+// Send the pending frame now
+bool lora_aggregate_flush(lora_aggregate_t *agg);
+
+size_t lora_aggregate_pending(const lora_aggregate_t *agg);
+
+// Time left before the pending frame is due; 0 if due or empty
+uint32_t lora_aggregate_time_to_deadline_us(const lora_aggregate_t *agg);
+
+// Split a received frame. Records point into frame, which must outlive
+// the reader. Receive counters go to stats unless it is NULL.
+void lora_aggregate_reader_init(lora_aggregate_reader_t *reader, const uint8_t *frame, size_t length,
+                                lora_aggregate_stats_t *stats);
+
+// Next record, or false at the end of the frame or on a truncated record
+bool lora_aggregate_next(lora_aggregate_reader_t *reader, const uint8_t **record, uint8_t *length);
+
+// Record data per frame byte, and solo air time per aggregated air time,
+// in thousandths
+uint32_t lora_aggregate_payload_permille(const lora_aggregate_t *agg);
+uint32_t lora_aggregate_airtime_gain_permille(const lora_aggregate_t *agg);
+
+void lora_aggregate_print_stats(lora_aggregate_t *agg);
+
+#endif // LORA_AGGREGATE_H
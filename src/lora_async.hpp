@@ -0,0 +1,494 @@
+#ifndef LORA_ASYNC_HPP
+#define LORA_ASYNC_HPP
+
+// C++20 coroutine API on top of the header-only driver (lora.hpp).
+//
+//   lora::Task ping(Async &radio, lora::Executor &executor) {
+//       uint8_t ack[8];
+//       for (;;) {
+//           co_await radio.send(frame, sizeof(frame));
+//           int n = co_await radio.receive(ack, sizeof(ack), 200000);
+//           co_await executor.sleep_for(n > 0 ? 1000000 : 100000);
+//       }
+//   }
+//
+// A single-threaded executor resumes tasks from timers and radio events.
+// Awaiters live in the suspended coroutine frame and are linked into the
+// executor and radio queues intrusively, so operations never allocate.
+// Task frames come from a fixed block pool sized by LORA_ASYNC_MAX_TASKS
+// and LORA_ASYNC_FRAME_SIZE; a task whose frame does not fit fails to spawn.
+//
+// Radio operations are serialized in submission order. While one is in
+// flight the radio is only touched over SPI after DIO0 rises or a deadline
+// passes, so idle flows cost one GPIO read per executor iteration.
+
+#if __cplusplus < 202002L
+#error "lora_async.hpp needs C++20 (coroutines)"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <coroutine>
+#include "pico/stdlib.h"
+#include "lora_registers.h"
+
+#ifndef LORA_ASYNC_MAX_TASKS
+#define LORA_ASYNC_MAX_TASKS    8
+#endif
+
+#ifndef LORA_ASYNC_FRAME_SIZE
+#define LORA_ASYNC_FRAME_SIZE   512
+#endif
+
+// A send whose TX done never comes resumes with false after twice its time
+// on air plus this margin
+#ifndef LORA_ASYNC_TX_MARGIN_US
+#define LORA_ASYNC_TX_MARGIN_US 10000
+#endif
+
+// A CAD takes about one symbol; without CAD done it resumes with false
+// after this many
+#ifndef LORA_ASYNC_CAD_SYMBOLS
+#define LORA_ASYNC_CAD_SYMBOLS  4
+#endif
+
+namespace lora {
+
+// Fixed pool for coroutine frames
+class FramePool {
+public:
+    static void *allocate(size_t size) noexcept {
+        if (size > LORA_ASYNC_FRAME_SIZE) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < LORA_ASYNC_MAX_TASKS; i++) {
+            if (!(used_ & (1u << i))) {
+                used_ |= 1u << i;
+                return blocks_[i].bytes;
+            }
+        }
+        return nullptr;
+    }
+
+    static void release(void *frame) noexcept {
+        for (size_t i = 0; i < LORA_ASYNC_MAX_TASKS; i++) {
+            if (frame == blocks_[i].bytes) {
+                used_ &= ~(1u << i);
+            }
+        }
+    }
+
+private:
+    static_assert(LORA_ASYNC_MAX_TASKS <= 32, "one bit per task");
+
+    struct alignas(8) Block {
+        uint8_t bytes[LORA_ASYNC_FRAME_SIZE];
+    };
+
+    static inline Block blocks_[LORA_ASYNC_MAX_TASKS];
+    static inline uint32_t used_ = 0;
+};
+
+// Intrusive link for anything waiting to be resumed
+struct Waiter {
+    Waiter *next = nullptr;
+    std::coroutine_handle<> handle;
+};
+
+// Polled by the executor on every iteration
+class EventSource {
+public:
+    virtual void poll(uint64_t now) = 0;
+    EventSource *next_source = nullptr;
+
+protected:
+    ~EventSource() = default;
+};
+
+class Executor;
+
+// Fire-and-forget coroutine; started with Executor::spawn()
+class Task {
+public:
+    struct promise_type {
+        Waiter start;
+        Executor *executor = nullptr;
+
+        Task get_return_object() noexcept {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        static Task get_return_object_on_allocation_failure() noexcept {
+            return Task(nullptr);
+        }
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept;
+        void unhandled_exception() noexcept {
+            abort();
+        }
+
+        static void *operator new(size_t size) noexcept {
+            return FramePool::allocate(size);
+        }
+        static void operator delete(void *frame, size_t) noexcept {
+            FramePool::release(frame);
+        }
+    };
+
+    Task(Task &&other) noexcept : handle_(other.handle_) {
+        other.handle_ = nullptr;
+    }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    // A task that was never spawned is destroyed with its owner
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool valid() const {
+        return (bool)handle_;
+    }
+
+private:
+    friend class Executor;
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+class Executor {
+public:
+    // Timer awaiter
+    struct Sleep : Waiter {
+        Executor *executor;
+        uint64_t deadline_us;
+
+        bool await_ready() const noexcept {
+            return time_us_64() >= deadline_us;
+        }
+        void await_suspend(std::coroutine_handle<> h) noexcept {
+            handle = h;
+            executor->add_timer(this);
+        }
+        void await_resume() const noexcept {
+        }
+    };
+
+    // Queue a task to start on the next iteration
+    bool spawn(Task &&task) {
+        if (!task.handle_) {
+            return false;
+        }
+        auto &promise = task.handle_.promise();
+        promise.executor = this;
+        promise.start.handle = task.handle_;
+        task.handle_ = nullptr;
+        live_tasks_++;
+        ready(&promise.start);
+        return true;
+    }
+
+    Sleep sleep_until(uint64_t deadline_us) {
+        Sleep sleep;
+        sleep.executor = this;
+        sleep.deadline_us = deadline_us;
+        return sleep;
+    }
+
+    Sleep sleep_for(uint32_t us) {
+        return sleep_until(time_us_64() + us);
+    }
+
+    void add_source(EventSource *source) {
+        source->next_source = sources_;
+        sources_ = source;
+    }
+
+    // Resume later from the ready queue rather than from inside a poll
+    void ready(Waiter *waiter) {
+        waiter->next = nullptr;
+        if (ready_tail_) {
+            ready_tail_->next = waiter;
+        } else {
+            ready_head_ = waiter;
+        }
+        ready_tail_ = waiter;
+    }
+
+    // One pass: expire timers, poll sources, resume what became ready.
+    // Returns false once every task has finished.
+    bool run_once() {
+        uint64_t now = time_us_64();
+
+        while (timers_ && static_cast<Sleep *>(timers_)->deadline_us <= now) {
+            Waiter *timer = timers_;
+            timers_ = timer->next;
+            ready(timer);
+        }
+
+        for (EventSource *source = sources_; source; source = source->next_source) {
+            source->poll(now);
+        }
+
+        // Only what is queued now; tasks resumed here may queue more
+        Waiter *waiter = ready_head_;
+        ready_head_ = ready_tail_ = nullptr;
+        while (waiter) {
+            Waiter *next = waiter->next;
+            waiter->handle.resume();
+            waiter = next;
+        }
+
+        return live_tasks_ > 0;
+    }
+
+    void run() {
+        while (run_once()) {
+            tight_loop_contents();
+        }
+    }
+
+    size_t live_tasks() const {
+        return live_tasks_;
+    }
+
+private:
+    friend struct Task::promise_type;
+
+    // Sorted by deadline
+    void add_timer(Sleep *timer) {
+        Waiter **link = &timers_;
+        while (*link && static_cast<Sleep *>(*link)->deadline_us <= timer->deadline_us) {
+            link = &(*link)->next;
+        }
+        timer->next = *link;
+        *link = timer;
+    }
+
+    Waiter *ready_head_ = nullptr;
+    Waiter *ready_tail_ = nullptr;
+    Waiter *timers_ = nullptr;      // Sleep awaiters
+    EventSource *sources_ = nullptr;
+    size_t live_tasks_ = 0;
+};
+
+inline void Task::promise_type::return_void() noexcept {
+    if (executor) {
+        executor->live_tasks_--;
+    }
+}
+
+// Result of receive(): payload length, 0 on timeout
+#define LORA_ASYNC_CRC_ERROR    (-1)
+
+// Awaitable radio operations over an Sx127x<> (or anything with the same
+// register, packet, timing and dio0() interface)
+template <typename Radio>
+class AsyncRadio : public EventSource {
+public:
+    enum class Kind : uint8_t { Send, Receive, Cad };
+
+    struct Operation : Waiter {
+        AsyncRadio *radio;
+        Kind kind;
+        const uint8_t *tx;
+        uint8_t *rx;
+        uint8_t size;
+        uint32_t timeout_us;
+        uint64_t deadline_us;
+        int result;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> h) noexcept {
+            handle = h;
+            radio->submit(this);
+        }
+    };
+
+    struct Send : Operation {
+        bool await_resume() const noexcept {
+            return this->result != 0;
+        }
+    };
+
+    struct Receive : Operation {
+        int await_resume() const noexcept {
+            return this->result;
+        }
+    };
+
+    struct Cad : Operation {
+        bool await_resume() const noexcept {
+            return this->result != 0;
+        }
+    };
+
+    AsyncRadio(Executor &executor, Radio &radio) : executor_(executor), radio_(radio) {
+        executor.add_source(this);
+    }
+
+    // Transmit; resumes with true on TX done, false if it never came
+    Send send(const uint8_t *buffer, uint8_t size) {
+        Send op;
+        init(op, Kind::Send);
+        op.tx = buffer;
+        op.size = size;
+        return op;
+    }
+
+    // Listen up to timeout_us; a frame whose header arrived in time is
+    // still completed. Resumes with its length, 0 on timeout or
+    // LORA_ASYNC_CRC_ERROR.
+    Receive receive(uint8_t *buffer, uint8_t capacity, uint32_t timeout_us) {
+        Receive op;
+        init(op, Kind::Receive);
+        op.rx = buffer;
+        op.size = capacity;
+        op.timeout_us = timeout_us;
+        return op;
+    }
+
+    // Channel activity detection; resumes with true if a preamble was seen,
+    // false if none was or CAD done never came
+    Cad cad() {
+        Cad op;
+        init(op, Kind::Cad);
+        return op;
+    }
+
+    void poll(uint64_t now) override {
+        if (current_ && (radio_.dio0() || now >= current_->deadline_us)) {
+            service(now);
+        }
+        if (!current_ && head_) {
+            start(now);
+        }
+    }
+
+private:
+    void init(Operation &op, Kind kind) {
+        op.radio = this;
+        op.kind = kind;
+        op.tx = nullptr;
+        op.rx = nullptr;
+        op.size = 0;
+        op.timeout_us = 0;
+        op.deadline_us = UINT64_MAX;
+        op.result = 0;
+    }
+
+    void submit(Operation *op) {
+        op->next = nullptr;
+        if (tail_) {
+            tail_->next = op;
+        } else {
+            head_ = op;
+        }
+        tail_ = op;
+    }
+
+    void start(uint64_t now) {
+        current_ = static_cast<Operation *>(head_);
+        head_ = current_->next;
+        if (!head_) {
+            tail_ = nullptr;
+        }
+
+        radio_.idle();
+        radio_.write_register(REG_IRQ_FLAGS, 0xff);
+
+        switch (current_->kind) {
+            case Kind::Send:
+                radio_.begin_packet(false);
+                radio_.write(current_->tx, current_->size);
+                radio_.end_packet(true);
+                current_->deadline_us = now + 2ULL * radio_.time_on_air_us(current_->size) + LORA_ASYNC_TX_MARGIN_US;
+                break;
+            case Kind::Receive:
+                current_->deadline_us = now + current_->timeout_us;
+                radio_.write_register(REG_DIO_MAPPING_1, DIO0_RX_DONE);
+                radio_.write_register(REG_FIFO_ADDR_PTR, 0);
+                radio_.write_register(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_CONTINUOUS);
+                break;
+            case Kind::Cad:
+                radio_.write_register(REG_DIO_MAPPING_1, DIO0_CAD_DONE);
+                radio_.write_register(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_CAD);
+                current_->deadline_us = now + (uint64_t)LORA_ASYNC_CAD_SYMBOLS * radio_.symbol_time_us();
+                break;
+        }
+    }
+
+    void service(uint64_t now) {
+        Operation *op = current_;
+        uint8_t flags = radio_.read_register(REG_IRQ_FLAGS);
+
+        switch (op->kind) {
+            case Kind::Send:
+                if (flags & IRQ_TX_DONE_MASK) {
+                    op->result = 1;
+                } else if (now < op->deadline_us) {
+                    return;
+                }
+                break;
+
+            case Kind::Receive:
+                if (flags & IRQ_RX_DONE_MASK) {
+                    op->result = receive_frame(op, flags);
+                } else if (flags & IRQ_VALID_HEADER_MASK) {
+                    // Header arrived before the deadline: wait for RX done
+                    return;
+                } else if (now < op->deadline_us) {
+                    return;
+                }
+                break;
+
+            case Kind::Cad:
+                if (flags & IRQ_CAD_DONE_MASK) {
+                    op->result = (flags & IRQ_CAD_DETECTED_MASK) ? 1 : 0;
+                } else if (now < op->deadline_us) {
+                    return;
+                }
+                break;
+        }
+
+        radio_.write_register(REG_IRQ_FLAGS, 0xff);
+        radio_.idle();
+        current_ = nullptr;
+        executor_.ready(op);
+    }
+
+    int receive_frame(Operation *op, uint8_t flags) {
+        if (flags & IRQ_PAYLOAD_CRC_ERROR_MASK) {
+            return LORA_ASYNC_CRC_ERROR;
+        }
+
+        uint8_t length = radio_.read_register(REG_RX_NB_BYTES);
+        if (length > op->size) {
+            length = op->size;
+        }
+        radio_.write_register(REG_FIFO_ADDR_PTR, radio_.read_register(REG_FIFO_RX_CURRENT_ADDR));
+        radio_.read_register_burst(REG_FIFO, op->rx, length);
+        return length;
+    }
+
+    Executor &executor_;
+    Radio &radio_;
+    Operation *current_ = nullptr;
+    Waiter *head_ = nullptr;
+    Waiter *tail_ = nullptr;
+};
+
+} // namespace lora
+
+#endif // LORA_ASYNC_HPP
@@ -0,0 +1,198 @@
+#include "lora_bridge.h"
+#include <string.h>
+
+// Forward declarations of static functions
+static void emit(lora_bridge_t *bridge, size_t length);
+static void execute(lora_bridge_t *bridge, const uint8_t *frame, size_t length);
+static void execute_tx(lora_bridge_t *bridge, const uint8_t *body, size_t length);
+static void put_le16(uint8_t *p, uint16_t value);
+static void put_le32(uint8_t *p, uint32_t value);
+
+void lora_bridge_init(lora_bridge_t *bridge, lora_ctx_t *ctx, print_ctx_t *sink) {
+    memset(bridge, 0, sizeof(lora_bridge_t));
+    bridge->lora = ctx;
+    bridge->sink = sink;
+}
+
+bool lora_bridge_poll(lora_bridge_t *bridge) {
+    lora_ctx_t *ctx = bridge->lora;
+    bool forwarded = false;
+
+    // Parsing re-arms RX, which would cut a bridged TX short
+    if (!lora_is_transmitting(ctx)) {
+        int length = lora_parse_packet(ctx, 0);
+        if (length > 0) {
+            lora_bridge_forward(bridge, length);
+            forwarded = true;
+        }
+    }
+
+    if (bridge->batch_length > 0 && time_us_64() - bridge->batch_start_us >= LORA_BRIDGE_FLUSH_US) {
+        lora_bridge_flush(bridge);
+    }
+    return forwarded;
+}
+
+void lora_bridge_forward(lora_bridge_t *bridge, int length) {
+    lora_ctx_t *ctx = bridge->lora;
+    const lora_link_quality_t *link = lora_packet_link_quality(ctx);
+    uint8_t *m = bridge->message;
+
+    if (length <= 0 || length > MAX_PKT_LENGTH) {
+        return;
+    }
+
+    m[0] = LORA_BRIDGE_MSG_RX;
+    put_le32(&m[1], (uint32_t)lora_packet_timestamp(ctx));
+    put_le16(&m[5], (uint16_t)link->rssi_dbm);
+    m[7] = (uint8_t)link->snr_q;
+    put_le32(&m[8], (uint32_t)link->frequency_error_hz);
+
+    // Straight from the FIFO into the message
+    size_t n = lora_read_bytes(ctx, &m[LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_RX_HEADER], (size_t)length);
+    emit(bridge, LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_RX_HEADER + n);
+    bridge->stats.rx_forwarded++;
+}
+
+void lora_bridge_input(lora_bridge_t *bridge, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t b = data[i];
+
+        if (b == LORA_WIRE_DELIMITER) {
+            if (!bridge->input_discard && bridge->input_length > 0) {
+                int n = lora_wire_decode(bridge->input, bridge->input_length, bridge->input);
+                if (n < 0) {
+                    bridge->stats.bad_frames++;
+                } else {
+                    execute(bridge, bridge->input, (size_t)n);
+                }
+            }
+            bridge->input_length = 0;
+            bridge->input_discard = false;
+        } else if (bridge->input_discard) {
+            continue;
+        } else if (bridge->input_length == sizeof(bridge->input)) {
+            // Drop the rest of this frame and resync on the next delimiter
+            bridge->stats.overruns++;
+            bridge->input_discard = true;
+        } else {
+            bridge->input[bridge->input_length++] = b;
+        }
+    }
+}
+
+bool lora_bridge_send(lora_bridge_t *bridge, uint8_t type, const uint8_t *body, size_t length) {
+    if (length > LORA_BRIDGE_MAX_MESSAGE - LORA_BRIDGE_TYPE_SIZE - LORA_BRIDGE_CRC_SIZE) {
+        return false;
+    }
+
+    bridge->message[0] = type;
+    if (length > 0) {
+        memmove(&bridge->message[LORA_BRIDGE_TYPE_SIZE], body, length);
+    }
+    emit(bridge, LORA_BRIDGE_TYPE_SIZE + length);
+    return true;
+}
+
+void lora_bridge_flush(lora_bridge_t *bridge) {
+    print_ctx_t *sink = bridge->sink;
+
+    if (bridge->batch_length == 0) {
+        return;
+    }
+
+    size_t written = print_write_buffer(sink, bridge->batch, bridge->batch_length);
+    if (written < bridge->batch_length) {
+        bridge->stats.bytes_dropped += bridge->batch_length - written;
+    }
+    if (sink->flush) {
+        sink->flush(sink);
+    }
+
+    bridge->stats.batches_out++;
+    bridge->stats.bytes_out += written;
+    bridge->batch_length = 0;
+}
+
+// Private functions
+
+// Append the CRC to the assembled message and encode it into the batch
+static void emit(lora_bridge_t *bridge, size_t length) {
+    uint8_t *m = bridge->message;
+
+    put_le16(&m[length], lora_wire_crc16(m, length));
+    length += LORA_BRIDGE_CRC_SIZE;
+
+    if (bridge->batch_length + LORA_WIRE_ENCODED_SIZE(length) + 1 > sizeof(bridge->batch)) {
+        lora_bridge_flush(bridge);
+    }
+    if (bridge->batch_length == 0) {
+        bridge->batch_start_us = time_us_64();
+    }
+
+    uint8_t *out = &bridge->batch[bridge->batch_length];
+    size_t n = lora_wire_encode(m, length, out);
+    out[n++] = LORA_WIRE_DELIMITER;
+    bridge->batch_length += n;
+    bridge->stats.messages_out++;
+}
+
+static void execute(lora_bridge_t *bridge, const uint8_t *frame, size_t length) {
+    if (length < LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_CRC_SIZE) {
+        bridge->stats.bad_frames++;
+        return;
+    }
+
+    length -= LORA_BRIDGE_CRC_SIZE;
+    uint16_t crc = (uint16_t)(frame[length] | (frame[length + 1] << 8));
+    if (crc != lora_wire_crc16(frame, length)) {
+        bridge->stats.bad_frames++;
+        return;
+    }
+
+    bridge->stats.commands++;
+    const uint8_t *body = &frame[LORA_BRIDGE_TYPE_SIZE];
+    size_t body_length = length - LORA_BRIDGE_TYPE_SIZE;
+
+    switch (frame[0]) {
+        case LORA_BRIDGE_CMD_TX:
+            execute_tx(bridge, body, body_length);
+            break;
+        case LORA_BRIDGE_CMD_ECHO:
+            lora_bridge_send(bridge, LORA_BRIDGE_MSG_ECHO, body, body_length);
+            break;
+        default:
+            bridge->stats.bad_frames++;
+            break;
+    }
+}
+
+// Queue the payload on the radio and report the outcome against the tag
+static void execute_tx(lora_bridge_t *bridge, const uint8_t *body, size_t length) {
+    lora_ctx_t *ctx = bridge->lora;
+    uint8_t reply[2] = { length > 0 ? body[0] : 0, LORA_BRIDGE_TX_OK };
+
+    if (length < 2 || length - 1 > MAX_PKT_LENGTH) {
+        reply[1] = LORA_BRIDGE_TX_INVALID;
+    } else if (!lora_begin_packet(ctx, false)) {
+        reply[1] = LORA_BRIDGE_TX_BUSY;
+        bridge->stats.tx_busy++;
+    } else {
+        lora_write(ctx, &body[1], length - 1);
+        lora_end_packet(ctx, true);
+        bridge->stats.tx_ok++;
+    }
+    lora_bridge_send(bridge, LORA_BRIDGE_MSG_TX_DONE, reply, sizeof(reply));
+}
+
+static void put_le16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
@@ -0,0 +1,107 @@
+#ifndef LORA_BRIDGE_H
+#define LORA_BRIDGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lora.h"
+#include "lora_wire.h"
+
+// Binary gateway link to a host over USB CDC or UART. Every message is
+// [type][body][crc16 LE], COBS encoded and terminated by a zero byte.
+//
+// The sink must pass bytes through untouched: with pico_stdio turn off
+// CRLF translation (PICO_STDIO_DEFAULT_CRLF=0), and keep driver logging
+// off the same port or the host will discard it as bad frames.
+
+// Device to host
+#define LORA_BRIDGE_MSG_RX          0x01    // Received packet with metadata
+#define LORA_BRIDGE_MSG_TX_DONE     0x02    // Result of a TX command
+#define LORA_BRIDGE_MSG_ECHO        0x03    // Reply to an echo command
+
+// Host to device
+#define LORA_BRIDGE_CMD_TX          0x81    // [tag][payload]
+#define LORA_BRIDGE_CMD_ECHO        0x83    // [payload], returned unchanged
+
+// TX_DONE status: [tag][status]
+#define LORA_BRIDGE_TX_OK           0       // Queued on the radio
+#define LORA_BRIDGE_TX_BUSY         1       // Radio still transmitting
+#define LORA_BRIDGE_TX_INVALID      2       // Empty or oversized payload
+
+// RX body: timestamp_us (LE32), rssi_dbm (LE16), snr_q, frequency_error_hz
+// (LE32), then the payload
+#define LORA_BRIDGE_RX_HEADER       11
+
+#define LORA_BRIDGE_TYPE_SIZE       1
+#define LORA_BRIDGE_CRC_SIZE        2
+#define LORA_BRIDGE_MAX_MESSAGE     (LORA_BRIDGE_TYPE_SIZE + LORA_BRIDGE_RX_HEADER + MAX_PKT_LENGTH + \
+                                     LORA_BRIDGE_CRC_SIZE)
+#define LORA_BRIDGE_MAX_ENCODED     (LORA_WIRE_ENCODED_SIZE(LORA_BRIDGE_MAX_MESSAGE) + 1)
+
+// Output is collected here and handed to the sink in one write
+#ifndef LORA_BRIDGE_BATCH_SIZE
+#define LORA_BRIDGE_BATCH_SIZE      1024
+#endif
+#if LORA_BRIDGE_BATCH_SIZE < LORA_BRIDGE_MAX_ENCODED
+#error "LORA_BRIDGE_BATCH_SIZE must hold the largest encoded message"
+#endif
+
+// Longest a message waits in the batch before it is written
+#ifndef LORA_BRIDGE_FLUSH_US
+#define LORA_BRIDGE_FLUSH_US        2000
+#endif
+
+typedef struct {
+    uint32_t rx_forwarded;
+    uint32_t messages_out;
+    uint32_t batches_out;
+    uint64_t bytes_out;
+    uint32_t bytes_dropped;     // Short writes by the sink
+    uint32_t commands;
+    uint32_t tx_ok;
+    uint32_t tx_busy;
+    uint32_t bad_frames;        // COBS, CRC or length errors
+    uint32_t overruns;          // Input frames longer than the buffer
+} lora_bridge_stats_t;
+
+typedef struct {
+    lora_ctx_t *lora;
+    print_ctx_t *sink;
+
+    // Output batch of encoded, delimited messages
+    uint8_t batch[LORA_BRIDGE_BATCH_SIZE];
+    size_t batch_length;
+    uint64_t batch_start_us;
+
+    // Input frame being collected up to its delimiter
+    uint8_t input[LORA_BRIDGE_MAX_ENCODED];
+    size_t input_length;
+    bool input_discard;
+
+    // Message assembled before encoding; received payloads are read into it
+    uint8_t message[LORA_BRIDGE_MAX_MESSAGE];
+    lora_bridge_stats_t stats;
+} lora_bridge_t;
+
+// Bridge ctx to the host through sink
+void lora_bridge_init(lora_bridge_t *bridge, lora_ctx_t *ctx, print_ctx_t *sink);
+
+// Forward received packets and write out a batch that has waited
+// LORA_BRIDGE_FLUSH_US; call often. Returns true if a packet was forwarded.
+bool lora_bridge_poll(lora_bridge_t *bridge);
+
+// Queue the packet just accepted by lora_parse_packet, for callers that
+// parse packets themselves
+void lora_bridge_forward(lora_bridge_t *bridge, int length);
+
+// Feed bytes read from the host link, e.g. getchar_timeout_us(0) or
+// tud_cdc_read(); complete commands are executed as they arrive
+void lora_bridge_input(lora_bridge_t *bridge, const uint8_t *data, size_t length);
+
+// Queue one message; the body excludes the type and CRC
+bool lora_bridge_send(lora_bridge_t *bridge, uint8_t type, const uint8_t *body, size_t length);
+
+// Write out the batch now
+void lora_bridge_flush(lora_bridge_t *bridge);
+
+#endif // LORA_BRIDGE_H
@@ -0,0 +1,317 @@
+#include "lora_crypto.h"
+#include <string.h>
+
+// CCM length field: two bytes covers any LoRa payload
+#define CCM_L                   2
+#define CCM_NONCE_SIZE          (15 - CCM_L)
+
+// Forward declarations of static functions
+static void ccm(lora_crypto_t *crypto, uint8_t *frame, size_t aad_length, size_t payload_length,
+                bool encrypt, uint8_t tag[16]);
+static void ctr_block(const lora_crypto_t *crypto, const uint8_t *nonce, uint16_t counter, uint8_t out[16]);
+static void sub_shift(uint8_t s[16]);
+static void mix_columns(uint8_t s[16]);
+static void add_round_key(uint8_t s[16], const uint8_t *k);
+static uint8_t xtime(uint8_t x);
+static bool seal_fits(const lora_crypto_t *crypto, size_t length, size_t capacity);
+static int receive_rest(lora_crypto_t *crypto, lora_ctx_t *ctx, uint8_t *frame, size_t aad_length,
+                        size_t offset, size_t capacity);
+
+// S-box in RAM, not flash: SRAM loads take a fixed time on the M0+, which
+// has no data cache, while flash reads go through the XIP cache
+static uint8_t sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+void lora_crypto_init(lora_crypto_t *crypto, const uint8_t key[LORA_CRYPTO_KEY_SIZE],
+                      const uint8_t salt[LORA_CRYPTO_SALT_SIZE], uint8_t address, uint32_t tx_counter) {
+    memset(crypto, 0, sizeof(lora_crypto_t));
+    lora_aes_expand_key(&crypto->aes, key);
+    memcpy(crypto->salt, salt, LORA_CRYPTO_SALT_SIZE);
+    crypto->address = address;
+    crypto->tx_counter = tx_counter;
+}
+
+void lora_crypto_end(lora_crypto_t *crypto) {
+    volatile uint8_t *p = (volatile uint8_t *)crypto;
+
+    for (size_t i = 0; i < sizeof(lora_crypto_t); i++) {
+        p[i] = 0;
+    }
+}
+
+size_t lora_crypto_seal(lora_crypto_t *crypto, uint8_t *frame, size_t aad_length,
+                        size_t payload_length, size_t capacity) {
+    size_t length = aad_length + LORA_CRYPTO_OVERHEAD + payload_length;
+    uint8_t tag[16];
+
+    if (!seal_fits(crypto, length, capacity)) {
+        return 0;
+    }
+
+    uint8_t *header = frame + aad_length;
+    uint32_t counter = crypto->tx_counter++;
+    header[0] = crypto->address;
+    header[1] = (uint8_t)(counter >> 24);
+    header[2] = (uint8_t)(counter >> 16);
+    header[3] = (uint8_t)(counter >> 8);
+    header[4] = (uint8_t)counter;
+
+    ccm(crypto, frame, aad_length, payload_length, true, tag);
+    memcpy(header + LORA_CRYPTO_HEADER_SIZE + payload_length, tag, LORA_CRYPTO_TAG_SIZE);
+    return length;
+}
+
+int lora_crypto_open(lora_crypto_t *crypto, uint8_t *frame, size_t aad_length, size_t frame_length) {
+    uint8_t tag[16];
+
+    if (frame_length < aad_length + LORA_CRYPTO_OVERHEAD) {
+        crypto->auth_failures++;
+        return LORA_CRYPTO_AUTH_FAILED;
+    }
+
+    size_t payload_length = frame_length - aad_length - LORA_CRYPTO_OVERHEAD;
+    uint8_t *payload = frame + aad_length + LORA_CRYPTO_HEADER_SIZE;
+    const uint8_t *received = payload + payload_length;
+
+    ccm(crypto, frame, aad_length, payload_length, false, tag);
+
+    // Constant-time compare
+    uint8_t diff = 0;
+    for (int i = 0; i < LORA_CRYPTO_TAG_SIZE; i++) {
+        diff |= tag[i] ^ received[i];
+    }
+    if (diff != 0) {
+        memset(payload, 0, payload_length);
+        crypto->auth_failures++;
+        return LORA_CRYPTO_AUTH_FAILED;
+    }
+
+    // Only an authenticated counter may move the sender's window
+    const uint8_t *header = frame + aad_length;
+    uint32_t counter = ((uint32_t)header[1] << 24) | ((uint32_t)header[2] << 16) |
+                       ((uint32_t)header[3] << 8) | header[4];
+    if (counter < crypto->rx_counter[header[0]]) {
+        memset(payload, 0, payload_length);
+        crypto->replays++;
+        return LORA_CRYPTO_REPLAYED;
+    }
+    crypto->rx_counter[header[0]] = counter + 1;     // Seal never uses UINT32_MAX
+    return (int)payload_length;
+}
+
+bool lora_crypto_send(lora_crypto_t *crypto, lora_ctx_t *ctx, uint8_t *frame, size_t aad_length,
+                      size_t payload_length, size_t capacity, bool async) {
+    size_t length = aad_length + LORA_CRYPTO_OVERHEAD + payload_length;
+
+    // Seal only once the radio is free, so a busy radio leaves the
+    // plaintext and the counter untouched for a retry
+    if (!seal_fits(crypto, length, capacity) || !lora_begin_packet(ctx, false)) {
+        return false;
+    }
+    lora_crypto_seal(crypto, frame, aad_length, payload_length, capacity);
+    lora_write(ctx, frame, length);
+    return lora_end_packet(ctx, async);
+}
+
+int lora_crypto_receive(lora_crypto_t *crypto, lora_ctx_t *ctx, uint8_t *frame, size_t aad_length, size_t capacity) {
+    return receive_rest(crypto, ctx, frame, aad_length, 0, capacity);
+}
+
+int lora_crypto_receive_filtered(lora_crypto_t *crypto, lora_ctx_t *ctx, const lora_filter_t *filter,
+                                 uint8_t *frame, size_t capacity) {
+    if (capacity < LORA_FILTER_HEADER_LENGTH) {
+        crypto->auth_failures++;
+        return LORA_CRYPTO_AUTH_FAILED;
+    }
+    frame[0] = filter->dest;
+    frame[1] = filter->src;
+    frame[2] = filter->seq;
+    return receive_rest(crypto, ctx, frame, LORA_FILTER_HEADER_LENGTH, LORA_FILTER_HEADER_LENGTH, capacity);
+}
+
+// AES-128 (FIPS 197)
+void lora_aes_expand_key(lora_aes_t *aes, const uint8_t key[LORA_CRYPTO_KEY_SIZE]) {
+    uint8_t *w = aes->round_keys;
+    uint8_t rcon = 0x01;
+
+    memcpy(w, key, 16);
+    for (int i = 16; i < 176; i += 4) {
+        uint8_t t[4] = { w[i - 4], w[i - 3], w[i - 2], w[i - 1] };
+
+        if (i % 16 == 0) {
+            // RotWord, SubWord, Rcon
+            uint8_t first = t[0];
+            t[0] = sbox[t[1]] ^ rcon;
+            t[1] = sbox[t[2]];
+            t[2] = sbox[t[3]];
+            t[3] = sbox[first];
+            rcon = xtime(rcon);
+        }
+        for (int j = 0; j < 4; j++) {
+            w[i + j] = w[i - 16 + j] ^ t[j];
+        }
+    }
+}
+
+void lora_aes_encrypt(const lora_aes_t *aes, const uint8_t in[16], uint8_t out[16]) {
+    uint8_t s[16];
+
+    memcpy(s, in, 16);
+    add_round_key(s, aes->round_keys);
+    for (int round = 1; round < 10; round++) {
+        sub_shift(s);
+        mix_columns(s);
+        add_round_key(s, aes->round_keys + 16 * round);
+    }
+    sub_shift(s);
+    add_round_key(s, aes->round_keys + 160);
+    memcpy(out, s, 16);
+}
+
+// Private functions
+
+// One pass over the payload: each block is MACed and en/decrypted in place,
+// so the data is touched once. tag receives the encrypted CBC-MAC.
+static void ccm(lora_crypto_t *crypto, uint8_t *frame, size_t aad_length, size_t payload_length,
+                bool encrypt, uint8_t tag[16]) {
+    uint8_t nonce[CCM_NONCE_SIZE];
+    uint8_t mac[16];
+    uint8_t stream[16];
+    uint8_t *payload = frame + aad_length + LORA_CRYPTO_HEADER_SIZE;
+
+    memcpy(nonce, crypto->salt, LORA_CRYPTO_SALT_SIZE);
+    memcpy(nonce + LORA_CRYPTO_SALT_SIZE, frame + aad_length, LORA_CRYPTO_HEADER_SIZE);
+
+    // B0: flags, nonce, payload length
+    mac[0] = (aad_length > 0 ? 0x40 : 0x00) | (((LORA_CRYPTO_TAG_SIZE - 2) / 2) << 3) | (CCM_L - 1);
+    memcpy(mac + 1, nonce, CCM_NONCE_SIZE);
+    mac[14] = (uint8_t)(payload_length >> 8);
+    mac[15] = (uint8_t)payload_length;
+    lora_aes_encrypt(&crypto->aes, mac, mac);
+
+    // Associated data, prefixed by its 16-bit length
+    if (aad_length > 0) {
+        size_t i = 0;
+        size_t pos = 2;
+
+        mac[0] ^= (uint8_t)(aad_length >> 8);
+        mac[1] ^= (uint8_t)aad_length;
+        while (i < aad_length) {
+            mac[pos++] ^= frame[i++];
+            if (pos == 16) {
+                lora_aes_encrypt(&crypto->aes, mac, mac);
+                pos = 0;
+            }
+        }
+        if (pos > 0) {
+            lora_aes_encrypt(&crypto->aes, mac, mac);
+        }
+    }
+
+    for (size_t offset = 0; offset < payload_length; offset += 16) {
+        size_t n = payload_length - offset < 16 ? payload_length - offset : 16;
+        uint8_t *block = payload + offset;
+
+        ctr_block(crypto, nonce, (uint16_t)(offset / 16 + 1), stream);
+        for (size_t i = 0; i < n; i++) {
+            if (encrypt) {
+                mac[i] ^= block[i];
+                block[i] ^= stream[i];
+            } else {
+                block[i] ^= stream[i];
+                mac[i] ^= block[i];
+            }
+        }
+        lora_aes_encrypt(&crypto->aes, mac, mac);
+    }
+
+    // Tag is the MAC encrypted with counter block 0
+    ctr_block(crypto, nonce, 0, stream);
+    for (int i = 0; i < 16; i++) {
+        tag[i] = mac[i] ^ stream[i];
+    }
+}
+
+static void ctr_block(const lora_crypto_t *crypto, const uint8_t *nonce, uint16_t counter, uint8_t out[16]) {
+    uint8_t a[16];
+
+    a[0] = CCM_L - 1;
+    memcpy(a + 1, nonce, CCM_NONCE_SIZE);
+    a[14] = (uint8_t)(counter >> 8);
+    a[15] = (uint8_t)counter;
+    lora_aes_encrypt(&crypto->aes, a, out);
+}
+
+// SubBytes and ShiftRows in one pass; state is column-major
+static void sub_shift(uint8_t s[16]) {
+    uint8_t t;
+
+    // Row 0
+    s[0] = sbox[s[0]]; s[4] = sbox[s[4]]; s[8] = sbox[s[8]]; s[12] = sbox[s[12]];
+    // Row 1: rotate left by one
+    t = s[1];
+    s[1] = sbox[s[5]]; s[5] = sbox[s[9]]; s[9] = sbox[s[13]]; s[13] = sbox[t];
+    // Row 2: rotate by two
+    t = s[2]; s[2] = sbox[s[10]]; s[10] = sbox[t];
+    t = s[6]; s[6] = sbox[s[14]]; s[14] = sbox[t];
+    // Row 3: rotate left by three
+    t = s[15];
+    s[15] = sbox[s[11]]; s[11] = sbox[s[7]]; s[7] = sbox[s[3]]; s[3] = sbox[t];
+}
+
+static void mix_columns(uint8_t s[16]) {
+    for (int c = 0; c < 16; c += 4) {
+        uint8_t a0 = s[c], a1 = s[c + 1], a2 = s[c + 2], a3 = s[c + 3];
+        uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+
+        s[c] ^= all ^ xtime(a0 ^ a1);
+        s[c + 1] ^= all ^ xtime(a1 ^ a2);
+        s[c + 2] ^= all ^ xtime(a2 ^ a3);
+        s[c + 3] ^= all ^ xtime(a3 ^ a0);
+    }
+}
+
+static void add_round_key(uint8_t s[16], const uint8_t *k) {
+    for (int i = 0; i < 16; i++) {
+        s[i] ^= k[i];
+    }
+}
+
+static bool seal_fits(const lora_crypto_t *crypto, size_t length, size_t capacity) {
+    return length <= capacity && length <= MAX_PKT_LENGTH && crypto->tx_counter != UINT32_MAX;
+}
+
+// Read what is left of the packet in the FIFO after the first offset
+// bytes of frame, then open the whole frame
+static int receive_rest(lora_crypto_t *crypto, lora_ctx_t *ctx, uint8_t *frame, size_t aad_length,
+                        size_t offset, size_t capacity) {
+    int length = lora_available(ctx);
+
+    if (length <= 0 || offset + (size_t)length > capacity) {
+        crypto->auth_failures++;
+        return LORA_CRYPTO_AUTH_FAILED;
+    }
+    lora_read_bytes(ctx, frame + offset, length);
+    return lora_crypto_open(crypto, frame, aad_length, offset + (size_t)length);
+}
+
+// Multiply by x in GF(2^8) without a data-dependent branch
+static uint8_t xtime(uint8_t x) {
+    return (uint8_t)((x << 1) ^ (0x1b & -(x >> 7)));
+}
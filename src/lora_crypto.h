@@ -0,0 +1,88 @@
+#ifndef LORA_CRYPTO_H
+#define LORA_CRYPTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lora.h"
+#include "lora_filter.h"
+
+// AES-128-CCM (RFC 3610) with a 13-byte nonce: session salt, sender address
+// and a 32-bit frame counter. Only the address and counter go on air.
+#define LORA_CRYPTO_KEY_SIZE    16
+#define LORA_CRYPTO_SALT_SIZE   8
+#define LORA_CRYPTO_HEADER_SIZE 5       // Sender address + frame counter
+
+// Authentication tag length: 4, 6, 8, 10, 12, 14 or 16
+#ifndef LORA_CRYPTO_TAG_SIZE
+#define LORA_CRYPTO_TAG_SIZE    8
+#endif
+
+#define LORA_CRYPTO_OVERHEAD    (LORA_CRYPTO_HEADER_SIZE + LORA_CRYPTO_TAG_SIZE)
+
+// Returned by lora_crypto_open/receive when a frame fails authentication,
+// or authenticates but repeats a counter already accepted from its sender
+#define LORA_CRYPTO_AUTH_FAILED (-1)
+#define LORA_CRYPTO_REPLAYED    (-2)
+
+// Expanded AES-128 round keys
+typedef struct {
+    uint8_t round_keys[176];
+} lora_aes_t;
+
+// Session: keys are expanded once in lora_crypto_init
+typedef struct {
+    lora_aes_t aes;
+    uint8_t salt[LORA_CRYPTO_SALT_SIZE];
+    uint8_t address;            // Our sender address, part of every nonce
+    uint32_t tx_counter;        // Next frame counter; persist it across reboots
+    uint32_t rx_counter[256];   // Per sender: lowest counter still accepted
+    uint32_t auth_failures;
+    uint32_t replays;
+} lora_crypto_t;
+
+// The salt is shared by both peers and fixed per key, so the counter alone
+// keeps nonces unique: a sender that restarts with the same key must resume
+// from tx_counter, not 0, or it reuses CCM nonces (and keystream) and its
+// peers reject it as replayed. Store a value ahead of crypto->tx_counter in
+// flash, e.g. rounded up to a block of a few thousand frames and rewritten
+// when the counter reaches it, and pass it back here after a reboot.
+void lora_crypto_init(lora_crypto_t *crypto, const uint8_t key[LORA_CRYPTO_KEY_SIZE],
+                      const uint8_t salt[LORA_CRYPTO_SALT_SIZE], uint8_t address, uint32_t tx_counter);
+
+// Wipe the key material
+void lora_crypto_end(lora_crypto_t *crypto);
+
+// Frame layout: [aad][address][counter][payload][tag]. The first aad_length
+// bytes are authenticated but sent in clear (e.g. the lora_filter header).
+//
+// Seal in place: the payload must already sit at frame + aad_length +
+// LORA_CRYPTO_HEADER_SIZE. Returns the frame length, or 0 if it does not
+// fit in capacity or the counter is exhausted.
+size_t lora_crypto_seal(lora_crypto_t *crypto, uint8_t *frame, size_t aad_length,
+                        size_t payload_length, size_t capacity);
+
+// Open in place: returns the payload length, or LORA_CRYPTO_AUTH_FAILED /
+// LORA_CRYPTO_REPLAYED with the payload wiped. Nothing unauthenticated is
+// left in the frame. A sender's counter must increase from frame to frame.
+int lora_crypto_open(lora_crypto_t *crypto, uint8_t *frame, size_t aad_length, size_t frame_length);
+
+// TX/RX path: seal and send in one lora_write, or read the received packet
+// (after lora_parse_packet) and open it. Send seals only once the radio has
+// taken the packet; when it returns false because the radio is busy, the
+// frame still holds the plaintext and can be sent again.
+bool lora_crypto_send(lora_crypto_t *crypto, lora_ctx_t *ctx, uint8_t *frame, size_t aad_length,
+                      size_t payload_length, size_t capacity, bool async);
+int lora_crypto_receive(lora_crypto_t *crypto, lora_ctx_t *ctx, uint8_t *frame, size_t aad_length, size_t capacity);
+
+// RX path after lora_parse_packet_filtered, which has already taken the
+// filter header off the FIFO: the header is rebuilt from filter->dest/src/seq
+// as the associated data. frame receives header, crypto header and payload.
+int lora_crypto_receive_filtered(lora_crypto_t *crypto, lora_ctx_t *ctx, const lora_filter_t *filter,
+                                 uint8_t *frame, size_t capacity);
+
+// AES-128 block cipher (encryption only; CCM never needs the inverse)
+void lora_aes_expand_key(lora_aes_t *aes, const uint8_t key[LORA_CRYPTO_KEY_SIZE]);
+void lora_aes_encrypt(const lora_aes_t *aes, const uint8_t in[16], uint8_t out[16]);
+
+#endif // LORA_CRYPTO_H
@@ -0,0 +1,61 @@
+#include "lora_dedup.h"
+#include "pico/stdlib.h"
+#include <string.h>
+
+// Private function declarations
+static uint32_t bucket_of(uint32_t key);
+static uint32_t now_ms(void);
+
+void lora_dedup_init(lora_dedup_t *dedup) {
+    memset(dedup, 0, sizeof(lora_dedup_t));
+    dedup->max_age_ms = LORA_DEDUP_MAX_AGE_MS;
+}
+
+bool lora_dedup_contains(lora_dedup_t *dedup, uint32_t key) {
+    uint32_t bucket = bucket_of(key);
+    uint32_t now = now_ms();
+
+    for (int way = 0; way < LORA_DEDUP_WAYS; way++) {
+        if (!(dedup->valid[bucket] & (1 << way))) {
+            continue;
+        }
+        // Wrap-safe while the age stays below 49 days
+        if (now - dedup->seen_ms[bucket][way] >= dedup->max_age_ms) {
+            dedup->valid[bucket] &= ~(1 << way);
+        } else if (dedup->keys[bucket][way] == key) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void lora_dedup_insert(lora_dedup_t *dedup, uint32_t key) {
+    uint32_t bucket = bucket_of(key);
+    uint8_t way = dedup->next[bucket];
+
+    dedup->keys[bucket][way] = key;
+    dedup->seen_ms[bucket][way] = now_ms();
+    dedup->valid[bucket] |= 1 << way;
+    dedup->next[bucket] = (way + 1) % LORA_DEDUP_WAYS;
+}
+
+bool lora_dedup_check(lora_dedup_t *dedup, uint32_t key) {
+    if (lora_dedup_contains(dedup, key)) {
+        return true;
+    }
+
+    lora_dedup_insert(dedup, key);
+    return false;
+}
+
+// Private functions
+static uint32_t bucket_of(uint32_t key) {
+    // Fibonacci hashing spreads sequential keys across buckets
+    uint32_t hash = key * 2654435761u;
+    return (hash ^ (hash >> 16)) & (LORA_DEDUP_BUCKETS - 1);
+}
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(time_us_64() / 1000);
+}
@@ -0,0 +1,40 @@
+#ifndef LORA_DEDUP_H
+#define LORA_DEDUP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Set-associative cache of recently seen keys; buckets must be a power of two
+#ifndef LORA_DEDUP_BUCKETS
+#define LORA_DEDUP_BUCKETS 16
+#endif
+#ifndef LORA_DEDUP_WAYS
+#define LORA_DEDUP_WAYS    4
+#endif
+
+// Keys older than this no longer count as seen, so a node that rebooted
+// and restarted its sequence numbers is heard again
+#ifndef LORA_DEDUP_MAX_AGE_MS
+#define LORA_DEDUP_MAX_AGE_MS 60000
+#endif
+
+// Fixed-size duplicate cache. The oldest key in a bucket is replaced
+// when the bucket is full, so memory and lookup cost are constant.
+typedef struct {
+    uint32_t keys[LORA_DEDUP_BUCKETS][LORA_DEDUP_WAYS];
+    uint32_t seen_ms[LORA_DEDUP_BUCKETS][LORA_DEDUP_WAYS];
+    uint8_t valid[LORA_DEDUP_BUCKETS];     // Bitmask of used ways
+    uint8_t next[LORA_DEDUP_BUCKETS];      // Way replaced next
+    uint32_t max_age_ms;                   // LORA_DEDUP_MAX_AGE_MS after init
+} lora_dedup_t;
+
+void lora_dedup_init(lora_dedup_t *dedup);
+
+// Expired keys are dropped as they are looked up
+bool lora_dedup_contains(lora_dedup_t *dedup, uint32_t key);
+void lora_dedup_insert(lora_dedup_t *dedup, uint32_t key);
+
+// Returns true if key was already present; inserts it otherwise
+bool lora_dedup_check(lora_dedup_t *dedup, uint32_t key);
+
+#endif // LORA_DEDUP_H
@@ -0,0 +1,292 @@
+#include "lora_entropy.h"
+#include <string.h>
+
+// Forward declarations of static functions
+static void sample(lora_entropy_t *pool);
+static void add_bit(lora_entropy_t *pool, uint8_t bit);
+static void reseed(lora_entropy_t *pool);
+static void refill(lora_entropy_t *pool);
+static void sha256_block(lora_sha256_t *sha, const uint8_t *block);
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+void lora_entropy_init(lora_entropy_t *pool, lora_ctx_t *ctx) {
+    memset(pool, 0, sizeof(lora_entropy_t));
+    pool->lora = ctx;
+    pool->output_index = LORA_ENTROPY_OUTPUT_SIZE;
+    pool->pair_bit = -1;
+}
+
+bool lora_entropy_seed(lora_entropy_t *pool) {
+    lora_ctx_t *ctx = pool->lora;
+    uint8_t op_mode = lora_read_register(ctx, REG_OP_MODE);
+    bool receiving = (op_mode & 0x07) == MODE_RX_CONTINUOUS || (op_mode & 0x07) == MODE_RX_SINGLE;
+    uint32_t reseeds = pool->reseeds;
+
+    // Wideband RSSI is only updated while the receiver runs
+    if (!receiving) {
+        lora_write_register(ctx, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_CONTINUOUS);
+    }
+
+    for (uint32_t i = 0; i < LORA_ENTROPY_SEED_MAX_SAMPLES && pool->reseeds == reseeds; i++) {
+        sample(pool);
+    }
+
+    if (!receiving) {
+        // Nothing was listening, so packets caught meanwhile are noise too
+        lora_write_register(ctx, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_STDBY);
+        lora_write_register(ctx, REG_IRQ_FLAGS, IRQ_RX_DONE_MASK | IRQ_PAYLOAD_CRC_ERROR_MASK | IRQ_VALID_HEADER_MASK);
+        lora_write_register(ctx, REG_OP_MODE, op_mode);
+    }
+
+    if (pool->reseeds == reseeds) {
+        LORA_LOG_ERROR(ctx, "Entropy seeding failed");
+        return false;
+    }
+    return true;
+}
+
+bool lora_entropy_poll(lora_entropy_t *pool) {
+    uint8_t mode = lora_read_register(pool->lora, REG_OP_MODE) & 0x07;
+    uint32_t reseeds = pool->reseeds;
+
+    if (mode != MODE_RX_CONTINUOUS && mode != MODE_RX_SINGLE) {
+        return false;
+    }
+
+    for (int i = 0; i < LORA_ENTROPY_SAMPLES_PER_POLL; i++) {
+        sample(pool);
+    }
+    return pool->reseeds != reseeds;
+}
+
+bool lora_entropy_read(lora_entropy_t *pool, uint8_t *buffer, size_t size) {
+    if (!pool->seeded) {
+        return false;
+    }
+
+    while (size > 0) {
+        if (pool->output_index == LORA_ENTROPY_OUTPUT_SIZE) {
+            refill(pool);
+        }
+
+        size_t n = LORA_ENTROPY_OUTPUT_SIZE - pool->output_index;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(buffer, &pool->output[pool->output_index], n);
+
+        // Served bytes are not left behind in the pool
+        memset(&pool->output[pool->output_index], 0, n);
+        pool->output_index += n;
+        buffer += n;
+        size -= n;
+    }
+    return true;
+}
+
+// 0 until seeded
+uint32_t lora_entropy_u32(lora_entropy_t *pool) {
+    uint8_t bytes[4];
+
+    if (!lora_entropy_read(pool, bytes, sizeof(bytes))) {
+        return 0;
+    }
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+// SHA-256 (FIPS 180-4)
+void lora_sha256_init(lora_sha256_t *sha) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(sha->state, initial, sizeof(initial));
+    sha->length = 0;
+    sha->block_length = 0;
+}
+
+void lora_sha256_update(lora_sha256_t *sha, const uint8_t *data, size_t size) {
+    sha->length += size;
+
+    while (size > 0) {
+        if (sha->block_length == 0 && size >= 64) {
+            // Whole blocks straight from the input
+            sha256_block(sha, data);
+            data += 64;
+            size -= 64;
+            continue;
+        }
+
+        size_t n = 64 - sha->block_length;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(&sha->block[sha->block_length], data, n);
+        sha->block_length += n;
+        data += n;
+        size -= n;
+
+        if (sha->block_length == 64) {
+            sha256_block(sha, sha->block);
+            sha->block_length = 0;
+        }
+    }
+}
+
+void lora_sha256_final(lora_sha256_t *sha, uint8_t digest[32]) {
+    uint64_t bits = sha->length * 8;
+
+    sha->block[sha->block_length++] = 0x80;
+    if (sha->block_length > 56) {
+        memset(&sha->block[sha->block_length], 0, 64 - sha->block_length);
+        sha256_block(sha, sha->block);
+        sha->block_length = 0;
+    }
+    memset(&sha->block[sha->block_length], 0, 56 - sha->block_length);
+    for (int i = 0; i < 8; i++) {
+        sha->block[63 - i] = (uint8_t)(bits >> (8 * i));
+    }
+    sha256_block(sha, sha->block);
+
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = (uint8_t)(sha->state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(sha->state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(sha->state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)sha->state[i];
+    }
+    memset(sha, 0, sizeof(lora_sha256_t));
+}
+
+// Private functions
+
+// One RegRssiWideband read; the LSB carries the noise (Semtech AN1200.24)
+static void sample(lora_entropy_t *pool) {
+    uint8_t bit = lora_read_register(pool->lora, REG_RSSI_WIDEBAND) & 0x01;
+
+    pool->samples++;
+
+    // Repetition count test: a stuck receiver must not feed the pool
+    if (pool->samples > 1 && bit == pool->last_raw) {
+        if (++pool->repeat_count >= LORA_ENTROPY_REPEAT_LIMIT) {
+            pool->health_failures++;
+            pool->repeat_count = 0;
+            pool->block_bits = 0;
+            pool->pair_bit = -1;
+        }
+    } else {
+        pool->repeat_count = 1;
+    }
+    pool->last_raw = bit;
+
+    // Von Neumann: 01 -> 0, 10 -> 1, equal pairs are dropped
+    if (pool->pair_bit < 0) {
+        pool->pair_bit = bit;
+        return;
+    }
+    if (pool->pair_bit != bit) {
+        add_bit(pool, pool->pair_bit);
+    }
+    pool->pair_bit = -1;
+}
+
+static void add_bit(lora_entropy_t *pool, uint8_t bit) {
+    uint8_t *byte = &pool->block[pool->block_bits / 8];
+
+    *byte = (uint8_t)((*byte << 1) | bit);
+    pool->debiased_bits++;
+
+    if (++pool->block_bits == LORA_ENTROPY_BLOCK_BITS) {
+        reseed(pool);
+        pool->block_bits = 0;
+    }
+}
+
+// key = SHA-256(key || block): the old key carries earlier entropy forward
+static void reseed(lora_entropy_t *pool) {
+    lora_sha256_t sha;
+
+    lora_sha256_init(&sha);
+    lora_sha256_update(&sha, pool->key, sizeof(pool->key));
+    lora_sha256_update(&sha, pool->block, sizeof(pool->block));
+    lora_sha256_final(&sha, pool->key);
+    memset(pool->block, 0, sizeof(pool->block));
+
+    // Buffered output predates the new key
+    memset(pool->output, 0, sizeof(pool->output));
+    pool->output_index = LORA_ENTROPY_OUTPUT_SIZE;
+    pool->reseeds++;
+    pool->seeded = true;
+}
+
+// Counter-mode SHA-256 output, then ratchet the key so earlier output
+// cannot be recomputed from the pool state
+static void refill(lora_entropy_t *pool) {
+    lora_sha256_t sha;
+    uint8_t digest[32];
+
+    for (size_t offset = 0; offset < LORA_ENTROPY_OUTPUT_SIZE; offset += sizeof(digest)) {
+        uint8_t counter[4] = {
+            (uint8_t)(pool->counter >> 24), (uint8_t)(pool->counter >> 16),
+            (uint8_t)(pool->counter >> 8), (uint8_t)pool->counter
+        };
+        pool->counter++;
+
+        lora_sha256_init(&sha);
+        lora_sha256_update(&sha, pool->key, sizeof(pool->key));
+        lora_sha256_update(&sha, counter, sizeof(counter));
+        lora_sha256_final(&sha, digest);
+
+        size_t n = LORA_ENTROPY_OUTPUT_SIZE - offset;
+        memcpy(&pool->output[offset], digest, n < sizeof(digest) ? n : sizeof(digest));
+    }
+
+    static const uint8_t ratchet = 0xff;
+    lora_sha256_init(&sha);
+    lora_sha256_update(&sha, pool->key, sizeof(pool->key));
+    lora_sha256_update(&sha, &ratchet, 1);
+    lora_sha256_final(&sha, pool->key);
+    memset(digest, 0, sizeof(digest));
+
+    pool->output_index = 0;
+}
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(lora_sha256_t *sha, const uint8_t *block) {
+    uint32_t w[64];
+    uint32_t s[8];
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) |
+               ((uint32_t)block[4 * i + 2] << 8) | block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    memcpy(s, sha->state, sizeof(s));
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = s[7] + (ROTR(s[4], 6) ^ ROTR(s[4], 11) ^ ROTR(s[4], 25)) +
+                      ((s[4] & s[5]) ^ (~s[4] & s[6])) + sha256_k[i] + w[i];
+        uint32_t t2 = (ROTR(s[0], 2) ^ ROTR(s[0], 13) ^ ROTR(s[0], 22)) +
+                      ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+        memmove(&s[1], &s[0], 7 * sizeof(uint32_t));
+        s[4] += t1;
+        s[0] = t1 + t2;
+    }
+    for (int i = 0; i < 8; i++) {
+        sha->state[i] += s[i];
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef LORA_ENTROPY_H
+#define LORA_ENTROPY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lora.h"
+
+// Debiased bits conditioned into each reseed (2:1 over the 256-bit key)
+#define LORA_ENTROPY_BLOCK_BITS     512
+
+// Conditioned output kept ready, so reads never wait on the radio
+#ifndef LORA_ENTROPY_OUTPUT_SIZE
+#define LORA_ENTROPY_OUTPUT_SIZE    64
+#endif
+
+// Wideband RSSI samples taken per lora_entropy_poll call
+#ifndef LORA_ENTROPY_SAMPLES_PER_POLL
+#define LORA_ENTROPY_SAMPLES_PER_POLL 32
+#endif
+
+// Give up seeding after this many samples (radio not producing noise)
+#ifndef LORA_ENTROPY_SEED_MAX_SAMPLES
+#define LORA_ENTROPY_SEED_MAX_SAMPLES 65536
+#endif
+
+// Repetition count health test: this many identical raw bits in a row
+// discards the block being collected
+#ifndef LORA_ENTROPY_REPEAT_LIMIT
+#define LORA_ENTROPY_REPEAT_LIMIT   48
+#endif
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;            // Bytes absorbed
+    uint8_t block[64];
+    uint8_t block_length;
+} lora_sha256_t;
+
+// Entropy pool fed from RegRssiWideband noise
+typedef struct {
+    lora_ctx_t *lora;
+
+    // Output generator: key ratchets after every refill
+    uint8_t key[32];
+    uint32_t counter;
+    uint8_t output[LORA_ENTROPY_OUTPUT_SIZE];
+    uint8_t output_index;       // Next unread byte; SIZE when empty
+    bool seeded;
+
+    // Collection: von Neumann debiased bits awaiting conditioning
+    uint8_t block[LORA_ENTROPY_BLOCK_BITS / 8];
+    uint16_t block_bits;
+    int8_t pair_bit;            // First bit of the current pair, -1 if none
+    uint8_t last_raw;
+    uint8_t repeat_count;
+
+    // Statistics
+    uint32_t samples;
+    uint32_t debiased_bits;
+    uint32_t reseeds;
+    uint32_t health_failures;
+} lora_entropy_t;
+
+void lora_entropy_init(lora_entropy_t *pool, lora_ctx_t *ctx);
+
+// Blocking first seed: samples in RX continuous mode until one full block
+// is conditioned, then restores the previous operating mode
+bool lora_entropy_seed(lora_entropy_t *pool);
+
+// Background refill: samples only while the radio is already receiving.
+// Returns true when a new block was conditioned into the key.
+bool lora_entropy_poll(lora_entropy_t *pool);
+
+// Random bytes from the conditioned pool; false until seeded
+bool lora_entropy_read(lora_entropy_t *pool, uint8_t *buffer, size_t size);
+uint32_t lora_entropy_u32(lora_entropy_t *pool);
+
+// SHA-256, used as the conditioning function
+void lora_sha256_init(lora_sha256_t *sha);
+void lora_sha256_update(lora_sha256_t *sha, const uint8_t *data, size_t size);
+void lora_sha256_final(lora_sha256_t *sha, uint8_t digest[32]);
+
+#endif // LORA_ENTROPY_H
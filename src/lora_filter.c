@@ -0,0 +1,53 @@
+#include "lora_filter.h"
+#include "lora_stats.h"
+#include <string.h>
+
+void lora_filter_init(lora_filter_t *filter, uint8_t address) {
+    memset(filter, 0, sizeof(lora_filter_t));
+    filter->address = address;
+    filter->dedup = true;
+    lora_dedup_init(&filter->cache);
+}
+
+int lora_parse_packet_filtered(lora_ctx_t *ctx, int size, lora_filter_t *filter) {
+    uint8_t header[LORA_FILTER_HEADER_LENGTH];
+
+    int packet_length = lora_parse_packet(ctx, size);
+    if (packet_length == 0) {
+        return 0;
+    }
+
+    if (packet_length < LORA_FILTER_HEADER_LENGTH) {
+        filter->stats.runts++;
+    } else {
+        // Only the header crosses the bus before the frame is judged
+        lora_read_bytes(ctx, header, LORA_FILTER_HEADER_LENGTH);
+
+        // Link quality is the sender's whoever the frame is for
+        if (ctx->stats) {
+            lora_stats_peer_rx(ctx->stats, header[1], &ctx->link);
+        }
+
+        if (!filter->promiscuous && header[0] != filter->address && header[0] != LORA_ADDR_BROADCAST) {
+            filter->stats.wrong_address++;
+        } else if (filter->dedup && lora_dedup_check(&filter->cache, ((uint32_t)header[1] << 8) | header[2])) {
+            filter->stats.duplicates++;
+        } else {
+            filter->dest = header[0];
+            filter->src = header[1];
+            filter->seq = header[2];
+            filter->stats.accepted++;
+            return packet_length;
+        }
+    }
+
+    // Dropped: go straight back to receiving
+    lora_parse_packet(ctx, size);
+    return 0;
+}
+
+size_t lora_write_header(lora_ctx_t *ctx, uint8_t dest, uint8_t src, uint8_t seq) {
+    uint8_t header[LORA_FILTER_HEADER_LENGTH] = { dest, src, seq };
+
+    return lora_write(ctx, header, sizeof(header));
+}
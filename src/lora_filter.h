@@ -0,0 +1,47 @@
+#ifndef LORA_FILTER_H
+#define LORA_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lora.h"
+#include "lora_dedup.h"
+
+// Frame header read by the filter: destination, source, sequence
+#define LORA_FILTER_HEADER_LENGTH 3
+#define LORA_ADDR_BROADCAST       0xff
+
+// Filter statistics
+typedef struct {
+    uint32_t accepted;
+    uint32_t wrong_address;
+    uint32_t duplicates;
+    uint32_t runts;             // Frames shorter than the header
+} lora_filter_stats_t;
+
+// Receive filter
+typedef struct {
+    uint8_t address;            // Own address
+    bool promiscuous;           // Accept frames for any destination
+    bool dedup;                 // Drop repeated (source, sequence) pairs
+    lora_dedup_t cache;
+
+    // Header of the last accepted frame
+    uint8_t dest;
+    uint8_t src;
+    uint8_t seq;
+
+    lora_filter_stats_t stats;
+} lora_filter_t;
+
+void lora_filter_init(lora_filter_t *filter, uint8_t address);
+
+// Like lora_parse_packet(), but only frames for this node that were not
+// seen before are reported. Returns the full frame length, so a header-only
+// frame is still non-zero; the header has been consumed and is available in
+// filter->dest/src/seq, lora_available() gives what follows it.
+int lora_parse_packet_filtered(lora_ctx_t *ctx, int size, lora_filter_t *filter);
+
+// Write the filter header after lora_begin_packet()
+size_t lora_write_header(lora_ctx_t *ctx, uint8_t dest, uint8_t src, uint8_t seq);
+
+#endif // LORA_FILTER_H
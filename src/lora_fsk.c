@@ -0,0 +1,321 @@
+#include "lora_fsk.h"
+#include <string.h>
+
+#define FSK_FXOSC               32000000
+
+// The datasheet quotes filter bandwidths to 0.1 kHz (166.7 kHz for 166666 Hz),
+// so a request this close above a filter still selects it
+#define FSK_RX_BW_ROUNDING_HZ   50
+
+// Forward declarations of static functions
+static bool valid_length(const lora_fsk_config_t *config, size_t length);
+static void clear_fifo(lora_ctx_t *ctx);
+static bool tx_failed(lora_fsk_t *fsk, const char *message);
+
+void lora_fsk_default_config(lora_fsk_config_t *config) {
+    static const uint8_t sync_word[] = { 0x2d, 0xd4 };
+
+    memset(config, 0, sizeof(lora_fsk_config_t));
+    config->bitrate = 100000;
+    config->deviation_hz = 50000;
+    config->rx_bandwidth_hz = 166700;
+    config->shaping = LORA_FSK_SHAPING_BT_1_0;
+    config->preamble_length = 4;
+    memcpy(config->sync_word, sync_word, sizeof(sync_word));
+    config->sync_length = sizeof(sync_word);
+    config->crc_enabled = true;
+    config->whitening = true;
+}
+
+bool lora_fsk_begin(lora_fsk_t *fsk, lora_ctx_t *ctx, const lora_fsk_config_t *config) {
+    if (config->bitrate < 1200 || config->bitrate > 300000 || config->sync_length < 1 ||
+        config->sync_length > 8 || config->fixed_length > LORA_FSK_MAX_FIXED_LENGTH) {
+        return false;
+    }
+
+    memset(fsk, 0, sizeof(lora_fsk_t));
+    fsk->lora = ctx;
+    fsk->config = *config;
+
+    if (lora_modem(ctx) == LORA_MODEM_LORA) {
+        lora_checkpoint_save(ctx, &fsk->lora_checkpoint);
+    }
+    lora_set_modem(ctx, LORA_MODEM_FSK);
+
+    lora_fsk_set_bitrate(fsk, config->bitrate);
+    lora_fsk_set_deviation(fsk, config->deviation_hz);
+    lora_fsk_set_rx_bandwidth(fsk, config->rx_bandwidth_hz);
+    lora_fsk_set_shaping(fsk, config->shaping);
+    lora_fsk_set_preamble_length(fsk, config->preamble_length);
+    lora_fsk_set_sync_word(fsk, config->sync_word, config->sync_length);
+    lora_fsk_set_packet_format(fsk, config->crc_enabled, config->whitening, config->fixed_length);
+
+    // AGC on, receiver starts on a detected preamble (2 bytes, 10 chip errors)
+    lora_write_register(ctx, REG_FSK_RX_CONFIG, 0x0e);
+    lora_write_register(ctx, REG_FSK_PREAMBLE_DETECT, 0xaa);
+
+    // TX starts as soon as the FIFO is not empty
+    lora_write_register(ctx, REG_FSK_FIFO_THRESH, 0x80 | LORA_FSK_FIFO_THRESHOLD);
+    return true;
+}
+
+void lora_fsk_end(lora_fsk_t *fsk) {
+    lora_ctx_t *ctx = fsk->lora;
+
+    lora_set_modem(ctx, LORA_MODEM_LORA);
+    if (lora_checkpoint_valid(&fsk->lora_checkpoint) && !lora_checkpoint_matches(ctx, &fsk->lora_checkpoint)) {
+        lora_checkpoint_restore(ctx, &fsk->lora_checkpoint);
+    }
+}
+
+// Bitrate = FXOSC / (BitRate + BitRateFrac / 16)
+void lora_fsk_set_bitrate(lora_fsk_t *fsk, uint32_t bitrate) {
+    uint32_t value = FSK_FXOSC / bitrate;
+    uint32_t frac = ((FSK_FXOSC % bitrate) * 16 + bitrate / 2) / bitrate;
+
+    if (frac == 16) {
+        value++;
+        frac = 0;
+    }
+
+    uint8_t regs[2] = { (uint8_t)(value >> 8), (uint8_t)value };
+    lora_write_register_burst(fsk->lora, REG_FSK_BITRATE_MSB, regs, sizeof(regs));
+    lora_write_register(fsk->lora, REG_FSK_BITRATE_FRAC, (uint8_t)frac);
+    fsk->config.bitrate = bitrate;
+}
+
+// Fdev = Fstep * Fdev, Fstep = FXOSC / 2^19
+void lora_fsk_set_deviation(lora_fsk_t *fsk, uint32_t deviation_hz) {
+    uint32_t value = (uint32_t)((((uint64_t)deviation_hz << 19) + FSK_FXOSC / 2) / FSK_FXOSC);
+
+    if (value > 0x3fff) {
+        value = 0x3fff;
+    }
+
+    uint8_t regs[2] = { (uint8_t)(value >> 8), (uint8_t)value };
+    lora_write_register_burst(fsk->lora, REG_FSK_FDEV_MSB, regs, sizeof(regs));
+    fsk->config.deviation_hz = deviation_hz;
+}
+
+// RxBw = FXOSC / (mantissa * 2^(exponent + 2)); returns the bandwidth used
+uint32_t lora_fsk_set_rx_bandwidth(lora_fsk_t *fsk, uint32_t bandwidth_hz) {
+    static const uint8_t mantissas[] = { 16, 20, 24 };
+    uint32_t best = 0;
+    uint8_t reg = 0x01;     // 250 kHz, the widest
+
+    for (uint8_t exponent = 1; exponent <= 7; exponent++) {
+        for (uint8_t m = 0; m < 3; m++) {
+            uint32_t bw = FSK_FXOSC / ((uint32_t)mantissas[m] << (exponent + 2));
+            if (bw + FSK_RX_BW_ROUNDING_HZ >= bandwidth_hz && (best == 0 || bw < best)) {
+                best = bw;
+                reg = (uint8_t)((m << 3) | exponent);
+            }
+        }
+    }
+    if (best == 0) {
+        best = FSK_FXOSC / (16 << 3);
+    }
+
+    lora_write_register(fsk->lora, REG_FSK_RX_BW, reg);
+    lora_write_register(fsk->lora, REG_FSK_AFC_BW, reg);
+    fsk->config.rx_bandwidth_hz = best;
+    return best;
+}
+
+void lora_fsk_set_shaping(lora_fsk_t *fsk, lora_fsk_shaping_t shaping) {
+    uint8_t ramp = lora_read_register(fsk->lora, REG_FSK_PA_RAMP);
+
+    lora_write_register(fsk->lora, REG_FSK_PA_RAMP, (ramp & 0x9f) | ((shaping & 0x03) << 5));
+    fsk->config.shaping = shaping;
+}
+
+void lora_fsk_set_preamble_length(lora_fsk_t *fsk, uint16_t length) {
+    uint8_t regs[2] = { (uint8_t)(length >> 8), (uint8_t)length };
+
+    lora_write_register_burst(fsk->lora, REG_FSK_PREAMBLE_MSB, regs, sizeof(regs));
+    fsk->config.preamble_length = length;
+}
+
+bool lora_fsk_set_sync_word(lora_fsk_t *fsk, const uint8_t *sync_word, uint8_t length) {
+    if (length < 1 || length > 8) {
+        return false;
+    }
+
+    // Auto restart RX after a packet, 0xaa preamble, sync word on
+    lora_write_register(fsk->lora, REG_FSK_SYNC_CONFIG, 0x50 | (length - 1));
+    lora_write_register_burst(fsk->lora, REG_FSK_SYNC_VALUE_1, sync_word, length);
+    if (sync_word != fsk->config.sync_word) {
+        memcpy(fsk->config.sync_word, sync_word, length);
+    }
+    fsk->config.sync_length = length;
+    return true;
+}
+
+void lora_fsk_set_packet_format(lora_fsk_t *fsk, bool crc_enabled, bool whitening, uint16_t fixed_length) {
+    uint8_t config_1 = 0x08;    // Keep the payload on a CRC error; we check CrcOk
+    uint8_t regs[3];
+
+    if (fixed_length > LORA_FSK_MAX_FIXED_LENGTH) {
+        fixed_length = LORA_FSK_MAX_FIXED_LENGTH;
+    }
+    if (fixed_length == 0) {
+        config_1 |= 0x80;
+    }
+    if (whitening) {
+        config_1 |= 0x40;
+    }
+    if (crc_enabled) {
+        config_1 |= 0x10;
+    }
+
+    // Packet mode; PayloadLength is the fixed length, or the RX limit
+    regs[0] = config_1;
+    regs[1] = 0x40 | ((fixed_length >> 8) & 0x07);
+    regs[2] = fixed_length ? (uint8_t)fixed_length : LORA_FSK_MAX_VARIABLE_LENGTH;
+    lora_write_register_burst(fsk->lora, REG_FSK_PACKET_CONFIG_1, regs, sizeof(regs));
+
+    fsk->config.crc_enabled = crc_enabled;
+    fsk->config.whitening = whitening;
+    fsk->config.fixed_length = fixed_length;
+}
+
+bool lora_fsk_send(lora_fsk_t *fsk, const uint8_t *data, size_t length) {
+    lora_ctx_t *ctx = fsk->lora;
+    const size_t chunk = FSK_FIFO_SIZE - LORA_FSK_FIFO_THRESHOLD - 1;
+
+    if (!valid_length(&fsk->config, length)) {
+        return false;
+    }
+
+    lora_idle(ctx);
+    clear_fifo(ctx);
+
+    // Prefill the FIFO, then top it up each time it drains to the threshold
+    size_t room = FSK_FIFO_SIZE;
+    if (fsk->config.fixed_length == 0) {
+        lora_write_register(ctx, REG_FIFO, (uint8_t)length);
+        room--;
+    }
+    size_t index = length < room ? length : room;
+    lora_write_register_burst(ctx, REG_FIFO, data, index);
+
+    uint64_t deadline = time_us_64() + 2ULL * lora_fsk_time_on_air_us(&fsk->config, length) + LORA_FSK_TX_TIMEOUT_MARGIN_US;
+    lora_set_mode(ctx, MODE_TX);
+
+    while (index < length) {
+        if ((lora_read_register(ctx, REG_FSK_IRQ_FLAGS_2) & FSK_IRQ2_FIFO_LEVEL) == 0) {
+            size_t n = length - index < chunk ? length - index : chunk;
+            lora_write_register_burst(ctx, REG_FIFO, data + index, n);
+            index += n;
+        } else if (time_us_64() > deadline) {
+            return tx_failed(fsk, "FSK TX stalled");
+        }
+    }
+
+    while ((lora_read_register(ctx, REG_FSK_IRQ_FLAGS_2) & FSK_IRQ2_PACKET_SENT) == 0) {
+        if (time_us_64() > deadline) {
+            return tx_failed(fsk, "FSK TX timeout");
+        }
+    }
+
+    lora_idle(ctx);
+    fsk->packets_tx++;
+    return true;
+}
+
+int lora_fsk_receive(lora_fsk_t *fsk, uint8_t *buffer, size_t capacity, uint32_t timeout_us) {
+    lora_ctx_t *ctx = fsk->lora;
+    size_t length = fsk->config.fixed_length;
+    size_t index = 0;
+    bool started = false;
+    uint8_t irq2;
+
+    lora_idle(ctx);
+    clear_fifo(ctx);
+    lora_set_mode(ctx, MODE_RX_CONTINUOUS);
+
+    uint64_t deadline = time_us_64() + timeout_us;
+    for (;;) {
+        irq2 = lora_read_register(ctx, REG_FSK_IRQ_FLAGS_2);
+        bool ready = (irq2 & FSK_IRQ2_PAYLOAD_READY) != 0;
+
+        if (ready || (irq2 & FSK_IRQ2_FIFO_LEVEL)) {
+            if (!started) {
+                // The packet now has its own deadline from its air time
+                started = true;
+                if (fsk->config.fixed_length == 0) {
+                    length = lora_read_register(ctx, REG_FIFO);
+                }
+                if (length > capacity || length == 0) {
+                    lora_idle(ctx);
+                    LORA_LOG_WARN(ctx, "FSK packet does not fit");
+                    return -1;
+                }
+                deadline = time_us_64() + 2ULL * lora_fsk_time_on_air_us(&fsk->config, length) +
+                           LORA_FSK_TX_TIMEOUT_MARGIN_US;
+            }
+
+            // The whole rest when ready, otherwise what the level guarantees
+            size_t n = length - index;
+            if (!ready && n > LORA_FSK_FIFO_THRESHOLD) {
+                n = LORA_FSK_FIFO_THRESHOLD;
+            }
+            if (n > 0) {
+                lora_read_register_burst(ctx, REG_FIFO, buffer + index, n);
+                index += n;
+            }
+
+            if (ready) {
+                break;
+            }
+        } else if (time_us_64() > deadline) {
+            lora_idle(ctx);
+            if (started) {
+                fsk->timeouts++;
+                return -1;
+            }
+            return 0;
+        }
+    }
+
+    lora_idle(ctx);
+    if (fsk->config.crc_enabled && (irq2 & FSK_IRQ2_CRC_OK) == 0) {
+        fsk->crc_errors++;
+        return -1;
+    }
+    fsk->packets_rx++;
+    return (int)length;
+}
+
+// Preamble, sync word, length byte, payload and CRC at one bit per symbol
+uint32_t lora_fsk_time_on_air_us(const lora_fsk_config_t *config, size_t length) {
+    uint64_t bytes = config->preamble_length + config->sync_length + length;
+
+    if (config->fixed_length == 0) {
+        bytes++;
+    }
+    if (config->crc_enabled) {
+        bytes += 2;
+    }
+    return (uint32_t)((bytes * 8 * 1000000ULL + config->bitrate - 1) / config->bitrate);
+}
+
+// Private functions
+static bool valid_length(const lora_fsk_config_t *config, size_t length) {
+    if (config->fixed_length) {
+        return length == config->fixed_length;
+    }
+    return length > 0 && length <= LORA_FSK_MAX_VARIABLE_LENGTH;
+}
+
+// Writing FifoOverrun empties the FIFO
+static void clear_fifo(lora_ctx_t *ctx) {
+    lora_write_register(ctx, REG_FSK_IRQ_FLAGS_2, FSK_IRQ2_FIFO_OVERRUN);
+}
+
+static bool tx_failed(lora_fsk_t *fsk, const char *message) {
+    lora_idle(fsk->lora);
+    fsk->timeouts++;
+    LORA_LOG_WARN(fsk->lora, message);
+    return false;
+}
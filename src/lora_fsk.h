@@ -0,0 +1,85 @@
+#ifndef LORA_FSK_H
+#define LORA_FSK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lora.h"
+
+// Longest FSK packet: variable length carries a length byte (255 max),
+// fixed length goes up to the 11-bit PayloadLength
+#define LORA_FSK_MAX_VARIABLE_LENGTH    255
+#define LORA_FSK_MAX_FIXED_LENGTH       2047
+
+// FIFO level used for streaming: TX refills once the FIFO holds this many
+// bytes or fewer, RX drains once it holds more
+#ifndef LORA_FSK_FIFO_THRESHOLD
+#define LORA_FSK_FIFO_THRESHOLD         31
+#endif
+
+// Send gives up after twice the packet's air time plus this margin
+#ifndef LORA_FSK_TX_TIMEOUT_MARGIN_US
+#define LORA_FSK_TX_TIMEOUT_MARGIN_US   10000
+#endif
+
+// Gaussian filter (GFSK) in REG_FSK_PA_RAMP
+typedef enum {
+    LORA_FSK_SHAPING_NONE = 0,
+    LORA_FSK_SHAPING_BT_1_0,
+    LORA_FSK_SHAPING_BT_0_5,
+    LORA_FSK_SHAPING_BT_0_3
+} lora_fsk_shaping_t;
+
+typedef struct {
+    uint32_t bitrate;               // bps, 1200 to 300000
+    uint32_t deviation_hz;          // Keep deviation + bitrate / 2 <= 250 kHz
+    uint32_t rx_bandwidth_hz;       // Next filter up; datasheet figures like 166700 match theirs
+    lora_fsk_shaping_t shaping;
+    uint16_t preamble_length;       // Bytes
+    uint8_t sync_word[8];
+    uint8_t sync_length;            // 1 to 8 bytes
+    bool crc_enabled;
+    bool whitening;
+    uint16_t fixed_length;          // 0 for variable length packets
+} lora_fsk_config_t;
+
+typedef struct {
+    lora_ctx_t *lora;
+    lora_fsk_config_t config;
+    lora_checkpoint_t lora_checkpoint;  // LoRa configuration to return to
+    uint32_t packets_tx;
+    uint32_t packets_rx;
+    uint32_t crc_errors;
+    uint32_t timeouts;
+} lora_fsk_t;
+
+// 100 kbps GFSK BT 1.0, 50 kHz deviation, CRC and whitening on
+void lora_fsk_default_config(lora_fsk_config_t *config);
+
+// Switch the radio to FSK with this configuration, remembering the LoRa one
+bool lora_fsk_begin(lora_fsk_t *fsk, lora_ctx_t *ctx, const lora_fsk_config_t *config);
+
+// Switch back to LoRa, rewriting the LoRa configuration if it was lost
+void lora_fsk_end(lora_fsk_t *fsk);
+
+// Individual settings; the radio must be in FSK mode
+void lora_fsk_set_bitrate(lora_fsk_t *fsk, uint32_t bitrate);
+void lora_fsk_set_deviation(lora_fsk_t *fsk, uint32_t deviation_hz);
+uint32_t lora_fsk_set_rx_bandwidth(lora_fsk_t *fsk, uint32_t bandwidth_hz);
+void lora_fsk_set_shaping(lora_fsk_t *fsk, lora_fsk_shaping_t shaping);
+void lora_fsk_set_preamble_length(lora_fsk_t *fsk, uint16_t length);
+bool lora_fsk_set_sync_word(lora_fsk_t *fsk, const uint8_t *sync_word, uint8_t length);
+void lora_fsk_set_packet_format(lora_fsk_t *fsk, bool crc_enabled, bool whitening, uint16_t fixed_length);
+
+// Blocking send; packets longer than the FIFO are streamed on the FIFO
+// level. False if the length does not fit the packet format or TX stalls.
+bool lora_fsk_send(lora_fsk_t *fsk, const uint8_t *data, size_t length);
+
+// Blocking receive into buffer. Returns the packet length, 0 on timeout,
+// or -1 on a CRC error or a packet longer than capacity.
+int lora_fsk_receive(lora_fsk_t *fsk, uint8_t *buffer, size_t capacity, uint32_t timeout_us);
+
+// Air time of one packet with the current configuration
+uint32_t lora_fsk_time_on_air_us(const lora_fsk_config_t *config, size_t length);
+
+#endif // LORA_FSK_H
@@ -0,0 +1,311 @@
+#include "lora_mesh.h"
+#include "lora_stats.h"
+#include <string.h>
+
+// Forward declarations of static functions
+static int handle_frame(lora_mesh_t *mesh, int length, uint64_t now);
+static void schedule_relay(lora_mesh_t *mesh, const uint8_t *frame, int length, int8_t snr, uint64_t now);
+static bool send_due_relay(lora_mesh_t *mesh, uint64_t now);
+static void refill_airtime(lora_mesh_t *mesh, uint64_t now);
+static void update_neighbour(lora_mesh_t *mesh, const uint8_t *frame, int8_t snr);
+static bool transmit(lora_mesh_t *mesh, const uint8_t *frame, uint8_t length);
+static uint32_t frame_key(const uint8_t *frame);
+static uint32_t next_random(lora_mesh_t *mesh);
+
+void lora_mesh_init(lora_mesh_t *mesh, lora_ctx_t *ctx, uint8_t address, uint16_t duty_permille, uint32_t budget_us) {
+    memset(mesh, 0, sizeof(lora_mesh_t));
+    mesh->lora = ctx;
+    mesh->address = address;
+    mesh->duty_permille = duty_permille;
+    mesh->airtime_budget_us = budget_us;
+    mesh->airtime_tokens_us = budget_us;
+    mesh->airtime_refill_us = time_us_64();
+    lora_dedup_init(&mesh->cache);
+
+    // Random start so message IDs do not repeat across reboots
+    for (int i = 0; i < 4; i++) {
+        mesh->rng = (mesh->rng << 8) | lora_random(ctx);
+    }
+    mesh->rng |= 1;
+    mesh->next_id = (uint16_t)next_random(mesh);
+}
+
+bool lora_mesh_send(lora_mesh_t *mesh, uint8_t dest, const uint8_t *buffer, uint8_t size) {
+    uint8_t frame[MAX_PKT_LENGTH];
+
+    if (size > LORA_MESH_MAX_PAYLOAD) {
+        return false;
+    }
+
+    uint16_t id = mesh->next_id;
+    frame[LORA_MESH_DEST] = dest;
+    frame[LORA_MESH_ORIGIN] = mesh->address;
+    frame[LORA_MESH_ID] = (uint8_t)(id >> 0);
+    frame[LORA_MESH_ID + 1] = (uint8_t)(id >> 8);
+    frame[LORA_MESH_TTL] = LORA_MESH_DEFAULT_TTL;
+    frame[LORA_MESH_HOP] = mesh->address;
+    memcpy(&frame[LORA_MESH_HEADER_LENGTH], buffer, size);
+
+    if (!transmit(mesh, frame, LORA_MESH_HEADER_LENGTH + size)) {
+        return false;
+    }
+
+    // Ignore our own frame when neighbours echo it back
+    lora_dedup_insert(&mesh->cache, frame_key(frame));
+    mesh->next_id++;
+    mesh->stats.originated++;
+    return true;
+}
+
+int lora_mesh_poll(lora_mesh_t *mesh) {
+    lora_ctx_t *ctx = mesh->lora;
+    uint64_t now = time_us_64();
+
+    if (lora_is_transmitting(ctx)) {
+        return 0;
+    }
+
+    refill_airtime(mesh, now);
+    if (send_due_relay(mesh, now)) {
+        return 0;
+    }
+
+    int length = lora_parse_packet(ctx, 0);
+    if (length < LORA_MESH_HEADER_LENGTH) {
+        return 0;
+    }
+
+    lora_read_bytes(ctx, mesh->rx_frame, length);
+    return handle_frame(mesh, length, now);
+}
+
+const uint8_t *lora_mesh_payload(const lora_mesh_t *mesh) {
+    return &mesh->rx_frame[LORA_MESH_HEADER_LENGTH];
+}
+
+uint8_t lora_mesh_origin(const lora_mesh_t *mesh) {
+    return mesh->rx_frame[LORA_MESH_ORIGIN];
+}
+
+// Statistics
+const lora_mesh_neighbour_t *lora_mesh_neighbour(const lora_mesh_t *mesh, uint8_t address) {
+    for (int i = 0; i < LORA_MESH_MAX_NEIGHBOURS; i++) {
+        if (mesh->neighbours[i].heard > 0 && mesh->neighbours[i].address == address) {
+            return &mesh->neighbours[i];
+        }
+    }
+    return NULL;
+}
+
+void lora_mesh_print_stats(lora_mesh_t *mesh) {
+    print_ctx_t *p = &mesh->lora->print;
+    const lora_mesh_stats_t *st = &mesh->stats;
+
+    print_str(p, "mesh orig=");
+    print_ulong(p, st->originated, DEC);
+    print_str(p, " dlvr=");
+    print_ulong(p, st->delivered, DEC);
+    print_str(p, " relay=");
+    print_ulong(p, st->relayed, DEC);
+    print_str(p, " supp=");
+    print_ulong(p, st->suppressed, DEC);
+    print_str(p, " dup=");
+    print_ulong(p, st->duplicates, DEC);
+    print_str(p, " ttl=");
+    print_ulong(p, st->ttl_expired, DEC);
+    print_str(p, " rate=");
+    print_ulong(p, st->rate_limited, DEC);
+    print_str(p, " full=");
+    print_ulong(p, st->queue_full, DEC);
+    print_str(p, " airtime_us=");
+    print_ulonglong(p, st->relay_airtime_us, DEC);
+    println(p);
+
+    for (int i = 0; i < LORA_MESH_MAX_NEIGHBOURS; i++) {
+        const lora_mesh_neighbour_t *n = &mesh->neighbours[i];
+        if (n->heard == 0) {
+            continue;
+        }
+        print_str(p, "  nbr ");
+        print_uchar(p, n->address, DEC);
+        print_str(p, " heard=");
+        print_ulong(p, n->heard, DEC);
+        print_str(p, " relays=");
+        print_ulong(p, n->relays_heard, DEC);
+        print_str(p, " snr=");
+        print_double(p, n->last_snr * 0.25, 2);
+        println(p);
+    }
+}
+
+// Private functions
+static int handle_frame(lora_mesh_t *mesh, int length, uint64_t now) {
+    const uint8_t *frame = mesh->rx_frame;
+    int8_t snr = mesh->lora->link.snr_q;
+    uint32_t key = frame_key(frame);
+
+    update_neighbour(mesh, frame, snr);
+    if (mesh->lora->stats) {
+        lora_stats_peer_rx(mesh->lora->stats, frame[LORA_MESH_HOP], &mesh->lora->link);
+    }
+
+    // A neighbour already forwarded what we were waiting to forward
+    for (int i = 0; i < LORA_MESH_RELAY_SLOTS; i++) {
+        if (mesh->relays[i].used && mesh->relays[i].key == key) {
+            mesh->relays[i].used = false;
+            mesh->stats.suppressed++;
+        }
+    }
+
+    if (lora_dedup_check(&mesh->cache, key)) {
+        mesh->stats.duplicates++;
+        return 0;
+    }
+
+    uint8_t dest = frame[LORA_MESH_DEST];
+    if (dest != mesh->address) {
+        schedule_relay(mesh, frame, length, snr, now);
+    }
+
+    if (dest == mesh->address || dest == LORA_MESH_BROADCAST) {
+        mesh->rx_length = length;
+        mesh->stats.delivered++;
+        return length - LORA_MESH_HEADER_LENGTH;
+    }
+
+    return 0;
+}
+
+static void schedule_relay(lora_mesh_t *mesh, const uint8_t *frame, int length, int8_t snr, uint64_t now) {
+    if (frame[LORA_MESH_TTL] <= 1) {
+        mesh->stats.ttl_expired++;
+        return;
+    }
+
+    lora_mesh_relay_t *relay = NULL;
+    for (int i = 0; i < LORA_MESH_RELAY_SLOTS; i++) {
+        if (!mesh->relays[i].used) {
+            relay = &mesh->relays[i];
+            break;
+        }
+    }
+    if (!relay) {
+        mesh->stats.queue_full++;
+        return;
+    }
+
+    // Weak SNR means we are far from the sender, so our rebroadcast adds
+    // the most coverage: relays with low SNR go first, strong ones wait
+    // and are likely to overhear them and stand down.
+    int snr_db = snr / 4;
+    if (snr_db < LORA_MESH_SNR_MIN_DB) snr_db = LORA_MESH_SNR_MIN_DB;
+    if (snr_db > LORA_MESH_SNR_MAX_DB) snr_db = LORA_MESH_SNR_MAX_DB;
+
+    uint32_t delay = (uint32_t)(((uint64_t)LORA_MESH_RELAY_WINDOW_US * (snr_db - LORA_MESH_SNR_MIN_DB)) /
+                                (LORA_MESH_SNR_MAX_DB - LORA_MESH_SNR_MIN_DB));
+    delay += next_random(mesh) % (LORA_MESH_RELAY_JITTER_US + 1);
+
+    memcpy(relay->frame, frame, length);
+    relay->frame[LORA_MESH_TTL]--;
+    relay->frame[LORA_MESH_HOP] = mesh->address;
+    relay->length = length;
+    relay->key = frame_key(frame);
+    relay->due_us = now + delay;
+    relay->used = true;
+}
+
+static bool send_due_relay(lora_mesh_t *mesh, uint64_t now) {
+    for (int i = 0; i < LORA_MESH_RELAY_SLOTS; i++) {
+        lora_mesh_relay_t *relay = &mesh->relays[i];
+
+        if (!relay->used || relay->due_us > now) {
+            continue;
+        }
+
+        uint32_t airtime = lora_time_on_air_us(&mesh->lora->config, false, relay->length);
+        if (airtime > mesh->airtime_tokens_us) {
+            relay->used = false;
+            mesh->stats.rate_limited++;
+            continue;
+        }
+
+        if (transmit(mesh, relay->frame, relay->length)) {
+            relay->used = false;
+            mesh->airtime_tokens_us -= airtime;
+            mesh->stats.relayed++;
+            mesh->stats.relay_airtime_us += airtime;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Token bucket: relay airtime accrues at duty_permille of wall time
+static void refill_airtime(lora_mesh_t *mesh, uint64_t now) {
+    uint64_t earned = ((now - mesh->airtime_refill_us) * mesh->duty_permille) / 1000;
+
+    if (earned == 0) {
+        return;
+    }
+
+    mesh->airtime_refill_us = now;
+    if (mesh->airtime_tokens_us + earned > mesh->airtime_budget_us) {
+        mesh->airtime_tokens_us = mesh->airtime_budget_us;
+    } else {
+        mesh->airtime_tokens_us += (uint32_t)earned;
+    }
+}
+
+static void update_neighbour(lora_mesh_t *mesh, const uint8_t *frame, int8_t snr) {
+    uint8_t hop = frame[LORA_MESH_HOP];
+    lora_mesh_neighbour_t *slot = &mesh->neighbours[0];
+
+    for (int i = 0; i < LORA_MESH_MAX_NEIGHBOURS; i++) {
+        lora_mesh_neighbour_t *n = &mesh->neighbours[i];
+        if (n->heard > 0 && n->address == hop) {
+            slot = n;
+            break;
+        }
+        // Otherwise reuse the least active entry
+        if (n->heard < slot->heard) {
+            slot = n;
+        }
+    }
+
+    if (slot->heard == 0 || slot->address != hop) {
+        memset(slot, 0, sizeof(lora_mesh_neighbour_t));
+        slot->address = hop;
+    }
+
+    slot->heard++;
+    slot->last_snr = snr;
+    if (hop != frame[LORA_MESH_ORIGIN]) {
+        slot->relays_heard++;
+    }
+}
+
+static bool transmit(lora_mesh_t *mesh, const uint8_t *frame, uint8_t length) {
+    lora_ctx_t *ctx = mesh->lora;
+
+    if (!lora_begin_packet(ctx, false)) {
+        return false;
+    }
+    lora_write(ctx, frame, length);
+    return lora_end_packet(ctx, true);
+}
+
+// Origin and message ID identify a frame across hops
+static uint32_t frame_key(const uint8_t *frame) {
+    return ((uint32_t)frame[LORA_MESH_ORIGIN] << 16) | frame[LORA_MESH_ID] | (frame[LORA_MESH_ID + 1] << 8);
+}
+
+static uint32_t next_random(lora_mesh_t *mesh) {
+    // xorshift32
+    uint32_t x = mesh->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    mesh->rng = x;
+    return x;
+}
@@ -0,0 +1,115 @@
+#ifndef LORA_MESH_H
+#define LORA_MESH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lora.h"
+#include "lora_dedup.h"
+
+// Frame header: destination, origin, message ID (LE16), TTL, last hop
+#define LORA_MESH_HEADER_LENGTH 6
+#define LORA_MESH_DEST          0
+#define LORA_MESH_ORIGIN        1
+#define LORA_MESH_ID            2
+#define LORA_MESH_TTL           4
+#define LORA_MESH_HOP           5
+#define LORA_MESH_MAX_PAYLOAD   (MAX_PKT_LENGTH - LORA_MESH_HEADER_LENGTH)
+#define LORA_MESH_BROADCAST     0xff
+
+#ifndef LORA_MESH_DEFAULT_TTL
+#define LORA_MESH_DEFAULT_TTL   3
+#endif
+
+// Frames waiting for their rebroadcast delay
+#ifndef LORA_MESH_RELAY_SLOTS
+#define LORA_MESH_RELAY_SLOTS   2
+#endif
+
+// Neighbours tracked for per-node statistics
+#ifndef LORA_MESH_MAX_NEIGHBOURS
+#define LORA_MESH_MAX_NEIGHBOURS 8
+#endif
+
+// Rebroadcast delay: SNR-scaled window plus random jitter
+#ifndef LORA_MESH_RELAY_WINDOW_US
+#define LORA_MESH_RELAY_WINDOW_US 200000
+#endif
+#ifndef LORA_MESH_RELAY_JITTER_US
+#define LORA_MESH_RELAY_JITTER_US 50000
+#endif
+
+// SNR range (dB) mapped onto the rebroadcast window
+#define LORA_MESH_SNR_MIN_DB    (-20)
+#define LORA_MESH_SNR_MAX_DB    10
+
+// Relay statistics
+typedef struct {
+    uint32_t originated;
+    uint32_t delivered;
+    uint32_t relayed;
+    uint32_t suppressed;        // Relay cancelled after overhearing a neighbour
+    uint32_t duplicates;
+    uint32_t ttl_expired;
+    uint32_t rate_limited;
+    uint32_t queue_full;
+    uint64_t relay_airtime_us;
+} lora_mesh_stats_t;
+
+// Per-neighbour statistics, keyed by last hop
+typedef struct {
+    uint8_t address;
+    uint32_t heard;
+    uint32_t relays_heard;      // Frames this neighbour forwarded for others
+    int8_t last_snr;            // Quarter dB
+} lora_mesh_neighbour_t;
+
+typedef struct {
+    bool used;
+    uint64_t due_us;
+    uint32_t key;
+    uint8_t length;
+    uint8_t frame[MAX_PKT_LENGTH];
+} lora_mesh_relay_t;
+
+// Mesh relay context
+typedef struct {
+    lora_ctx_t *lora;
+    uint8_t address;
+    uint16_t next_id;
+    lora_dedup_t cache;
+    lora_mesh_relay_t relays[LORA_MESH_RELAY_SLOTS];
+
+    // Airtime token bucket for relaying
+    uint16_t duty_permille;
+    uint32_t airtime_budget_us;
+    uint32_t airtime_tokens_us;
+    uint64_t airtime_refill_us;
+
+    uint32_t rng;
+
+    // Last frame delivered to this node
+    uint8_t rx_frame[MAX_PKT_LENGTH];
+    uint8_t rx_length;
+
+    lora_mesh_neighbour_t neighbours[LORA_MESH_MAX_NEIGHBOURS];
+    lora_mesh_stats_t stats;
+} lora_mesh_t;
+
+// duty_permille limits relay airtime, e.g. 10 for 1%; budget caps bursts
+void lora_mesh_init(lora_mesh_t *mesh, lora_ctx_t *ctx, uint8_t address, uint16_t duty_permille, uint32_t budget_us);
+
+// Originate a frame
+bool lora_mesh_send(lora_mesh_t *mesh, uint8_t dest, const uint8_t *buffer, uint8_t size);
+
+// Receive, suppress and relay; returns the payload length of a frame for this node
+int lora_mesh_poll(lora_mesh_t *mesh);
+
+// Last delivered frame
+const uint8_t *lora_mesh_payload(const lora_mesh_t *mesh);
+uint8_t lora_mesh_origin(const lora_mesh_t *mesh);
+
+// Statistics
+const lora_mesh_neighbour_t *lora_mesh_neighbour(const lora_mesh_t *mesh, uint8_t address);
+void lora_mesh_print_stats(lora_mesh_t *mesh);
+
+#endif // LORA_MESH_H
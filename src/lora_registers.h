@@ -0,0 +1,135 @@
+#ifndef LORA_REGISTERS_H
+#define LORA_REGISTERS_H
+
+// SX127x register map and bit definitions, shared by the C driver and the
+// header-only C++ driver (lora.hpp)
+
+// Maximum packet length
+#define MAX_PKT_LENGTH 255
+
+// LoRa registers
+#define REG_FIFO                 0x00
+#define REG_OP_MODE             0x01
+#define REG_FRF_MSB             0x06
+#define REG_FRF_MID             0x07
+#define REG_FRF_LSB             0x08
+#define REG_PA_CONFIG           0x09
+#define REG_LNA                 0x0c
+#define REG_FIFO_ADDR_PTR       0x0d
+#define REG_FIFO_TX_BASE_ADDR   0x0e
+#define REG_FIFO_RX_BASE_ADDR   0x0f
+#define REG_FIFO_RX_CURRENT_ADDR 0x10
+#define REG_IRQ_FLAGS           0x12
+#define REG_RX_NB_BYTES         0x13
+#define REG_MODEM_STAT          0x18
+#define REG_PKT_SNR_VALUE       0x19
+#define REG_PKT_RSSI_VALUE      0x1a
+#define REG_RSSI_VALUE          0x1b
+#define REG_HOP_CHANNEL         0x1c
+#define REG_MODEM_CONFIG_1      0x1d
+#define REG_MODEM_CONFIG_2      0x1e
+#define REG_SYMB_TIMEOUT_LSB    0x1f
+#define REG_PREAMBLE_MSB        0x20
+#define REG_PREAMBLE_LSB        0x21
+#define REG_PAYLOAD_LENGTH      0x22
+#define REG_MODEM_CONFIG_3      0x26
+#define REG_FREQ_ERROR_MSB      0x28
+#define REG_FREQ_ERROR_MID      0x29
+#define REG_FREQ_ERROR_LSB      0x2a
+#define REG_RSSI_WIDEBAND       0x2c
+#define REG_DETECTION_OPTIMIZE   0x31
+#define REG_DETECTION_THRESHOLD  0x37
+#define REG_SYNC_WORD           0x39
+#define REG_DIO_MAPPING_1       0x40
+#define REG_VERSION             0x42
+#define REG_PA_DAC              0x4d
+#define REG_INVERTIQ            0x33
+#define REG_INVERTIQ2           0x3b
+#define REG_OCP                 0x0b
+
+// Modes
+#define MODE_LONG_RANGE_MODE    0x80
+#define MODE_SLEEP             0x00
+#define MODE_STDBY             0x01
+#define MODE_FSTX              0x02
+#define MODE_TX                0x03
+#define MODE_RX_CONTINUOUS     0x05
+#define MODE_RX_SINGLE         0x06
+#define MODE_CAD               0x07
+
+// FSK/OOK modulation type in REG_OP_MODE (LongRangeMode clear)
+#define MODE_MODULATION_FSK     0x00
+#define MODE_MODULATION_OOK     0x20
+
+// FSK registers (0x0d-0x3f mean something else in LoRa mode)
+#define REG_FSK_BITRATE_MSB     0x02
+#define REG_FSK_BITRATE_LSB     0x03
+#define REG_FSK_FDEV_MSB        0x04
+#define REG_FSK_FDEV_LSB        0x05
+#define REG_FSK_PA_RAMP         0x0a    // Bits 6-5: Gaussian shaping
+#define REG_FSK_RX_CONFIG       0x0d
+#define REG_FSK_RSSI_CONFIG     0x0e
+#define REG_FSK_RSSI_VALUE      0x11
+#define REG_FSK_RX_BW           0x12
+#define REG_FSK_AFC_BW          0x13
+#define REG_FSK_PREAMBLE_DETECT 0x1f
+#define REG_FSK_PREAMBLE_MSB    0x25
+#define REG_FSK_PREAMBLE_LSB    0x26
+#define REG_FSK_SYNC_CONFIG     0x27
+#define REG_FSK_SYNC_VALUE_1    0x28
+#define REG_FSK_PACKET_CONFIG_1 0x30
+#define REG_FSK_PACKET_CONFIG_2 0x31
+#define REG_FSK_PAYLOAD_LENGTH  0x32
+#define REG_FSK_FIFO_THRESH     0x35
+#define REG_FSK_IRQ_FLAGS_1     0x3e
+#define REG_FSK_IRQ_FLAGS_2     0x3f
+#define REG_FSK_BITRATE_FRAC    0x5d
+
+// FSK IRQ flags 1
+#define FSK_IRQ1_MODE_READY     0x80
+#define FSK_IRQ1_RX_READY       0x40
+#define FSK_IRQ1_TX_READY       0x20
+#define FSK_IRQ1_TIMEOUT        0x04
+#define FSK_IRQ1_PREAMBLE       0x02
+#define FSK_IRQ1_SYNC_MATCH     0x01
+
+// FSK IRQ flags 2
+#define FSK_IRQ2_FIFO_FULL      0x80
+#define FSK_IRQ2_FIFO_EMPTY     0x40
+#define FSK_IRQ2_FIFO_LEVEL     0x20
+#define FSK_IRQ2_FIFO_OVERRUN   0x10
+#define FSK_IRQ2_PACKET_SENT    0x08
+#define FSK_IRQ2_PAYLOAD_READY  0x04
+#define FSK_IRQ2_CRC_OK         0x02
+
+// FSK FIFO size
+#define FSK_FIFO_SIZE           64
+
+// PA config
+#define PA_BOOST               0x80
+#define PA_OUTPUT_RFO_PIN      0
+#define PA_OUTPUT_PA_BOOST_PIN 1
+
+// DIO0 mappings (REG_DIO_MAPPING_1)
+#define DIO0_RX_DONE           0x00
+#define DIO0_TX_DONE           0x40
+#define DIO0_CAD_DONE          0x80
+
+// Reset timing: NRESET pulse width and how long to poll for the chip afterwards
+#ifndef LORA_RESET_PULSE_US
+#define LORA_RESET_PULSE_US      100
+#endif
+#ifndef LORA_RESET_TIMEOUT_US
+#define LORA_RESET_TIMEOUT_US    10000
+#endif
+
+// IRQ masks
+#define IRQ_CAD_DETECTED_MASK      0x01
+#define IRQ_CAD_DONE_MASK          0x04
+#define IRQ_TX_DONE_MASK           0x08
+#define IRQ_VALID_HEADER_MASK      0x10
+#define IRQ_PAYLOAD_CRC_ERROR_MASK 0x20
+#define IRQ_RX_DONE_MASK           0x40
+#define IRQ_RX_TIMEOUT_MASK        0x80
+
+#endif // LORA_REGISTERS_H
@@ -0,0 +1,230 @@
+#include "lora_scan.h"
+#include "lora_stats.h"
+#include <string.h>
+
+// Forward declarations of static functions
+static void start_cad(lora_scan_t *scan);
+static void next_channel(lora_scan_t *scan);
+static void record_dwell(lora_scan_t *scan);
+
+bool lora_scan_begin(lora_scan_t *scan, lora_ctx_t *ctx, const uint32_t *frequencies, uint8_t count) {
+    if (!ctx || !frequencies || count == 0 || count > LORA_SCAN_MAX_CHANNELS) {
+        return false;
+    }
+
+    memset(scan, 0, sizeof(lora_scan_t));
+    scan->lora = ctx;
+    scan->channel_count = count;
+
+    // Precompute FRF bytes so a retune is a single burst write
+    for (uint8_t i = 0; i < count; i++) {
+        scan->channels[i].frequency = frequencies[i];
+        lora_frequency_to_frf(frequencies[i], scan->channels[i].frf);
+    }
+    lora_scan_reset_stats(scan);
+
+    // Scanning relies on the explicit header for the packet length
+    lora_idle(ctx);
+    lora_write_register(ctx, REG_MODEM_CONFIG_1, lora_read_register(ctx, REG_MODEM_CONFIG_1) & 0xfe);
+    ctx->implicit_header_mode = 0;
+    lora_write_register(ctx, REG_IRQ_FLAGS, 0xff);
+
+    scan->running = true;
+    start_cad(scan);
+    return true;
+}
+
+void lora_scan_end(lora_scan_t *scan) {
+    scan->running = false;
+    scan->locked = false;
+    scan->resume = false;
+    lora_idle(scan->lora);
+    lora_write_register(scan->lora, REG_IRQ_FLAGS, 0xff);
+}
+
+int lora_scan_poll(lora_scan_t *scan) {
+    lora_ctx_t *ctx = scan->lora;
+
+    if (!scan->running) {
+        return 0;
+    }
+
+    if (scan->resume) {
+        scan->resume = false;
+        next_channel(scan);
+        return 0;
+    }
+
+    uint8_t irq_flags = lora_read_register(ctx, REG_IRQ_FLAGS);
+    lora_scan_channel_t *ch = &scan->channels[scan->current];
+
+    if (!scan->locked) {
+        if ((irq_flags & IRQ_CAD_DONE_MASK) == 0) {
+            return 0;
+        }
+
+        // Clear IRQ's
+        lora_write_register(ctx, REG_IRQ_FLAGS, irq_flags);
+        record_dwell(scan);
+        ch->cad_count++;
+
+        if (irq_flags & IRQ_CAD_DETECTED_MASK) {
+            // Lock onto this channel until the packet completes or times out
+            ch->detect_count++;
+            scan->locked = true;
+            lora_write_register(ctx, REG_FIFO_ADDR_PTR, 0);
+            if (ctx->timestamps_enabled) {
+                lora_write_register(ctx, REG_DIO_MAPPING_1, DIO0_RX_DONE); // DIO0 => RXDONE
+                ctx->dio0_timestamp_us = 0;
+            }
+            lora_write_register(ctx, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_SINGLE);
+        } else {
+            next_channel(scan);
+        }
+        return 0;
+    }
+
+    if (irq_flags & IRQ_RX_DONE_MASK) {
+        // Clear IRQ's
+        lora_write_register(ctx, REG_IRQ_FLAGS, irq_flags);
+        scan->locked = false;
+
+        if (irq_flags & IRQ_PAYLOAD_CRC_ERROR_MASK) {
+            ch->crc_error_count++;
+            if (ctx->stats) {
+                lora_stats_rx_crc_error(ctx->stats);
+            }
+            next_channel(scan);
+            return 0;
+        }
+
+        // Link quality and stats as lora_parse_packet keeps them; the RSSI
+        // offset follows the channel the packet came in on
+        ctx->packet_index = 0;
+        ctx->packet_timestamp_us = lora_take_event_timestamp(ctx);
+        ctx->config.frequency = ch->frequency;
+        lora_read_link_quality(ctx, &ctx->link);
+
+        if (ctx->require_payload_crc && ctx->config.crc_enabled && !ctx->link.crc_on_payload) {
+            if (ctx->stats) {
+                lora_stats_rx_header_error(ctx->stats);
+            }
+            next_channel(scan);
+            return 0;
+        }
+        if (ctx->stats) {
+            lora_stats_rx_ok(ctx->stats, &ctx->link);
+        }
+        ch->packet_count++;
+
+        int packet_length = lora_read_register(ctx, REG_RX_NB_BYTES);
+
+        // Set FIFO address to current RX address
+        lora_write_register(ctx, REG_FIFO_ADDR_PTR, lora_read_register(ctx, REG_FIFO_RX_CURRENT_ADDR));
+
+        scan->resume = true;
+        return packet_length;
+    }
+
+    if (irq_flags & IRQ_RX_TIMEOUT_MASK) {
+        // Clear IRQ's
+        lora_write_register(ctx, REG_IRQ_FLAGS, irq_flags);
+        scan->locked = false;
+        ch->timeout_count++;
+        if (ctx->stats) {
+            lora_stats_rx_timeout(ctx->stats);
+        }
+        next_channel(scan);
+    }
+
+    return 0;
+}
+
+uint8_t lora_scan_channel(const lora_scan_t *scan) {
+    return scan->current;
+}
+
+// Statistics
+void lora_scan_reset_stats(lora_scan_t *scan) {
+    for (uint8_t i = 0; i < scan->channel_count; i++) {
+        lora_scan_channel_t *ch = &scan->channels[i];
+        ch->cad_count = 0;
+        ch->detect_count = 0;
+        ch->packet_count = 0;
+        ch->crc_error_count = 0;
+        ch->timeout_count = 0;
+    }
+    scan->dwell_total_us = 0;
+    scan->dwell_count = 0;
+    scan->dwell_min_us = UINT32_MAX;
+    scan->dwell_max_us = 0;
+}
+
+uint32_t lora_scan_average_dwell_us(const lora_scan_t *scan) {
+    if (scan->dwell_count == 0) {
+        return 0;
+    }
+    return (uint32_t)(scan->dwell_total_us / scan->dwell_count);
+}
+
+void lora_scan_print_stats(lora_scan_t *scan) {
+    print_ctx_t *p = &scan->lora->print;
+
+    for (uint8_t i = 0; i < scan->channel_count; i++) {
+        const lora_scan_channel_t *ch = &scan->channels[i];
+        print_str(p, "ch ");
+        print_uchar(p, i, DEC);
+        print_str(p, " ");
+        print_ulong(p, ch->frequency, DEC);
+        print_str(p, " cad=");
+        print_ulong(p, ch->cad_count, DEC);
+        print_str(p, " det=");
+        print_ulong(p, ch->detect_count, DEC);
+        print_str(p, " pkt=");
+        print_ulong(p, ch->packet_count, DEC);
+        print_str(p, " crc=");
+        print_ulong(p, ch->crc_error_count, DEC);
+        print_str(p, " tmo=");
+        print_ulong(p, ch->timeout_count, DEC);
+        println(p);
+    }
+
+    print_str(p, "dwell us avg=");
+    print_ulong(p, lora_scan_average_dwell_us(scan), DEC);
+    print_str(p, " min=");
+    print_ulong(p, scan->dwell_count ? scan->dwell_min_us : 0, DEC);
+    print_str(p, " max=");
+    print_ulong(p, scan->dwell_max_us, DEC);
+    println(p);
+}
+
+// Private functions
+static void start_cad(lora_scan_t *scan) {
+    lora_ctx_t *ctx = scan->lora;
+
+    // The radio is back in standby after CAD, RX done or RX timeout
+    scan->dwell_start_us = time_us_64();
+    lora_set_frf(ctx, scan->channels[scan->current].frf);
+    lora_write_register(ctx, REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_CAD);
+}
+
+static void next_channel(lora_scan_t *scan) {
+    scan->current++;
+    if (scan->current >= scan->channel_count) {
+        scan->current = 0;
+    }
+    start_cad(scan);
+}
+
+static void record_dwell(lora_scan_t *scan) {
+    uint32_t dwell = (uint32_t)(time_us_64() - scan->dwell_start_us);
+
+    scan->dwell_total_us += dwell;
+    scan->dwell_count++;
+    if (dwell < scan->dwell_min_us) {
+        scan->dwell_min_us = dwell;
+    }
+    if (dwell > scan->dwell_max_us) {
+        scan->dwell_max_us = dwell;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef LORA_SCAN_H
+#define LORA_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lora.h"
+
+// Maximum number of channels in a scan list
+#ifndef LORA_SCAN_MAX_CHANNELS
+#define LORA_SCAN_MAX_CHANNELS 16
+#endif
+
+// Per-channel state and hit statistics
+typedef struct {
+    uint32_t frequency;
+    uint8_t frf[3];             // Precomputed REG_FRF_* bytes
+    uint32_t cad_count;         // CAD cycles run on this channel
+    uint32_t detect_count;      // Preambles detected
+    uint32_t packet_count;      // Packets received
+    uint32_t crc_error_count;   // Packets dropped with a payload CRC error
+    uint32_t timeout_count;     // Detections that never produced a packet
+} lora_scan_channel_t;
+
+// Scanning receiver context
+typedef struct {
+    lora_ctx_t *lora;
+    lora_scan_channel_t channels[LORA_SCAN_MAX_CHANNELS];
+    uint8_t channel_count;
+    uint8_t current;            // Channel being scanned or locked
+    bool running;
+    bool locked;                // Preamble detected, receiving on current
+    bool resume;                // Packet delivered, resume on next poll
+    uint64_t dwell_start_us;    // Start of the current retune + CAD
+    uint64_t dwell_total_us;
+    uint32_t dwell_count;
+    uint32_t dwell_min_us;
+    uint32_t dwell_max_us;
+} lora_scan_t;
+
+// Precompute the channel table and start scanning
+bool lora_scan_begin(lora_scan_t *scan, lora_ctx_t *ctx, const uint32_t *frequencies, uint8_t count);
+
+// Stop scanning and put the radio in standby
+void lora_scan_end(lora_scan_t *scan);
+
+// Advance the scan; returns the packet length when a packet was received.
+// The packet must be read with lora_read()/lora_read_bytes() before the
+// next call, which resumes scanning on the following channel.
+int lora_scan_poll(lora_scan_t *scan);
+
+// Index of the channel the last packet was received on
+uint8_t lora_scan_channel(const lora_scan_t *scan);
+
+// Statistics
+void lora_scan_reset_stats(lora_scan_t *scan);
+uint32_t lora_scan_average_dwell_us(const lora_scan_t *scan);
+void lora_scan_print_stats(lora_scan_t *scan);
+
+#endif // LORA_SCAN_H
@@ -0,0 +1,296 @@
+#include "lora_stats.h"
+#include <string.h>
+
+// Export cursor
+typedef struct {
+    uint8_t *buffer;
+    size_t size;
+    size_t offset;
+} export_t;
+
+// Forward declarations of static functions
+static void rotate(lora_stats_t *stats, uint64_t now);
+static void rotate_hist(lora_stats_hist_t *hist);
+static void rotate_link(lora_stats_link_t *link);
+static void record_link(lora_stats_link_t *link, const lora_link_quality_t *quality);
+static void record(lora_stats_hist_t *hist, int32_t value, int32_t min, int32_t step);
+static lora_stats_peer_t *find_peer(lora_stats_t *stats, uint8_t address, uint64_t now);
+static bool put_varint(export_t *out, uint32_t value);
+static bool put_link(export_t *out, const lora_stats_link_t *link);
+static void print_hist(print_ctx_t *p, const char *name, const lora_stats_hist_t *hist);
+
+void lora_stats_init(lora_stats_t *stats, lora_ctx_t *ctx) {
+    lora_stats_reset(stats);
+    ctx->stats = stats;
+}
+
+void lora_stats_reset(lora_stats_t *stats) {
+    memset(stats, 0, sizeof(lora_stats_t));
+    stats->window_start_us = time_us_64();
+}
+
+// Event hooks
+void lora_stats_rx_ok(lora_stats_t *stats, const lora_link_quality_t *link) {
+    rotate(stats, time_us_64());
+    stats->rx_ok++;
+    record_link(&stats->link, link);
+}
+
+void lora_stats_rx_crc_error(lora_stats_t *stats) {
+    stats->rx_crc_errors++;
+}
+
+void lora_stats_rx_header_error(lora_stats_t *stats) {
+    stats->rx_header_errors++;
+}
+
+void lora_stats_rx_timeout(lora_stats_t *stats) {
+    stats->rx_timeouts++;
+}
+
+void lora_stats_tx_done(lora_stats_t *stats, uint32_t airtime_us) {
+    stats->tx_done++;
+    stats->tx_airtime_us += airtime_us;
+}
+
+void lora_stats_tx_timeout(lora_stats_t *stats) {
+    stats->tx_timeouts++;
+}
+
+// Per-peer statistics
+void lora_stats_peer_rx(lora_stats_t *stats, uint8_t address, const lora_link_quality_t *link) {
+    uint64_t now = time_us_64();
+    lora_stats_peer_t *peer = find_peer(stats, address, now);
+
+    rotate(stats, now);
+    peer->rx_ok++;
+    peer->last_heard_us = now;
+    record_link(&peer->link, link);
+}
+
+const lora_stats_peer_t *lora_stats_peer(const lora_stats_t *stats, uint8_t address) {
+    for (int i = 0; i < LORA_STATS_MAX_PEERS; i++) {
+        if (stats->peers[i].used && stats->peers[i].address == address) {
+            return &stats->peers[i];
+        }
+    }
+    return NULL;
+}
+
+uint16_t lora_stats_per_permille(const lora_stats_t *stats) {
+    uint32_t errors = stats->rx_crc_errors + stats->rx_header_errors;
+    uint32_t total = stats->rx_ok + errors;
+
+    return total ? (uint16_t)(((uint64_t)errors * 1000) / total) : 0;
+}
+
+uint32_t lora_stats_hist_count(const lora_stats_hist_t *hist, int bin) {
+    if (bin < 0 || bin >= LORA_STATS_BINS) {
+        return 0;
+    }
+    return (uint32_t)hist->current[bin] + hist->previous[bin];
+}
+
+// Export layout: version, counters, bin layout, totals histograms, peer
+// count, then per peer: address, rx_ok, histograms. Every integer is an
+// unsigned LEB128 varint; bin minimums are sent offset by 0x8000.
+size_t lora_stats_export(const lora_stats_t *stats, uint8_t *buffer, size_t size) {
+    const uint32_t header[] = {
+        LORA_STATS_EXPORT_VERSION,
+        stats->rx_ok, stats->rx_crc_errors, stats->rx_header_errors, stats->rx_timeouts,
+        stats->tx_done, stats->tx_timeouts, (uint32_t)(stats->tx_airtime_us / 1000), stats->windows,
+        LORA_STATS_BINS,
+        LORA_STATS_RSSI_MIN + 0x8000, LORA_STATS_RSSI_STEP,
+        LORA_STATS_SNR_MIN + 0x8000, LORA_STATS_SNR_STEP,
+        LORA_STATS_FERR_MIN + 0x8000, LORA_STATS_FERR_STEP,
+    };
+    export_t out = { buffer, size, 0 };
+
+    for (size_t i = 0; i < sizeof(header) / sizeof(header[0]); i++) {
+        if (!put_varint(&out, header[i])) {
+            return 0;
+        }
+    }
+    if (!put_link(&out, &stats->link)) {
+        return 0;
+    }
+
+    // Peer count is patched in once we know how many fit; it is one byte
+    size_t count_offset = out.offset;
+    if (!put_varint(&out, 0)) {
+        return 0;
+    }
+
+    uint8_t peers = 0;
+    for (int i = 0; i < LORA_STATS_MAX_PEERS; i++) {
+        const lora_stats_peer_t *peer = &stats->peers[i];
+        if (!peer->used) {
+            continue;
+        }
+
+        size_t start = out.offset;
+        if (!put_varint(&out, peer->address) || !put_varint(&out, peer->rx_ok) || !put_link(&out, &peer->link)) {
+            out.offset = start;
+            break;
+        }
+        peers++;
+    }
+
+    buffer[count_offset] = peers;
+    return out.offset;
+}
+
+void lora_stats_print(const lora_stats_t *stats, print_ctx_t *p) {
+    print_str(p, "stats rx_ok=");
+    print_ulong(p, stats->rx_ok, DEC);
+    print_str(p, " crc=");
+    print_ulong(p, stats->rx_crc_errors, DEC);
+    print_str(p, " hdr=");
+    print_ulong(p, stats->rx_header_errors, DEC);
+    print_str(p, " rx_to=");
+    print_ulong(p, stats->rx_timeouts, DEC);
+    print_str(p, " per=");
+    print_uint(p, lora_stats_per_permille(stats), DEC);
+    print_str(p, "/1000 tx=");
+    print_ulong(p, stats->tx_done, DEC);
+    print_str(p, " tx_to=");
+    print_ulong(p, stats->tx_timeouts, DEC);
+    print_str(p, " airtime_us=");
+    print_ulonglong(p, stats->tx_airtime_us, DEC);
+    println(p);
+
+    print_hist(p, "  rssi", &stats->link.rssi);
+    print_hist(p, "  snr ", &stats->link.snr);
+    print_hist(p, "  ferr", &stats->link.freq_error);
+
+    for (int i = 0; i < LORA_STATS_MAX_PEERS; i++) {
+        const lora_stats_peer_t *peer = &stats->peers[i];
+        if (!peer->used) {
+            continue;
+        }
+        print_str(p, "  peer ");
+        print_uchar(p, peer->address, DEC);
+        print_str(p, " rx=");
+        print_ulong(p, peer->rx_ok, DEC);
+        println(p);
+        print_hist(p, "    rssi", &peer->link.rssi);
+        print_hist(p, "    snr ", &peer->link.snr);
+        print_hist(p, "    ferr", &peer->link.freq_error);
+    }
+}
+
+// Private functions
+
+// Start a new generation once per window; the old one stays visible
+static void rotate(lora_stats_t *stats, uint64_t now) {
+    if (now - stats->window_start_us < LORA_STATS_WINDOW_US) {
+        return;
+    }
+
+    rotate_link(&stats->link);
+    for (int i = 0; i < LORA_STATS_MAX_PEERS; i++) {
+        if (stats->peers[i].used) {
+            rotate_link(&stats->peers[i].link);
+        }
+    }
+
+    // A silent spell longer than two windows leaves nothing to keep
+    if (now - stats->window_start_us >= 2 * LORA_STATS_WINDOW_US) {
+        rotate_link(&stats->link);
+        for (int i = 0; i < LORA_STATS_MAX_PEERS; i++) {
+            rotate_link(&stats->peers[i].link);
+        }
+    }
+
+    stats->window_start_us = now;
+    stats->windows++;
+}
+
+static void rotate_hist(lora_stats_hist_t *hist) {
+    memcpy(hist->previous, hist->current, sizeof(hist->previous));
+    memset(hist->current, 0, sizeof(hist->current));
+}
+
+static void rotate_link(lora_stats_link_t *link) {
+    rotate_hist(&link->rssi);
+    rotate_hist(&link->snr);
+    rotate_hist(&link->freq_error);
+}
+
+static void record_link(lora_stats_link_t *link, const lora_link_quality_t *quality) {
+    record(&link->rssi, quality->rssi_dbm, LORA_STATS_RSSI_MIN, LORA_STATS_RSSI_STEP);
+    record(&link->snr, quality->snr_q, LORA_STATS_SNR_MIN, LORA_STATS_SNR_STEP);
+    record(&link->freq_error, quality->frequency_error_hz, LORA_STATS_FERR_MIN, LORA_STATS_FERR_STEP);
+}
+
+static void record(lora_stats_hist_t *hist, int32_t value, int32_t min, int32_t step) {
+    int32_t bin = value < min ? 0 : (value - min) / step;
+
+    if (bin >= LORA_STATS_BINS) {
+        bin = LORA_STATS_BINS - 1;
+    }
+    if (hist->current[bin] < UINT16_MAX) {
+        hist->current[bin]++;
+    }
+}
+
+// Existing entry, a free one, or the least recently heard
+static lora_stats_peer_t *find_peer(lora_stats_t *stats, uint8_t address, uint64_t now) {
+    lora_stats_peer_t *victim = &stats->peers[0];
+
+    for (int i = 0; i < LORA_STATS_MAX_PEERS; i++) {
+        lora_stats_peer_t *peer = &stats->peers[i];
+        if (peer->used && peer->address == address) {
+            return peer;
+        }
+        if (!peer->used) {
+            if (victim->used) {
+                victim = peer;
+            }
+        } else if (victim->used && peer->last_heard_us < victim->last_heard_us) {
+            victim = peer;
+        }
+    }
+
+    memset(victim, 0, sizeof(lora_stats_peer_t));
+    victim->used = true;
+    victim->address = address;
+    victim->last_heard_us = now;
+    return victim;
+}
+
+// Unsigned LEB128; false once the buffer is exhausted
+static bool put_varint(export_t *out, uint32_t value) {
+    do {
+        if (out->offset >= out->size) {
+            return false;
+        }
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        out->buffer[out->offset++] = byte | (value ? 0x80 : 0);
+    } while (value);
+
+    return true;
+}
+
+static bool put_link(export_t *out, const lora_stats_link_t *link) {
+    const lora_stats_hist_t *hists[] = { &link->rssi, &link->snr, &link->freq_error };
+
+    for (size_t h = 0; h < 3; h++) {
+        for (int bin = 0; bin < LORA_STATS_BINS; bin++) {
+            if (!put_varint(out, lora_stats_hist_count(hists[h], bin))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void print_hist(print_ctx_t *p, const char *name, const lora_stats_hist_t *hist) {
+    print_str(p, name);
+    for (int bin = 0; bin < LORA_STATS_BINS; bin++) {
+        print_char(p, ' ');
+        print_ulong(p, lora_stats_hist_count(hist, bin), DEC);
+    }
+    println(p);
+}
@@ -0,0 +1,96 @@
+#ifndef LORA_STATS_H
+#define LORA_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lora.h"
+
+// Peers with their own histograms; the least recently heard is replaced
+#ifndef LORA_STATS_MAX_PEERS
+#define LORA_STATS_MAX_PEERS    8
+#endif
+
+// Histogram generations rotate after this long, so the histograms cover
+// between one and two windows of traffic
+#ifndef LORA_STATS_WINDOW_US
+#define LORA_STATS_WINDOW_US    3600000000ULL
+#endif
+
+// Fixed bins: value below min goes to bin 0, above the range to the last bin
+#define LORA_STATS_BINS         16
+#define LORA_STATS_RSSI_MIN     (-140)  // dBm
+#define LORA_STATS_RSSI_STEP    8
+#define LORA_STATS_SNR_MIN      (-80)   // Quarter dB (-20 dB)
+#define LORA_STATS_SNR_STEP     8       // 2 dB
+#define LORA_STATS_FERR_MIN     (-20000)    // Hz
+#define LORA_STATS_FERR_STEP    2500
+
+// Export format version
+#define LORA_STATS_EXPORT_VERSION 1
+
+// Two-generation fixed-bin histogram
+typedef struct {
+    uint16_t current[LORA_STATS_BINS];
+    uint16_t previous[LORA_STATS_BINS];
+} lora_stats_hist_t;
+
+typedef struct {
+    lora_stats_hist_t rssi;
+    lora_stats_hist_t snr;
+    lora_stats_hist_t freq_error;
+} lora_stats_link_t;
+
+typedef struct {
+    bool used;
+    uint8_t address;
+    uint32_t rx_ok;
+    uint64_t last_heard_us;
+    lora_stats_link_t link;
+} lora_stats_peer_t;
+
+// Packet accounting for one radio
+typedef struct lora_stats {
+    uint32_t rx_ok;
+    uint32_t rx_crc_errors;
+    uint32_t rx_header_errors;  // Dropped by lora_require_payload_crc
+    uint32_t rx_timeouts;
+    uint32_t tx_done;
+    uint32_t tx_timeouts;
+    uint64_t tx_airtime_us;
+
+    uint64_t window_start_us;
+    uint32_t windows;           // Generation rotations so far
+    lora_stats_link_t link;     // All received packets
+    lora_stats_peer_t peers[LORA_STATS_MAX_PEERS];
+} lora_stats_t;
+
+// Attach to ctx; the driver then reports packet outcomes itself
+void lora_stats_init(lora_stats_t *stats, lora_ctx_t *ctx);
+void lora_stats_reset(lora_stats_t *stats);
+
+// Event hooks (called by lora.c when attached)
+void lora_stats_rx_ok(lora_stats_t *stats, const lora_link_quality_t *link);
+void lora_stats_rx_crc_error(lora_stats_t *stats);
+void lora_stats_rx_header_error(lora_stats_t *stats);
+void lora_stats_rx_timeout(lora_stats_t *stats);
+void lora_stats_tx_done(lora_stats_t *stats, uint32_t airtime_us);
+void lora_stats_tx_timeout(lora_stats_t *stats);
+
+// Per-peer link quality, for protocols that know the sender
+void lora_stats_peer_rx(lora_stats_t *stats, uint8_t address, const lora_link_quality_t *link);
+const lora_stats_peer_t *lora_stats_peer(const lora_stats_t *stats, uint8_t address);
+
+// Packet error rate over received frames, in permille
+uint16_t lora_stats_per_permille(const lora_stats_t *stats);
+
+// Rolling count of a bin (both generations)
+uint32_t lora_stats_hist_count(const lora_stats_hist_t *hist, int bin);
+
+// Compact binary export (varint encoded). Peers are appended while they
+// fit; returns the bytes written, or 0 if not even the totals fit.
+size_t lora_stats_export(const lora_stats_t *stats, uint8_t *buffer, size_t size);
+
+void lora_stats_print(const lora_stats_t *stats, print_ctx_t *print);
+
+#endif // LORA_STATS_H
@@ -0,0 +1,167 @@
+#include "lora_sweep.h"
+#include <string.h>
+
+// Forward declarations of static functions
+static void measure(lora_sweep_t *sweep, lora_sweep_step_t *step);
+static bool quieter(const lora_sweep_t *sweep, uint16_t a, uint16_t b);
+static bool spaced(const lora_sweep_t *sweep, const uint16_t *picked, size_t count, uint16_t index,
+                   uint32_t min_spacing_hz);
+
+bool lora_sweep_begin(lora_sweep_t *sweep, lora_ctx_t *ctx, uint32_t start_hz, uint32_t stop_hz, uint32_t step_hz) {
+    if (!ctx || step_hz == 0 || stop_hz < start_hz || (stop_hz - start_hz) / step_hz + 1 > LORA_SWEEP_MAX_STEPS) {
+        return false;
+    }
+
+    memset(sweep, 0, sizeof(lora_sweep_t));
+    sweep->lora = ctx;
+    sweep->step_count = (uint16_t)((stop_hz - start_hz) / step_hz + 1);
+
+    // Precompute FRF bytes so a retune is a single burst write
+    for (uint16_t i = 0; i < sweep->step_count; i++) {
+        lora_sweep_step_t *step = &sweep->steps[i];
+        step->frequency = start_hz + i * step_hz;
+        step->rssi_offset = (uint8_t)lora_rssi_offset(step->frequency);
+        lora_frequency_to_frf(step->frequency, step->frf);
+    }
+    lora_sweep_reset(sweep);
+    return true;
+}
+
+void lora_sweep_reset(lora_sweep_t *sweep) {
+    for (uint16_t i = 0; i < sweep->step_count; i++) {
+        lora_sweep_step_t *step = &sweep->steps[i];
+        step->min_dbm = INT16_MAX;
+        step->max_dbm = INT16_MIN;
+        step->sum_dbm = 0;
+        step->samples = 0;
+    }
+    sweep->sweeps = 0;
+}
+
+uint32_t lora_sweep_run(lora_sweep_t *sweep) {
+    lora_ctx_t *ctx = sweep->lora;
+    uint64_t start_us = time_us_64();
+
+    for (uint16_t i = 0; i < sweep->step_count; i++) {
+        measure(sweep, &sweep->steps[i]);
+    }
+
+    lora_idle(ctx);
+    lora_set_frequency(ctx, ctx->config.frequency);
+
+    sweep->sweeps++;
+    sweep->last_duration_us = (uint32_t)(time_us_64() - start_us);
+    return sweep->last_duration_us;
+}
+
+int16_t lora_sweep_average_dbm(const lora_sweep_t *sweep, uint16_t index) {
+    const lora_sweep_step_t *step = &sweep->steps[index];
+
+    if (step->samples == 0) {
+        return INT16_MIN;
+    }
+    int32_t sum = step->sum_dbm;
+    int32_t n = (int32_t)step->samples;
+    return (int16_t)((sum - n / 2) / n);
+}
+
+size_t lora_sweep_quietest(const lora_sweep_t *sweep, uint16_t *indices, size_t count, uint32_t min_spacing_hz) {
+    size_t picked = 0;
+
+    // Repeated minimum search; the table is small and this keeps no scratch
+    while (picked < count) {
+        int best = -1;
+        for (uint16_t i = 0; i < sweep->step_count; i++) {
+            if (sweep->steps[i].samples == 0 || !spaced(sweep, indices, picked, i, min_spacing_hz)) {
+                continue;
+            }
+            if (best < 0 || quieter(sweep, i, (uint16_t)best)) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        indices[picked++] = (uint16_t)best;
+    }
+    return picked;
+}
+
+void lora_sweep_print(lora_sweep_t *sweep) {
+    print_ctx_t *p = &sweep->lora->print;
+
+    print_str(p, "sweep steps=");
+    print_uint(p, sweep->step_count, DEC);
+    print_str(p, " sweeps=");
+    print_ulong(p, sweep->sweeps, DEC);
+    print_str(p, " last_us=");
+    print_ulong(p, sweep->last_duration_us, DEC);
+    println(p);
+
+    for (uint16_t i = 0; i < sweep->step_count; i++) {
+        const lora_sweep_step_t *step = &sweep->steps[i];
+        if (step->samples == 0) {
+            continue;
+        }
+        print_ulong(p, step->frequency, DEC);
+        print_str(p, " min=");
+        print_int(p, step->min_dbm, DEC);
+        print_str(p, " avg=");
+        print_int(p, lora_sweep_average_dbm(sweep, i), DEC);
+        print_str(p, " max=");
+        print_int(p, step->max_dbm, DEC);
+        println(p);
+    }
+}
+
+// Private functions
+
+// Retune in standby, enter RX, let the PLL and RSSI settle, then sample
+static void measure(lora_sweep_t *sweep, lora_sweep_step_t *step) {
+    lora_ctx_t *ctx = sweep->lora;
+
+    lora_idle(ctx);
+    lora_set_frf(ctx, step->frf);
+    lora_set_mode(ctx, MODE_RX_CONTINUOUS);
+    sleep_us(LORA_SWEEP_SETTLE_US);
+
+    for (int s = 0; s < LORA_SWEEP_SAMPLES; s++) {
+        if (s > 0) {
+            sleep_us(LORA_SWEEP_SAMPLE_INTERVAL_US);
+        }
+
+        int16_t rssi = (int16_t)(lora_read_register(ctx, REG_RSSI_VALUE) - step->rssi_offset);
+        if (rssi < step->min_dbm) {
+            step->min_dbm = rssi;
+        }
+        if (rssi > step->max_dbm) {
+            step->max_dbm = rssi;
+        }
+        step->sum_dbm += rssi;
+        step->samples++;
+    }
+}
+
+static bool quieter(const lora_sweep_t *sweep, uint16_t a, uint16_t b) {
+    int16_t avg_a = lora_sweep_average_dbm(sweep, a);
+    int16_t avg_b = lora_sweep_average_dbm(sweep, b);
+
+    if (avg_a != avg_b) {
+        return avg_a < avg_b;
+    }
+    return sweep->steps[a].max_dbm < sweep->steps[b].max_dbm;
+}
+
+static bool spaced(const lora_sweep_t *sweep, const uint16_t *picked, size_t count, uint16_t index,
+                   uint32_t min_spacing_hz) {
+    uint32_t frequency = sweep->steps[index].frequency;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t other = sweep->steps[picked[i]].frequency;
+        uint32_t distance = frequency > other ? frequency - other : other - frequency;
+        if (distance < min_spacing_hz || picked[i] == index) {
+            return false;
+        }
+    }
+    return true;
+}
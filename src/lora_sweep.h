@@ -0,0 +1,65 @@
+#ifndef LORA_SWEEP_H
+#define LORA_SWEEP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lora.h"
+
+// Steps in one sweep (863-870 MHz at 125 kHz is 57, 902-928 MHz at 200 kHz is 131)
+#ifndef LORA_SWEEP_MAX_STEPS
+#define LORA_SWEEP_MAX_STEPS        160
+#endif
+
+// PLL lock and RSSI settling after entering RX on a new frequency
+#ifndef LORA_SWEEP_SETTLE_US
+#define LORA_SWEEP_SETTLE_US        300
+#endif
+
+// RSSI reads per step and the gap between them
+#ifndef LORA_SWEEP_SAMPLES
+#define LORA_SWEEP_SAMPLES          8
+#endif
+#ifndef LORA_SWEEP_SAMPLE_INTERVAL_US
+#define LORA_SWEEP_SAMPLE_INTERVAL_US 50
+#endif
+
+// Occupancy of one frequency, accumulated over all sweeps since reset
+typedef struct {
+    uint32_t frequency;
+    uint8_t frf[3];             // Precomputed REG_FRF_* bytes
+    uint8_t rssi_offset;        // Per-port RSSI register offset
+    int16_t min_dbm;
+    int16_t max_dbm;
+    int32_t sum_dbm;
+    uint32_t samples;
+} lora_sweep_step_t;
+
+typedef struct {
+    lora_ctx_t *lora;
+    lora_sweep_step_t steps[LORA_SWEEP_MAX_STEPS];
+    uint16_t step_count;
+    uint32_t sweeps;
+    uint32_t last_duration_us;
+} lora_sweep_t;
+
+// Precompute the step table from start to stop inclusive
+bool lora_sweep_begin(lora_sweep_t *sweep, lora_ctx_t *ctx, uint32_t start_hz, uint32_t stop_hz, uint32_t step_hz);
+
+// Clear the occupancy statistics
+void lora_sweep_reset(lora_sweep_t *sweep);
+
+// One pass over the range. The radio is left in standby on its configured
+// frequency; returns the time taken.
+uint32_t lora_sweep_run(lora_sweep_t *sweep);
+
+int16_t lora_sweep_average_dbm(const lora_sweep_t *sweep, uint16_t index);
+
+// Pick up to count quietest steps by average, then peak, RSSI, at least
+// min_spacing_hz apart. Returns the number of indices written.
+size_t lora_sweep_quietest(const lora_sweep_t *sweep, uint16_t *indices, size_t count, uint32_t min_spacing_hz);
+
+// Occupancy table on the radio's print context
+void lora_sweep_print(lora_sweep_t *sweep);
+
+#endif // LORA_SWEEP_H
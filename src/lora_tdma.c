@@ -0,0 +1,287 @@
+#include "lora_tdma.h"
+#include <string.h>
+
+// Forward declarations of static functions
+static int coordinator_poll(lora_tdma_t *tdma, uint64_t now);
+static int node_poll(lora_tdma_t *tdma, uint64_t now);
+static int receive_frame(lora_tdma_t *tdma);
+static bool tx_busy(lora_tdma_t *tdma);
+static uint64_t superframe_local_us(const lora_tdma_t *tdma);
+
+bool lora_tdma_begin(lora_tdma_t *tdma, lora_ctx_t *ctx, const lora_tdma_config_t *config, int slot) {
+    memset(tdma, 0, sizeof(lora_tdma_t));
+    tdma->lora = ctx;
+    tdma->config = *config;
+    tdma->coordinator = (slot == LORA_TDMA_COORDINATOR);
+    tdma->slot = tdma->coordinator ? 0 : (uint8_t)slot;
+
+    if (config->max_payload > LORA_TDMA_MAX_PAYLOAD || config->slot_count == 0) {
+        LORA_LOG_ERROR(ctx, "TDMA: invalid configuration");
+        return false;
+    }
+    if (!tdma->coordinator && (slot < 0 || slot >= config->slot_count)) {
+        LORA_LOG_ERROR(ctx, "TDMA: slot %d out of range", slot);
+        return false;
+    }
+
+    // Beacons and data frames always use the explicit header
+    tdma->beacon_airtime_us = lora_time_on_air_us(&ctx->config, false, LORA_TDMA_BEACON_LENGTH);
+    tdma->slot_airtime_us = lora_time_on_air_us(&ctx->config, false, LORA_TDMA_DATA_HEADER + config->max_payload);
+
+    // Worst-case error accumulated over one superframe without drift correction
+    tdma->guard_us = config->min_guard_us + (uint32_t)(((uint64_t)config->superframe_us * config->max_drift_ppm) / 1000000);
+    tdma->slot_us = tdma->slot_airtime_us + 2 * tdma->guard_us;
+
+    uint64_t used = (uint64_t)tdma->beacon_airtime_us + 2 * tdma->guard_us + (uint64_t)config->slot_count * tdma->slot_us;
+    if (used > config->superframe_us) {
+        LORA_LOG_ERROR(ctx, "TDMA: %d slots need %ld us, superframe is %ld us",
+                       config->slot_count, (long)used, (long)config->superframe_us);
+        return false;
+    }
+
+    if (tdma->coordinator) {
+        // The coordinator is the time reference; first beacon shortly
+        tdma->synced = true;
+        tdma->drift_valid = true;
+        tdma->epoch_us = time_us_64() + 2 * LORA_TDMA_LEAD_US - config->superframe_us;
+    }
+
+    lora_idle(ctx);
+    return true;
+}
+
+int lora_tdma_poll(lora_tdma_t *tdma) {
+    uint64_t now = time_us_64();
+
+    if (tdma->coordinator) {
+        return coordinator_poll(tdma, now);
+    }
+    return node_poll(tdma, now);
+}
+
+bool lora_tdma_send(lora_tdma_t *tdma, const uint8_t *buffer, uint8_t size) {
+    if (tdma->coordinator || tdma->tx_pending || size > tdma->config.max_payload) {
+        return false;
+    }
+
+    memcpy(tdma->tx_buffer, buffer, size);
+    tdma->tx_length = size;
+    tdma->tx_pending = true;
+    return true;
+}
+
+uint8_t lora_tdma_rx_slot(const lora_tdma_t *tdma) {
+    return tdma->rx_slot;
+}
+
+// Clock discipline
+void lora_tdma_on_beacon(lora_tdma_t *tdma, uint64_t rx_done_us, uint16_t seq) {
+    // The beacon was keyed up exactly at the coordinator's superframe start
+    uint64_t epoch = rx_done_us - lora_tdma_to_local_us(tdma, tdma->beacon_airtime_us);
+
+    if (tdma->synced) {
+        uint16_t elapsed = seq - tdma->sync_seq;
+
+        if (elapsed > 0) {
+            // Prediction error feeds the guard time
+            uint64_t predicted = tdma->sync_epoch_us + elapsed * superframe_local_us(tdma);
+            int64_t error = (int64_t)(epoch - predicted);
+            uint32_t abs_error = (uint32_t)(error < 0 ? -error : error);
+            tdma->jitter_us = (3 * tdma->jitter_us + abs_error) / 4;
+
+            // Measured local superframe length against the nominal one
+            int64_t period = (int64_t)(epoch - tdma->sync_epoch_us) / elapsed;
+            int64_t nominal = tdma->config.superframe_us;
+            int32_t measured_ppb = (int32_t)(((period - nominal) * 1000000000LL) / nominal);
+
+            if (tdma->drift_valid) {
+                tdma->drift_ppb += (measured_ppb - tdma->drift_ppb) / 4;
+            } else {
+                tdma->drift_ppb = measured_ppb;
+                tdma->drift_valid = true;
+            }
+        }
+    }
+
+    tdma->synced = true;
+    tdma->missed = 0;
+    tdma->epoch_us = epoch;
+    tdma->sync_epoch_us = epoch;
+    tdma->beacon_seq = seq;
+    tdma->sync_seq = seq;
+    tdma->stats.beacons_rx++;
+}
+
+// Timing error a node must allow for after elapsed_us without a beacon
+uint32_t lora_tdma_required_guard_us(const lora_tdma_t *tdma, uint64_t elapsed_us) {
+    uint32_t ppm = tdma->drift_valid ? LORA_TDMA_DRIFT_MARGIN_PPM : tdma->config.max_drift_ppm;
+
+    return tdma->config.min_guard_us + 2 * tdma->jitter_us + (uint32_t)((elapsed_us * ppm) / 1000000);
+}
+
+// Scale a coordinator time interval to the local clock
+uint64_t lora_tdma_to_local_us(const lora_tdma_t *tdma, uint64_t coordinator_us) {
+    return coordinator_us + (int64_t)coordinator_us * tdma->drift_ppb / 1000000000LL;
+}
+
+// Local TX time for a slot: start of the slot plus one guard
+uint64_t lora_tdma_slot_tx_us(const lora_tdma_t *tdma, uint64_t epoch_us, uint8_t slot) {
+    uint64_t offset = (uint64_t)tdma->beacon_airtime_us + 2 * tdma->guard_us + (uint64_t)slot * tdma->slot_us;
+
+    return epoch_us + lora_tdma_to_local_us(tdma, offset);
+}
+
+// Private functions
+static int coordinator_poll(lora_tdma_t *tdma, uint64_t now) {
+    lora_ctx_t *ctx = tdma->lora;
+    uint64_t next_epoch = tdma->epoch_us + tdma->config.superframe_us;
+
+    if (tx_busy(tdma)) {
+        return 0;
+    }
+
+    if (now + LORA_TDMA_LEAD_US >= next_epoch) {
+        uint8_t beacon[LORA_TDMA_BEACON_LENGTH];
+        uint16_t seq = tdma->beacon_seq + 1;
+
+        beacon[0] = LORA_TDMA_BEACON;
+        beacon[1] = tdma->config.network_id;
+        beacon[2] = (uint8_t)(seq >> 0);
+        beacon[3] = (uint8_t)(seq >> 8);
+
+        lora_begin_packet(ctx, false);
+        lora_write(ctx, beacon, sizeof(beacon));
+        if (lora_end_packet_at(ctx, next_epoch, true)) {
+            tdma->stats.beacons_tx++;
+            tdma->tx_active = true;
+        }
+
+        // Keep the superframe grid even if this beacon was late
+        tdma->epoch_us = next_epoch;
+        tdma->beacon_seq = seq;
+        return 0;
+    }
+
+    return receive_frame(tdma);
+}
+
+static int node_poll(lora_tdma_t *tdma, uint64_t now) {
+    lora_ctx_t *ctx = tdma->lora;
+
+    if (!tdma->synced) {
+        // Listen until a beacon arrives
+        return receive_frame(tdma);
+    }
+
+    if (tx_busy(tdma)) {
+        return 0;
+    }
+
+    // Transmit in the owned slot of the current superframe
+    if (tdma->tx_pending) {
+        uint64_t tx_at = lora_tdma_slot_tx_us(tdma, tdma->epoch_us, tdma->slot);
+
+        if (now < tx_at && now + LORA_TDMA_LEAD_US >= tx_at) {
+            uint32_t guard = lora_tdma_required_guard_us(tdma, tx_at - tdma->sync_epoch_us);
+
+            if (guard > tdma->guard_us) {
+                // Timing too uncertain to stay inside the slot; wait for a beacon
+                tdma->stats.slots_skipped++;
+                tdma->tx_pending = false;
+                return 0;
+            }
+
+            uint8_t header[LORA_TDMA_DATA_HEADER] = { LORA_TDMA_DATA, tdma->config.network_id, tdma->slot };
+
+            lora_begin_packet(ctx, false);
+            lora_write(ctx, header, sizeof(header));
+            lora_write(ctx, tdma->tx_buffer, tdma->tx_length);
+            if (lora_end_packet_at(ctx, tx_at, true)) {
+                tdma->stats.frames_tx++;
+                tdma->tx_active = true;
+                tdma->tx_pending = false;
+            }
+            return 0;
+        }
+    }
+
+    // Beacon window around the predicted start of the next superframe
+    uint64_t next_epoch = tdma->epoch_us + superframe_local_us(tdma);
+    uint32_t guard = lora_tdma_required_guard_us(tdma, next_epoch - tdma->sync_epoch_us);
+
+    if (now + guard < next_epoch) {
+        return 0;
+    }
+
+    uint16_t seq = tdma->beacon_seq;
+    int length = receive_frame(tdma);
+    if (tdma->beacon_seq != seq) {
+        return length;
+    }
+
+    if (now > next_epoch + lora_tdma_to_local_us(tdma, tdma->beacon_airtime_us) + guard) {
+        // Beacon missed: coast on the predicted epoch
+        tdma->stats.beacons_missed++;
+        tdma->epoch_us = next_epoch;
+        tdma->beacon_seq++;
+        lora_idle(ctx);
+
+        if (++tdma->missed > LORA_TDMA_MAX_MISSED) {
+            tdma->synced = false;
+            tdma->drift_valid = false;
+            tdma->stats.sync_lost++;
+        }
+    }
+
+    return length;
+}
+
+static int receive_frame(lora_tdma_t *tdma) {
+    lora_ctx_t *ctx = tdma->lora;
+    uint8_t header[LORA_TDMA_BEACON_LENGTH];
+
+    int length = lora_parse_packet(ctx, 0);
+    if (length < LORA_TDMA_DATA_HEADER) {
+        return 0;
+    }
+
+    lora_read_bytes(ctx, header, LORA_TDMA_DATA_HEADER);
+    if (header[1] != tdma->config.network_id) {
+        return 0;
+    }
+
+    if (header[0] == LORA_TDMA_BEACON && length == LORA_TDMA_BEACON_LENGTH) {
+        if (!tdma->coordinator) {
+            lora_read_bytes(ctx, &header[3], 1);
+            lora_tdma_on_beacon(tdma, lora_packet_timestamp(ctx), (uint16_t)(header[2] | (header[3] << 8)));
+        }
+        return 0;
+    }
+
+    if (header[0] == LORA_TDMA_DATA) {
+        tdma->rx_slot = header[2];
+        tdma->stats.frames_rx++;
+        return length - LORA_TDMA_DATA_HEADER;
+    }
+
+    return 0;
+}
+
+// The driver records TX done, and gives up on a lost one at the deadline
+// lora_end_packet_at armed
+static bool tx_busy(lora_tdma_t *tdma) {
+    if (!tdma->tx_active) {
+        return false;
+    }
+
+    if (lora_is_transmitting(tdma->lora)) {
+        return true;
+    }
+
+    tdma->tx_active = false;
+    return false;
+}
+
+static uint64_t superframe_local_us(const lora_tdma_t *tdma) {
+    return lora_tdma_to_local_us(tdma, tdma->config.superframe_us);
+}
@@ -0,0 +1,114 @@
+#ifndef LORA_TDMA_H
+#define LORA_TDMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lora.h"
+
+// Frame types (first header byte)
+#define LORA_TDMA_BEACON        0xb0
+#define LORA_TDMA_DATA          0xd0
+
+// Header lengths
+#define LORA_TDMA_BEACON_LENGTH 4   // type, network, seq (LE16)
+#define LORA_TDMA_DATA_HEADER   3   // type, network, slot
+
+// Maximum payload per slot
+#define LORA_TDMA_MAX_PAYLOAD   (MAX_PKT_LENGTH - LORA_TDMA_DATA_HEADER)
+
+// Slot role for the coordinator
+#define LORA_TDMA_COORDINATOR   (-1)
+
+// Wake this long before a scheduled TX to load the FIFO
+#ifndef LORA_TDMA_LEAD_US
+#define LORA_TDMA_LEAD_US       3000
+#endif
+
+// Beacons a node may miss before it drops sync
+#ifndef LORA_TDMA_MAX_MISSED
+#define LORA_TDMA_MAX_MISSED    3
+#endif
+
+// Residual drift assumed once the drift has been measured
+#ifndef LORA_TDMA_DRIFT_MARGIN_PPM
+#define LORA_TDMA_DRIFT_MARGIN_PPM 2
+#endif
+
+// TDMA configuration, identical on every node of a network
+typedef struct {
+    uint32_t superframe_us;     // Beacon period
+    uint8_t slot_count;
+    uint8_t max_payload;        // Largest payload sent in a slot
+    uint32_t min_guard_us;      // Fixed guard for timer and turnaround jitter
+    uint16_t max_drift_ppm;     // Clock tolerance before drift is measured
+    uint8_t network_id;
+} lora_tdma_config_t;
+
+// TDMA statistics
+typedef struct {
+    uint32_t beacons_tx;
+    uint32_t beacons_rx;
+    uint32_t beacons_missed;
+    uint32_t sync_lost;
+    uint32_t frames_tx;
+    uint32_t frames_rx;
+    uint32_t slots_skipped;     // TX skipped because timing error exceeded the guard
+} lora_tdma_stats_t;
+
+// TDMA context
+typedef struct {
+    lora_ctx_t *lora;
+    lora_tdma_config_t config;
+    bool coordinator;
+    uint8_t slot;
+
+    // Slot layout in coordinator time, derived from time on air
+    uint32_t beacon_airtime_us;
+    uint32_t slot_airtime_us;
+    uint32_t guard_us;          // Worst-case guard either side of a slot
+    uint32_t slot_us;
+
+    // Clock discipline
+    bool synced;
+    bool drift_valid;
+    uint64_t epoch_us;          // Local time of the current superframe start
+    uint64_t sync_epoch_us;     // Epoch of the last received beacon
+    uint16_t beacon_seq;
+    uint16_t sync_seq;
+    int32_t drift_ppb;          // Local clock rate relative to the coordinator
+    uint32_t jitter_us;         // Smoothed beacon arrival prediction error
+    uint8_t missed;
+
+    // Pending transmission
+    bool tx_pending;
+    bool tx_active;
+    uint8_t tx_length;
+    uint8_t tx_buffer[LORA_TDMA_MAX_PAYLOAD];
+
+    // Last received data frame
+    uint8_t rx_slot;
+
+    lora_tdma_stats_t stats;
+} lora_tdma_t;
+
+// Start as coordinator (slot == LORA_TDMA_COORDINATOR) or as a node owning slot
+bool lora_tdma_begin(lora_tdma_t *tdma, lora_ctx_t *ctx, const lora_tdma_config_t *config, int slot);
+
+// Drive beacons, slot transmissions and beacon windows; call often.
+// Returns the payload length when a data frame was received; the payload
+// is read with lora_read()/lora_read_bytes().
+int lora_tdma_poll(lora_tdma_t *tdma);
+
+// Queue a frame for the next owned slot
+bool lora_tdma_send(lora_tdma_t *tdma, const uint8_t *buffer, uint8_t size);
+
+// Slot the last data frame was sent in
+uint8_t lora_tdma_rx_slot(const lora_tdma_t *tdma);
+
+// Clock discipline (hardware independent)
+void lora_tdma_on_beacon(lora_tdma_t *tdma, uint64_t rx_done_us, uint16_t seq);
+uint32_t lora_tdma_required_guard_us(const lora_tdma_t *tdma, uint64_t elapsed_us);
+uint64_t lora_tdma_to_local_us(const lora_tdma_t *tdma, uint64_t coordinator_us);
+uint64_t lora_tdma_slot_tx_us(const lora_tdma_t *tdma, uint64_t epoch_us, uint8_t slot);
+
+#endif // LORA_TDMA_H
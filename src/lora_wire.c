@@ -0,0 +1,56 @@
+#include "lora_wire.h"
+
+size_t lora_wire_encode(const uint8_t *in, size_t length, uint8_t *out) {
+    size_t code_index = 0;
+    size_t out_index = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < length; i++) {
+        if (in[i] != 0) {
+            out[out_index++] = in[i];
+            code++;
+        }
+        if (in[i] == 0 || code == 0xff) {
+            // Close the block; a full block needs no implied zero
+            out[code_index] = code;
+            code_index = out_index++;
+            code = 1;
+        }
+    }
+    out[code_index] = code;
+    return out_index;
+}
+
+int lora_wire_decode(const uint8_t *in, size_t length, uint8_t *out) {
+    size_t in_index = 0;
+    size_t out_index = 0;
+
+    while (in_index < length) {
+        uint8_t code = in[in_index++];
+        if (code == 0 || in_index + code - 1 > length) {
+            return -1;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            if (in[in_index] == 0) {
+                return -1;
+            }
+            out[out_index++] = in[in_index++];
+        }
+        if (code != 0xff && in_index < length) {
+            out[out_index++] = 0;
+        }
+    }
+    return (int)out_index;
+}
+
+uint16_t lora_wire_crc16(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xffff;
+
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,27 @@
+#ifndef LORA_WIRE_H
+#define LORA_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// COBS framing and CRC-16 for binary host links. Hardware independent so
+// host tools can link it on its own.
+
+// Frame delimiter; never appears inside an encoded frame
+#define LORA_WIRE_DELIMITER         0x00
+
+// Worst-case encoded size of n bytes, without the delimiter
+#define LORA_WIRE_ENCODED_SIZE(n)   ((n) + (n) / 254 + 1)
+
+// Encode length bytes into out (LORA_WIRE_ENCODED_SIZE(length) bytes).
+// Returns the encoded length; no delimiter is appended.
+size_t lora_wire_encode(const uint8_t *in, size_t length, uint8_t *out);
+
+// Decode one frame without its delimiter. out may equal in. Returns the
+// decoded length, or -1 if the frame is malformed.
+int lora_wire_decode(const uint8_t *in, size_t length, uint8_t *out);
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xffff)
+uint16_t lora_wire_crc16(const uint8_t *data, size_t length);
+
+#endif // LORA_WIRE_H
@@ -3,9 +3,33 @@
 #include <math.h>
 #include <stdio.h>
 
+// Largest rendered integer: 64 binary digits plus sign
+#define PRINT_NUMBER_BUFFER (8 * sizeof(unsigned long long) + 1)
+
+// Fractional digits rendered by print_double; more is below double precision anyway
+#define PRINT_FLOAT_MAX_DIGITS 32
+
+// Bytes rendered per write_buffer call by print_hex_buffer
+#define PRINT_HEX_CHUNK 64
+
+// Two decimal digits per lookup
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
 // Private function declarations
-static size_t print_number(print_ctx_t *ctx, unsigned long n, uint8_t base);
-static size_t print_ull_number(print_ctx_t *ctx, unsigned long long n64, uint8_t base);
+static char *format_dec32(char *end, uint32_t n);
+static char *format_dec_padded(char *end, uint32_t n, int width);
+static char *format_number(char *end, unsigned long long n, uint8_t base);
+static size_t print_number(print_ctx_t *ctx, unsigned long long n, uint8_t base, bool negative);
 static size_t print_float(print_ctx_t *ctx, double number, int digits);
 
 // Stdout write functions
@@ -18,13 +42,9 @@ static size_t stdout_write_byte(print_ctx_t *ctx, uint8_t b) {
 }
 
 static size_t stdout_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size) {
-    size_t n = 0;
-    while (size--) {
-        if (putchar(*buffer++) == EOF) {
-            ctx->write_error = 1;
-            break;
-        }
-        n++;
+    size_t n = fwrite(buffer, 1, size, stdout);
+    if (n < size) {
+        ctx->write_error = 1;
     }
     return n;
 }
@@ -93,47 +113,57 @@ size_t print_uint(print_ctx_t *ctx, unsigned int n, int base) {
 size_t print_long(print_ctx_t *ctx, long n, int base) {
     if (base == 0) {
         return ctx->write_byte(ctx, (uint8_t)n);
-    } else if (base == 10) {
-        if (n < 0) {
-            size_t t = print_char(ctx, '-');
-            n = -n;
-            return print_number(ctx, n, 10) + t;
-        }
-        return print_number(ctx, n, 10);
+    } else if (base == 10 && n < 0) {
+        return print_number(ctx, 0UL - (unsigned long)n, 10, true);
     } else {
-        return print_number(ctx, n, base);
+        return print_number(ctx, (unsigned long)n, base, false);
     }
 }
 
 size_t print_ulong(print_ctx_t *ctx, unsigned long n, int base) {
     if (base == 0) return ctx->write_byte(ctx, (uint8_t)n);
-    else return print_number(ctx, n, base);
+    else return print_number(ctx, n, base, false);
 }
 
 size_t print_longlong(print_ctx_t *ctx, long long n, int base) {
     if (base == 0) {
         return ctx->write_byte(ctx, (uint8_t)n);
-    } else if (base == 10) {
-        if (n < 0) {
-            size_t t = print_char(ctx, '-');
-            n = -n;
-            return print_ull_number(ctx, n, 10) + t;
-        }
-        return print_ull_number(ctx, n, 10);
+    } else if (base == 10 && n < 0) {
+        return print_number(ctx, 0ULL - (unsigned long long)n, 10, true);
     } else {
-        return print_ull_number(ctx, n, base);
+        return print_number(ctx, (unsigned long long)n, base, false);
     }
 }
 
 size_t print_ulonglong(print_ctx_t *ctx, unsigned long long n, int base) {
     if (base == 0) return ctx->write_byte(ctx, (uint8_t)n);
-    else return print_ull_number(ctx, n, base);
+    else return print_number(ctx, n, base, false);
 }
 
 size_t print_double(print_ctx_t *ctx, double n, int digits) {
     return print_float(ctx, n, digits);
 }
 
+// Lowercase hex dump, rendered in chunks with one write per chunk
+size_t print_hex_buffer(print_ctx_t *ctx, const uint8_t *data, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    char buf[2 * PRINT_HEX_CHUNK];
+    size_t n = 0;
+
+    while (len > 0) {
+        size_t chunk = len < PRINT_HEX_CHUNK ? len : PRINT_HEX_CHUNK;
+        for (size_t i = 0; i < chunk; i++) {
+            buf[2 * i] = hex[data[i] >> 4];
+            buf[2 * i + 1] = hex[data[i] & 0x0f];
+        }
+        n += print_write_char_buffer(ctx, buf, 2 * chunk);
+        data += chunk;
+        len -= chunk;
+    }
+
+    return n;
+}
+
 // Println functions
 size_t println(print_ctx_t *ctx) {
     return print_write_str(ctx, "\r\n");
@@ -200,84 +230,110 @@ size_t println_double(print_ctx_t *ctx, double num, int digits) {
 }
 
 // Private functions
-static size_t print_number(print_ctx_t *ctx, unsigned long n, uint8_t base) {
-    char buf[8 * sizeof(long) + 1]; // Assumes 8-bit chars plus zero byte.
-    char *str = &buf[sizeof(buf) - 1];
 
-    *str = '\0';
+// Render n in decimal so that it ends just before end; returns the first digit
+static char *format_dec32(char *end, uint32_t n) {
+    while (n >= 100) {
+        uint32_t q = n / 100;
+        end -= 2;
+        memcpy(end, &digit_pairs[2 * (n - q * 100)], 2);
+        n = q;
+    }
 
-    // prevent crash if called with base == 1
-    if (base < 2) base = 10;
+    if (n >= 10) {
+        end -= 2;
+        memcpy(end, &digit_pairs[2 * n], 2);
+    } else {
+        *--end = (char)('0' + n);
+    }
 
-    do {
-        char c = n % base;
-        n /= base;
+    return end;
+}
 
-        *--str = c < 10 ? c + '0' : c + 'A' - 10;
-    } while(n);
+// Render n in decimal, zero padded to width digits
+static char *format_dec_padded(char *end, uint32_t n, int width) {
+    char *start = format_dec32(end, n);
 
-    return print_write_str(ctx, str);
-}
+    while (end - start < width) {
+        *--start = '0';
+    }
 
-static size_t print_ull_number(print_ctx_t *ctx, unsigned long long n64, uint8_t base) {
-    char buf[64];
-    uint8_t i = 0;
-    uint8_t innerLoops = 0;
+    return start;
+}
 
+static char *format_number(char *end, unsigned long long n, uint8_t base) {
     // prevent crash if called with base == 1
     if (base < 2) base = 10;
 
-    // process chunks that fit in "16 bit math"
-    uint16_t top = 0xFFFF / base;
-    uint16_t th16 = 1;
-    while (th16 < top) {
-        th16 *= base;
-        innerLoops++;
+    if (base == 10) {
+        // Peel off 8 digits at a time until the rest fits in 32 bit math
+        while (n > UINT32_MAX) {
+            unsigned long long q = n / 100000000;
+            end = format_dec_padded(end, (uint32_t)(n - q * 100000000), 8);
+            n = q;
+        }
+        return format_dec32(end, (uint32_t)n);
     }
 
-    while (n64 > th16) {
-        // 64 bit math part
-        uint64_t q = n64 / th16;
-        uint16_t r = n64 - q*th16;
-        n64 = q;
-
-        // 16 bit math loop to do remainder
-        for (uint8_t j=0; j < innerLoops; j++) {
-            uint16_t qq = r/base;
-            buf[i++] = r - qq*base;
-            r = qq;
+    if ((base & (base - 1)) == 0) {
+        // Power of two bases are shifts and masks
+        int shift = __builtin_ctz(base);
+        uint32_t mask = base - 1;
+
+        while (n > UINT32_MAX) {
+            uint32_t c = (uint32_t)n & mask;
+            *--end = c < 10 ? c + '0' : c + 'A' - 10;
+            n >>= shift;
         }
-    }
 
-    uint16_t n16 = n64;
-    while (n16 > 0) {
-        uint16_t qq = n16/base;
-        buf[i++] = n16 - qq*base;
-        n16 = qq;
+        uint32_t n32 = (uint32_t)n;
+        do {
+            uint32_t c = n32 & mask;
+            *--end = c < 10 ? c + '0' : c + 'A' - 10;
+            n32 >>= shift;
+        } while (n32);
+
+        return end;
     }
 
-    size_t bytes = i;
-    for (; i > 0; i--) {
-        char c = (buf[i - 1] < 10) ? ('0' + buf[i - 1]) : ('A' + buf[i - 1] - 10);
-        print_char(ctx, c);
+    do {
+        char c = n % base;
+        n /= base;
+
+        *--end = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return end;
+}
+
+static size_t print_number(print_ctx_t *ctx, unsigned long long n, uint8_t base, bool negative) {
+    char buf[PRINT_NUMBER_BUFFER];
+    char *end = &buf[sizeof(buf)];
+    char *str = format_number(end, n, base);
+
+    if (negative) {
+        *--str = '-';
     }
 
-    return bytes;
+    return print_write_char_buffer(ctx, str, end - str);
 }
 
 static size_t print_float(print_ctx_t *ctx, double number, int digits) {
     if (digits < 0) digits = 2;
-
-    size_t n = 0;
+    if (digits > PRINT_FLOAT_MAX_DIGITS) digits = PRINT_FLOAT_MAX_DIGITS;
 
     if (isnan(number)) return print_str(ctx, "nan");
     if (isinf(number)) return print_str(ctx, "inf");
     if (number > 4294967040.0) return print_str(ctx, "ovf");
     if (number < -4294967040.0) return print_str(ctx, "ovf");
 
+    // Sign, 10 integer digits, point and fraction
+    char buf[12 + PRINT_FLOAT_MAX_DIGITS];
+    char *str = buf;
+
     // Handle negative numbers
     if (number < 0.0) {
-        n += print_char(ctx, '-');
+        *str++ = '-';
         number = -number;
     }
 
@@ -288,23 +344,41 @@ static size_t print_float(print_ctx_t *ctx, double number, int digits) {
 
     number += rounding;
 
-    // Extract the integer part of the number and print it
+    // Extract the integer part of the number and render it
     unsigned long int_part = (unsigned long)number;
     double remainder = number - (double)int_part;
-    n += print_ulong(ctx, int_part, 10);
+    char digits_buf[10];
+    char *int_end = &digits_buf[sizeof(digits_buf)];
+    char *int_str = format_dec32(int_end, int_part);
+    memcpy(str, int_str, int_end - int_str);
+    str += int_end - int_str;
 
-    // Print the decimal point, but only if there are digits beyond
+    // Render the decimal point, but only if there are digits beyond
     if (digits > 0) {
-        n += print_char(ctx, '.');
+        *str++ = '.';
     }
 
-    // Extract digits from the remainder one at a time
-    while (digits-- > 0) {
-        remainder *= 10.0;
-        unsigned int toPrint = (unsigned int)remainder;
-        n += print_uint(ctx, toPrint, 10);
-        remainder -= toPrint;
+    if (digits <= 9) {
+        // The whole fraction fits in one 32 bit integer
+        uint32_t scale = 1;
+        for (int i = 0; i < digits; i++) scale *= 10;
+
+        uint32_t frac = (uint32_t)(remainder * scale);
+        if (frac >= scale) frac = scale - 1;
+
+        if (digits > 0) {
+            format_dec_padded(str + digits, frac, digits);
+            str += digits;
+        }
+    } else {
+        // Extract digits from the remainder one at a time
+        while (digits-- > 0) {
+            remainder *= 10.0;
+            unsigned int toPrint = (unsigned int)remainder;
+            *str++ = (char)('0' + toPrint);
+            remainder -= toPrint;
+        }
     }
 
-    return n;
-} 
\ No newline at end of file
+    return print_write_char_buffer(ctx, buf, str - buf);
+}
@@ -2,9 +2,14 @@
 #define PRINT_H
 
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Base number formats
 #define DEC 10
 #define HEX 16
@@ -44,6 +49,7 @@ size_t print_ulong(print_ctx_t *ctx, unsigned long n, int base);
 size_t print_longlong(print_ctx_t *ctx, long long n, int base);
 size_t print_ulonglong(print_ctx_t *ctx, unsigned long long n, int base);
 size_t print_double(print_ctx_t *ctx, double n, int digits);
+size_t print_hex_buffer(print_ctx_t *ctx, const uint8_t *data, size_t len);
 
 // Println functions
 size_t println(print_ctx_t *ctx);
@@ -58,4 +64,8 @@ size_t println_longlong(print_ctx_t *ctx, long long n, int base);
 size_t println_ulonglong(print_ctx_t *ctx, unsigned long long n, int base);
 size_t println_double(print_ctx_t *ctx, double n, int digits);
 
-#endif // PRINT_H 
\ No newline at end of file
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PRINT_H 
@@ -0,0 +1,103 @@
+#include "print_ring.h"
+
+// Private function declarations
+static size_t ring_write_byte(print_ctx_t *ctx, uint8_t b);
+static size_t ring_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size);
+static int ring_available(print_ctx_t *ctx);
+static void ring_flush(print_ctx_t *ctx);
+
+bool print_ring_init(print_ring_t *ring, uint8_t *buffer, size_t size) {
+    if (!buffer || size < 2 || (size & (size - 1)) != 0) {
+        return false;
+    }
+
+    print_init(&ring->print);
+    ring->print.write_byte = ring_write_byte;
+    ring->print.write_buffer = ring_write_buffer;
+    ring->print.available_for_write = ring_available;
+    ring->print.flush = ring_flush;
+
+    ring->buffer = buffer;
+    ring->mask = (uint32_t)size - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped_writes = 0;
+    ring->dropped_bytes = 0;
+    return true;
+}
+
+size_t print_ring_drain(print_ring_t *ring, print_ctx_t *sink, size_t max) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = ring->tail;
+    size_t drained = 0;
+
+    // At most two contiguous runs: up to the end of storage, then from the start
+    while (tail != head && drained < max) {
+        uint32_t start = tail & ring->mask;
+        size_t run = head - tail;
+        if (run > ring->mask + 1 - start) run = ring->mask + 1 - start;
+        if (run > max - drained) run = max - drained;
+
+        print_write_buffer(sink, &ring->buffer[start], run);
+        tail += run;
+        drained += run;
+    }
+
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    return drained;
+}
+
+// Status
+size_t print_ring_used(const print_ring_t *ring) {
+    return ring->head - ring->tail;
+}
+
+size_t print_ring_free(const print_ring_t *ring) {
+    return ring->mask + 1 - print_ring_used(ring);
+}
+
+uint32_t print_ring_dropped_writes(const print_ring_t *ring) {
+    return ring->dropped_writes;
+}
+
+uint32_t print_ring_dropped_bytes(const print_ring_t *ring) {
+    return ring->dropped_bytes;
+}
+
+void print_ring_clear_dropped(print_ring_t *ring) {
+    ring->dropped_writes = 0;
+    ring->dropped_bytes = 0;
+}
+
+// Private functions
+static size_t ring_write_byte(print_ctx_t *ctx, uint8_t b) {
+    return ring_write_buffer(ctx, &b, 1);
+}
+
+static size_t ring_write_buffer(print_ctx_t *ctx, const uint8_t *buffer, size_t size) {
+    print_ring_t *ring = (print_ring_t *)ctx;
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (size > ring->mask + 1 - (head - tail)) {
+        // Never block the caller; account for the loss instead
+        ring->dropped_writes++;
+        ring->dropped_bytes += size;
+        return 0;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        ring->buffer[(head + i) & ring->mask] = buffer[i];
+    }
+
+    __atomic_store_n(&ring->head, head + (uint32_t)size, __ATOMIC_RELEASE);
+    return size;
+}
+
+static int ring_available(print_ctx_t *ctx) {
+    return (int)print_ring_free((print_ring_t *)ctx);
+}
+
+static void ring_flush(print_ctx_t *ctx) {
+    // Draining is done by the consumer
+}
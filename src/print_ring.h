@@ -0,0 +1,35 @@
+#ifndef PRINT_RING_H
+#define PRINT_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "print.h"
+
+// Print backend that appends into a RAM ring and drains asynchronously.
+// Single producer (the code printing) and single consumer (the drain
+// loop, e.g. on core1); neither side takes a lock. A write that does not
+// fit is dropped whole so log lines are never torn.
+typedef struct {
+    print_ctx_t print;              // Must be first: pass &ring->print as the print_ctx_t
+    uint8_t *buffer;
+    uint32_t mask;                  // Size - 1, size is a power of two
+    volatile uint32_t head;         // Advanced by the producer
+    volatile uint32_t tail;         // Advanced by the consumer
+    volatile uint32_t dropped_writes;
+    volatile uint32_t dropped_bytes;
+} print_ring_t;
+
+// Initialize with caller-provided storage; size must be a power of two
+bool print_ring_init(print_ring_t *ring, uint8_t *buffer, size_t size);
+
+// Move up to max bytes into sink; returns the number of bytes drained
+size_t print_ring_drain(print_ring_t *ring, print_ctx_t *sink, size_t max);
+
+// Status
+size_t print_ring_used(const print_ring_t *ring);
+size_t print_ring_free(const print_ring_t *ring);
+uint32_t print_ring_dropped_writes(const print_ring_t *ring);
+uint32_t print_ring_dropped_bytes(const print_ring_t *ring);
+void print_ring_clear_dropped(print_ring_t *ring);
+
+#endif // PRINT_RING_H